@@ -0,0 +1,286 @@
+#include "FoldedLiteralMatcher.h"
+#include "LiteralMatcher.h"
+#include "RegexParser.h"
+#include "SearchKernel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <istream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Micro-benchmark: throughput of LiteralMatcher versus std::string_view::find
+// over synthetic log text, for needle lengths 1-256 and a needle family per
+// search strategy (the algorithm column shows the one chosen). The needle is
+// absent from the text, so every byte of the haystack has to be examined or
+// skipped.
+// A last section compares case-insensitive search by lowercasing a copy of
+// every line with std::tolower against FoldedLiteralMatcher, and the last
+// one the full scan loop counting lines, building Match objects, writing
+// only the hits (--only-matching), and counting non-matching lines (-v).
+// The regex section counts matching lines with std::regex, the bit-parallel
+// engine and the Pike VM, over a shorter text as std::regex is slow.
+
+namespace
+{
+
+std::string makeHaystack(size_t size)
+{
+    static const std::vector<std::string> words =
+    {
+        "the", "request", "failed", "with", "status", "error", "at", "line",
+        "connection", "timeout", "retrying", "user", "id", "=", "INFO", "WARN",
+        "com.example.service", "handler", "0x7ffd", "2026-10-16", "12:34:56",
+        "null", "exception", "in", "thread", "main", "{", "}", "(", ")"
+    };
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, words.size() - 1);
+
+    std::string text;
+    text.reserve(size + 64);
+    size_t column = 0;
+    while (text.size() < size)
+    {
+        const auto& w = words[pick(rng)];
+        text += w;
+        column += w.size() + 1;
+        if (column > 100)
+        {
+            text += '\n';
+            column = 0;
+        }
+        else
+        {
+            text += ' ';
+        }
+    }
+    return text;
+}
+
+template <typename Fn>
+double measureGBps(std::string_view haystack, Fn&& fn)
+{
+    constexpr int kRounds = 20;
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; ++i)
+    {
+        sink += fn(haystack);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (sink == 42)
+    {
+        std::puts(""); // keep the result observable
+    }
+    return static_cast<double>(haystack.size()) * kRounds / elapsed.count() / 1e9;
+}
+
+// Stream over text already in memory, so scans measure the kernel, not copies
+struct MemoryBuffer : std::streambuf
+{
+    explicit MemoryBuffer(std::string_view text)
+    {
+        char* begin = const_cast<char*>(text.data());
+        setg(begin, begin, begin + text.size());
+    }
+};
+
+const char* algorithmName(cgrep::LiteralMatcher::Algorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case cgrep::LiteralMatcher::Algorithm::RareBytes:
+            return "rare-bytes";
+        case cgrep::LiteralMatcher::Algorithm::Horspool:
+            return "horspool";
+        case cgrep::LiteralMatcher::Algorithm::TwoWay:
+            return "two-way";
+        case cgrep::LiteralMatcher::Algorithm::Direct:
+            break;
+    }
+    return "direct";
+}
+
+} // namespace
+
+int main()
+{
+    const std::string haystack = makeHaystack(32u << 20);
+    std::printf("%-8s %-11s %14s %14s\n", "length", "algorithm", "find GB/s", "matcher GB/s");
+
+    // One needle family per search strategy: needles ending in a rare byte,
+    // needles of the most common bytes only (space, '/', '_' and the letters
+    // of "aceilnoprst"), which stall a rare-byte scan and run Horspool from
+    // kSkipSearchMinLength bytes on, and needles of four distinct bytes,
+    // which run Two-Way from there. Each needle is a prefix of the family's
+    // text that never occurs verbatim in the haystack.
+    struct NeedleFamily
+    {
+        const char* title;
+        std::string text;
+        size_t      minLength = 1;
+        bool        rareTail = false; // the last byte of each needle becomes '#'
+    };
+    std::string commonOnly;
+    while (commonOnly.size() < 256)
+    {
+        commonOnly += "pastel stations list a sparse pattern/critical_process entrance ";
+    }
+    std::string lowAlphabet;
+    while (lowAlphabet.size() < 256)
+    {
+        lowAlphabet += "0x7f";
+    }
+    const NeedleFamily families[] =
+    {
+        { "-- needle ending in a rare byte", "exception in thread worker-" + std::string(256, 'q'), 1, true },
+        // every single letter occurs right away
+        { "-- needle of common bytes only", commonOnly, 2 },
+        // shorter prefixes of "0x7f0x7f..." occur in the haystack
+        { "-- needle of four distinct bytes", lowAlphabet, 16 },
+    };
+
+    for (const auto& family : families)
+    {
+        std::printf("%s\n", family.title);
+        for (size_t length : { 1u, 2u, 4u, 8u, 12u, 16u, 24u, 32u, 48u, 64u, 128u, 256u })
+        {
+            if (length < family.minLength)
+            {
+                continue;
+            }
+
+            std::string needle = family.text.substr(0, length);
+            if (family.rareTail)
+            {
+                needle.back() = '#';
+            }
+
+            cgrep::LiteralMatcher matcher(needle);
+            double baseline = measureGBps(haystack, [&](std::string_view hay) { return hay.find(needle); });
+            double candidate = measureGBps(haystack, [&](std::string_view hay) { return matcher.find(hay); });
+            std::printf("%-8zu %-11s %14.2f %14.2f\n", length, algorithmName(matcher.algorithm()),
+                        baseline, candidate);
+        }
+    }
+    std::printf("-- case-insensitive, per line: tolower copy + find vs FoldedLiteralMatcher\n");
+    std::vector<std::string_view> lines;
+    for (size_t start = 0; start < haystack.size();)
+    {
+        size_t end = std::min(haystack.find('\n', start), haystack.size());
+        lines.emplace_back(haystack.data() + start, end - start);
+        start = end + 1;
+    }
+    for (std::string needle : { "Exception In Thread#", "Ошибка" })
+    {
+        std::string lowerNeedle = needle;
+        std::transform(lowerNeedle.begin(), lowerNeedle.end(), lowerNeedle.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        cgrep::FoldedLiteralMatcher folded(needle);
+
+        std::string lowerLine;
+        double baseline = measureGBps(haystack, [&](std::string_view)
+        {
+            size_t hits = 0;
+            for (auto line : lines)
+            {
+                lowerLine.assign(line);
+                std::transform(lowerLine.begin(), lowerLine.end(), lowerLine.begin(),
+                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                hits += lowerLine.find(lowerNeedle) != std::string::npos;
+            }
+            return hits;
+        });
+        double candidate = measureGBps(haystack, [&](std::string_view)
+        {
+            size_t hits = 0;
+            size_t length = 0;
+            for (auto line : lines)
+            {
+                hits += folded.find(line, 0, length) != std::string::npos;
+            }
+            return hits;
+        });
+        std::printf("%-20s %-11s %14.2f %14.2f\n", needle.c_str(),
+                    folded.usesAsciiFastPath() ? "ascii" : "unicode", baseline, candidate);
+    }
+
+    std::printf("-- scan loop GB/s: count lines, build Match objects, only-matching output, count inverted\n");
+    const std::filesystem::path path = "bench.log";
+    for (std::string needle : { "timeout", "0x7ffd handler" })
+    {
+        cgrep::LiteralPolicy policy{cgrep::LiteralMatcher(needle)};
+        cgrep::ScanBuffer buffer;
+        auto scan = [&](auto& lines)
+        {
+            MemoryBuffer memory(haystack);
+            std::istream in(&memory);
+            cgrep::scanStream(in, policy, lines, buffer);
+        };
+
+        double count = measureGBps(haystack, [&](std::string_view)
+        {
+            cgrep::CountLines lines;
+            scan(lines);
+            return lines.count;
+        });
+        double emit = measureGBps(haystack, [&](std::string_view)
+        {
+            cgrep::MatchList results;
+            cgrep::EmitLines lines{path, results};
+            scan(lines);
+            return results.size();
+        });
+        std::string out;
+        double only = measureGBps(haystack, [&](std::string_view)
+        {
+            out.clear();
+            cgrep::WriteHits lines{"bench.log", out};
+            scan(lines);
+            return lines.hits;
+        });
+        double inverted = measureGBps(haystack, [&](std::string_view)
+        {
+            cgrep::CountLines lines;
+            MemoryBuffer memory(haystack);
+            std::istream in(&memory);
+            cgrep::scanStreamInverted(in, policy, lines, buffer);
+            return lines.count;
+        });
+        std::printf("%-20s %14.2f %14.2f %14.2f %14.2f\n", needle.c_str(), count, emit, only, inverted);
+    }
+
+    std::printf("-- regex, count lines GB/s: std::regex, bit-parallel, Pike VM\n");
+    const std::string_view regexHaystack = std::string_view(haystack).substr(0, 4u << 20);
+    for (std::string pattern : { "[A-Z]{4}-[0-9]{4}", "time(out|d) [a-z]+", "0x[0-9a-f]+ handler",
+                                 "^2026-10-16 [0-9:]+ ", "\\w+ timeout retrying \\w+" })
+    {
+        cgrep::RegexPolicy stdPolicy{std::regex(pattern)};
+        const cgrep::RegexNode tree = *cgrep::parseRegex(pattern);
+        const cgrep::LinePrefix prefix = cgrep::findLinePrefix(tree);
+        const cgrep::LiteralPrefilter prefilter(cgrep::findRequiredLiteral(tree));
+        cgrep::BitParallelPolicy bitPolicy{*cgrep::BitParallelRegex::compile(tree), prefix, prefilter};
+        cgrep::PikeVMPolicy vmPolicy{*cgrep::PikeVM::compile(tree), 0, prefix, prefilter};
+        cgrep::ScanBuffer buffer;
+        auto countWith = [&](const auto& policy)
+        {
+            return measureGBps(regexHaystack, [&](std::string_view text)
+            {
+                cgrep::CountLines lines;
+                MemoryBuffer memory(text);
+                std::istream in(&memory);
+                cgrep::scanStream(in, policy, lines, buffer);
+                return lines.count;
+            });
+        };
+        double baseline = countWith(stdPolicy);
+        double bitParallel = countWith(bitPolicy);
+        double pike = countWith(vmPolicy);
+        std::printf("%-24s %10.2f %14.2f %14.2f\n", pattern.c_str(), baseline, bitParallel, pike);
+    }
+    return 0;
+}
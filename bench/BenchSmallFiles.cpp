@@ -0,0 +1,134 @@
+#include "SearchKernel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Benchmark: per-file cost of searching a corpus of small files (2-14 KiB of
+// source-like text, default 100000 files; pass the count, e.g. 1000000, as
+// the first argument). Compares the std::ifstream input searched line by
+// line with FileInput (fstat + one read(2)) searched as one block. The files
+// are written once to a temporary directory and stay in the page cache, so
+// this measures the per-file overhead, not the disk.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+// Matcher policy that hides that its hits stay in a line, so the scan
+// searches line by line as before block search
+struct LineByLine
+{
+    cgrep::LiteralPolicy policy;
+
+    size_t find(std::string_view text, size_t from, size_t& length, const cgrep::FindContext& context = {}) const
+    {
+        return policy.find(text, from, length, context);
+    }
+    size_t maxMatchLength() const { return policy.maxMatchLength(); }
+    bool hitsStayInLine() const { return false; }
+};
+
+std::vector<fs::path> makeCorpus(const fs::path& dir, size_t count)
+{
+    static const char* const kLines[] =
+    {
+        "#include <vector>", "namespace cgrep", "{", "}", "    return result;",
+        "    for (size_t i = 0; i < size; ++i)", "// Helper: compute the next state",
+        "    std::string_view text = line.substr(0, length);", "",
+        "    if (hit == std::string_view::npos)", "        ++count;"
+    };
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> pickLine(0, std::size(kLines) - 1);
+    std::uniform_int_distribution<size_t> pickSize(2048, 14336);
+
+    std::vector<fs::path> files;
+    files.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        fs::path subdir = dir / std::to_string(i / 1000);
+        if (i % 1000 == 0)
+        {
+            fs::create_directories(subdir);
+        }
+        std::string text;
+        size_t size = pickSize(rng);
+        while (text.size() < size)
+        {
+            text += kLines[pickLine(rng)];
+            text += '\n';
+        }
+        if (i % 100 == 0)
+        {
+            text += "    throw std::runtime_error(\"unreachable\");\n"; // 1% of the files match
+        }
+        files.push_back(subdir / (std::to_string(i) + ".cpp"));
+        std::ofstream(files.back(), std::ios::binary) << text;
+    }
+    return files;
+}
+
+template <typename Scan>
+void measure(const char* name, const std::vector<fs::path>& files, Scan&& scan)
+{
+    size_t matches = 0;
+    scan(files.front()); // warm up
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& file : files)
+    {
+        matches += scan(file);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-36s %10.2f us/file %12.0f files/s %8zu matches\n", name,
+                elapsed.count() * 1e6 / static_cast<double>(files.size()),
+                static_cast<double>(files.size()) / elapsed.count(), matches);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    if (count == 0)
+    {
+        std::fprintf(stderr, "Usage: bench_small_files [file count]\n");
+        return 1;
+    }
+    fs::path dir = fs::temp_directory_path() / "custom_grep_bench_small_files";
+    fs::remove_all(dir);
+    std::printf("writing %zu files...\n", count);
+    std::vector<fs::path> files = makeCorpus(dir, count);
+
+    cgrep::LiteralPolicy policy{cgrep::LiteralMatcher("unreachable")};
+    cgrep::ScanBuffer buffer;
+    measure("ifstream, line by line", files, [&](const fs::path& file)
+    {
+        std::ifstream in(file, std::ios::binary);
+        cgrep::CountLines lines;
+        cgrep::scanStream(in, LineByLine{policy}, lines, buffer);
+        return lines.count;
+    });
+    measure("ifstream, block search", files, [&](const fs::path& file)
+    {
+        std::ifstream in(file, std::ios::binary);
+        cgrep::CountLines lines;
+        cgrep::scanStream(in, policy, lines, buffer);
+        return lines.count;
+    });
+    measure("FileInput (one read), block search", files, [&](const fs::path& file)
+    {
+        cgrep::FileInput in(file);
+        cgrep::CountLines lines;
+        cgrep::scanStream(in, policy, lines, buffer);
+        return lines.count;
+    });
+
+    fs::remove_all(dir);
+    return 0;
+}
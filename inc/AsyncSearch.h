@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Match.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <stop_token>
+
+namespace cgrep
+{
+
+/// Progress of an AsyncSearch: the files searched so far out of all of
+/// them, and the matching lines found in those files.
+struct SearchProgress
+{
+    size_t filesSearched = 0;
+    size_t totalFiles = 0;
+    size_t matches = 0;
+};
+
+/// State shared by an AsyncSearch and the workers of its search: the stop
+/// request they check and the progress counters they advance.
+struct SearchControl
+{
+    std::stop_source    stop;
+    size_t              totalFiles = 0;
+    std::atomic<size_t> filesSearched{0};
+    std::atomic<size_t> matches{0};
+};
+
+/// Handle of a search started with CustomGrep::parallelSearchAsync, which
+/// runs on threads of its own while the caller goes on. Cancelling it,
+/// through cancel(), the stop_token it was started with or by destroying
+/// the handle, makes the workers stop: they check for a stop request before
+/// every file and before every buffer they read of a file, so an abandoned
+/// search gives its CPU back after at most one buffer per worker.
+class AsyncSearch
+{
+public:
+    AsyncSearch() = default;
+    /// Cancels the search and waits for its workers to finish.
+    ~AsyncSearch();
+    AsyncSearch(const AsyncSearch&) = delete;
+    AsyncSearch& operator=(const AsyncSearch&) = delete;
+    AsyncSearch(AsyncSearch&&) noexcept = default;
+    AsyncSearch& operator=(AsyncSearch&& other) noexcept;
+
+    /// Whether the handle refers to a search whose result was not taken yet.
+    [[nodiscard]] bool valid() const { return m_result.valid(); }
+
+    /// Wait for the search and return its matches, in file order. A
+    /// cancelled search returns the matches found until it stopped. Rethrows
+    /// what the search threw, e.g. std::invalid_argument for a rejected
+    /// query. Can be called once.
+    [[nodiscard]] MatchList get();
+
+    /// Wait until the search has finished.
+    void wait() const;
+    /// Wait for at most `timeout`; returns whether the search has finished.
+    [[nodiscard]] bool waitFor(std::chrono::milliseconds timeout) const;
+
+    /// A snapshot of the progress counters, updated after every file.
+    [[nodiscard]] SearchProgress progress() const;
+
+    /// Ask the workers to stop; returns at once.
+    void cancel();
+    [[nodiscard]] bool cancelRequested() const;
+
+private:
+    friend class CustomGrep;
+
+    // Forward a stop request of the caller's stop_token to the search
+    struct ForwardStop
+    {
+        std::stop_source stop;
+        void operator()() noexcept { stop.request_stop(); }
+    };
+
+    AsyncSearch(std::shared_ptr<SearchControl> control, const std::stop_token& stop);
+
+    std::shared_ptr<SearchControl>                   m_control;
+    std::unique_ptr<std::stop_callback<ForwardStop>> m_forward;
+    std::future<MatchList>                           m_result;
+};
+
+} // namespace cgrep
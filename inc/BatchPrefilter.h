@@ -0,0 +1,60 @@
+#pragma once
+
+#include "MultiLiteralMatcher.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// Picks, with one multi-literal pass over a file, the queries of a
+/// CustomGrep::searchBatch that may match in it. Each query is entered with
+/// a literal that every hit of it contains; a query without one is always
+/// picked. The literals of all queries share one MultiLiteralMatcher (one
+/// for the caseless ones), so a file that holds none of them costs a single
+/// scan however many queries there are.
+class BatchPrefilter
+{
+public:
+    /// Pick query `query` only for texts containing `literal`, with ASCII
+    /// letters compared caselessly if `asciiCaseInsensitive`. An empty
+    /// literal picks the query always.
+    void addLiteral(size_t query, std::string literal, bool asciiCaseInsensitive = false);
+    void addAlways(size_t query);
+
+    /// Prepare the search; call once all queries are added.
+    void build();
+
+    /// Set `selected[q]` to whether query q may match in `text`.
+    void select(std::string_view text, std::vector<bool>& selected) const;
+
+    /// One more than the largest query index added.
+    [[nodiscard]] size_t queryCount() const { return m_queryCount; }
+
+private:
+    // The distinct literals of one case mode, with the queries of each and
+    // the other literals that are prefixes of it: of the literals starting
+    // at a position the matcher only reports the longest.
+    struct Literals
+    {
+        std::vector<std::string>         patterns;
+        std::vector<std::vector<size_t>> queries;
+        std::vector<std::vector<size_t>> prefixes;
+        std::optional<MultiLiteralMatcher> matcher;
+    };
+
+    static void add(Literals& literals, size_t query, std::string literal);
+    static void build(Literals& literals, bool asciiCaseInsensitive);
+    static void select(const Literals& literals, std::string_view text, std::vector<bool>& selected);
+
+    Literals            m_exact;
+    Literals            m_caseless;
+    std::vector<size_t> m_always;
+    size_t              m_queryCount = 0;
+};
+
+} // namespace cgrep
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "RegexParser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// Regex search by bit-parallel simulation of the Glushkov automaton, for
+/// regexes of up to 64 positions (byte sets, counting bounded repeats once
+/// per copy). Each position is a bit of a 64-bit state word, so one step is
+/// a table lookup per state byte, an OR and an AND with the mask of the input
+/// byte; patterns that are a plain sequence of positions such as
+/// `[A-Z]{3}-[0-9]{4}` use the Shift-And step `(D << 1 | 1) & mask` instead.
+///
+/// Hits are leftmost-longest, as in POSIX and GNU grep, rather than the
+/// leftmost-first hits of std::regex; the two agree on which lines match.
+/// A leading ^ and a trailing $ are supported; other assertions are not.
+class BitParallelRegex
+{
+public:
+    static constexpr size_t kMaxPositions = 64;
+
+    /// Build the automaton for `root`, or std::nullopt if it has more than
+    /// kMaxPositions positions or assertions other than a leading ^ and a
+    /// trailing $.
+    [[nodiscard]] static std::optional<BitParallelRegex> compile(const RegexNode& root);
+
+    /// Return the position of the leftmost-longest hit in `text` starting at
+    /// or after `from` (or npos) and store its length in `length`. Past the
+    /// start of `text`, ^ does not match; with `lineContinues`, $ does not
+    /// match at the end of `text`.
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              bool lineContinues = false) const;
+
+    /// Upper bound on the length of a hit, or RegexNode::kUnbounded.
+    [[nodiscard]] size_t maxLength() const { return m_maxLength; }
+
+    /// Whether hits never contain a line break, so that several lines can be
+    /// searched as one text. Line texts hold no '\n', so it is left out of
+    /// every position and only the anchors tie a hit to a line.
+    [[nodiscard]] bool hitsStayInLine() const { return !m_startAnchored && !m_endAnchored; }
+
+    [[nodiscard]] size_t positions() const { return m_positions; }
+    [[nodiscard]] bool isShiftAnd() const { return m_shiftAnd; }
+
+private:
+    BitParallelRegex() = default;
+
+    // States reachable in one step from the positions in `states`
+    [[nodiscard]] uint64_t follow(uint64_t states) const
+    {
+        if (m_shiftAnd)
+        {
+            return states << 1;
+        }
+        uint64_t next = 0;
+        for (size_t chunk = 0; chunk < m_followChunks; ++chunk)
+        {
+            next |= m_followTable[chunk * 256 + ((states >> (chunk * 8)) & 0xFF)];
+        }
+        return next;
+    }
+
+    // Whether a hit may end at `position`
+    [[nodiscard]] bool endAllowed(std::string_view text, size_t position, bool lineContinues) const
+    {
+        return !m_endAnchored || (position == text.size() && !lineContinues);
+    }
+
+    // Find the leftmost-longest hit starting at or after `begin`, tracking the
+    // earliest start of every active position
+    [[nodiscard]] size_t findLeftmostLongest(std::string_view text, size_t begin, size_t& length,
+                                             bool lineContinues) const;
+
+    size_t   m_positions = 0;
+    uint64_t m_first = 0;
+    uint64_t m_last = 0;
+    bool     m_nullable = false;
+    bool     m_startAnchored = false;
+    bool     m_endAnchored = false;
+    bool     m_shiftAnd = false;
+    size_t   m_maxLength = 0;
+
+    // For each byte, the positions it matches
+    std::array<uint64_t, 256> m_masks{};
+    // Bytes that can start a hit, and the only one if there is just one
+    std::array<bool, 256> m_startBytes{};
+    int                   m_singleStartByte = -1;
+    // For each position, the positions that may follow it
+    std::array<uint64_t, kMaxPositions> m_follow{};
+    // Union of m_follow over the positions set in each byte of a state word:
+    // entry chunk * 256 + byte
+    std::vector<uint64_t> m_followTable;
+    size_t                m_followChunks = 0;
+};
+
+} // namespace cgrep
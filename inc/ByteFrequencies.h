@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace cgrep
+{
+
+/// Popularity rank of every byte value in typical source code and English text:
+/// 0 is the rarest byte, 255 the most common one (the space character).
+/// Derived from byte counts over C/C++ headers, Python sources and plain-text
+/// documentation. Used to pick the needle bytes least likely to produce
+/// false candidates while scanning.
+inline constexpr std::array<uint8_t, 256> kByteFrequencyRank =
+{
+     66,  65,  64,  63,  62,  61,  60,  59,  58, 183, 241,  57, 139, 150,  56,  55, // 0x00
+     54,  53,  52,  51,  50,  49,  48,  47,  46,  45,  44,  43,  42,  41,  40,  39, // 0x10
+    255, 170, 178, 198, 159, 162, 189, 169, 225, 226, 219, 173, 234, 209, 231, 248, // 0x20
+    222, 223, 211, 202, 196, 197, 192, 188, 191, 194, 232, 206, 207, 201, 208, 161, // 0x30
+    168, 221, 203, 216, 204, 227, 199, 195, 182, 220, 174, 180, 214, 200, 213, 224, // 0x40
+    215, 167, 212, 230, 229, 193, 186, 175, 190, 179, 165, 172, 176, 171, 158, 244, // 0x50
+    164, 249, 237, 242, 240, 254, 235, 228, 236, 251, 177, 210, 243, 239, 247, 250, // 0x60
+    245, 187, 246, 252, 253, 238, 217, 205, 218, 233, 181, 185, 166, 184, 163,  38, // 0x70
+    152, 113, 142, 126, 146, 101,  97,  99, 131, 119,  74,  92,  89, 110,  88,  81, // 0x80
+     93,  91,  96, 103, 145,  87,  83,  77, 135, 144,  68, 102, 128, 129, 100, 138, // 0x90
+    109, 133, 122, 143, 151, 106,  75, 112,  95, 156,  86, 121,  94, 149, 105,  80, // 0xA0
+    114, 157, 120, 147, 124, 130, 153,  73, 132,  82, 127, 116, 140, 141, 108, 137, // 0xB0
+     37,  36, 155, 160, 125, 148,  35,  34,  79,  33,  32,  31,  90,  30, 107, 117, // 0xC0
+    134, 115,  29,  28,  27,  26,  25, 111,  24,  23,  22,  21,  20,  19,  18,  17, // 0xD0
+    123, 118, 154,  16,  85, 104,  67,  84,  15,  98,  72,  14,  13,  12,  11, 136, // 0xE0
+     78,  10,   9,  71,  70,   8,  69,   7,   6,   5,   4,   3,   2,  76,   1,   0, // 0xF0
+};
+
+} // namespace cgrep
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// Code points at or above this value stand for single bytes that are not
+/// part of a valid UTF-8 sequence (kInvalidByteBase + byte), so malformed
+/// input still compares equal to itself and to nothing else.
+inline constexpr char32_t kInvalidByteBase = 0x110000;
+
+/// Fold an ASCII byte to lowercase; every other byte is returned unchanged.
+/// Branch-free so loops over whole buffers vectorize.
+[[nodiscard]] inline unsigned char foldAscii(unsigned char c)
+{
+    return static_cast<unsigned char>(c + ((static_cast<unsigned char>(c - 'A') < 26u) << 5));
+}
+
+/// Compare `n` haystack bytes with an already lowercased needle, folding the
+/// ASCII letters of the haystack on the fly.
+[[nodiscard]] inline bool equalsAsciiFolded(const unsigned char* hay, const unsigned char* needle, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (foldAscii(hay[i]) != needle[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Simple (one-to-one) Unicode case folding of a single code point, i.e. the
+/// C and S mappings of CaseFolding.txt (Unicode 14).
+[[nodiscard]] char32_t foldCodePoint(char32_t cp);
+
+/// Decode the UTF-8 sequence starting at `pos` (which must be < text.size())
+/// and store its length in bytes in `length`. Malformed or truncated
+/// sequences decode one byte at a time as kInvalidByteBase + byte.
+[[nodiscard]] char32_t decodeUtf8(std::string_view text, size_t pos, size_t& length);
+
+/// Append the UTF-8 encoding of `cp` (or the raw byte it stands for) to `out`.
+void appendUtf8(std::string& out, char32_t cp);
+
+/// Decode and case fold a whole UTF-8 string.
+[[nodiscard]] std::u32string foldUtf8(std::string_view text);
+
+/// Every code point whose simple case folding is `folded`, including
+/// `folded` itself (e.g. 'k' gives 'k', 'K' and U+212A KELVIN SIGN).
+[[nodiscard]] std::vector<char32_t> caseVariants(char32_t folded);
+
+} // namespace cgrep
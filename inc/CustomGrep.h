@@ -1,25 +1,113 @@
 #pragma once
 
+#include "AsyncSearch.h"
+#include "FileTable.h"
+#include "Generator.h"
+#include "Match.h"
+#include "MatchChannel.h"
+#include "SearchKernel.h"
+
+#include <chrono>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <stop_token>
 #include <string>
 #include <vector>
 
 namespace cgrep
 {
 
-/// Represents a single match of `query` inside `path` at line `line_number`.
-/// `line` holds the contents of that line (without the trailing newline).
-struct Match
+/// Default memory budget for the matches buffered by a streaming parallelSearch.
+inline constexpr size_t kDefaultResultMemoryBudget = size_t{256} << 20;
+
+/// Default number of matches a parallelSearchLazy buffers ahead of its consumer.
+inline constexpr size_t kDefaultBufferedMatches = 4096;
+
+/// Files up to this size are read into memory once by searchBatch; larger
+/// ones are read again for every query.
+inline constexpr size_t kBatchFileLimit = size_t{64} << 20;
+
+/// Options of a CustomGrep search.
+struct SearchOptions
 {
-    std::filesystem::path path;
-    size_t               line_number;
-    std::string          line;
+    bool   ignoreCase = false;  // perform case-insensitive search if true
+    bool   regexSearch = false; // use regex search if true
+    bool   invertMatch = false; // select the lines without a hit (grep -v); parallelOnlyMatching writes none
+    bool   wordRegexp = false;  // only count hits that form whole words (grep -w)
+    bool   lineRegexp = false;  // only count hits that form the whole line (grep -x); wins over wordRegexp
+
+    /// With regexSearch, the grammar of the query: ECMAScript (the default,
+    /// grep -P), POSIX ERE (grep -E) or POSIX BRE (grep -G).
+    RegexSyntax syntax = RegexSyntax::ECMAScript;
+
+    /// With regexSearch, make the hits the spans of this capture group
+    /// instead of the whole regex hits (0), e.g. for --only-matching. Such
+    /// queries run on the Pike VM (see PikeVM.h).
+    size_t captureGroup = 0;
+
+    /// Matching lines longer than this are reported cut to this many bytes
+    /// (see Match::truncated).
+    size_t maxLineLength = kDefaultMaxLineLength;
+
+    /// Bytes each worker reads and searches at a time; this bounds the memory
+    /// used per worker. Longer lines are searched in overlapping windows.
+    size_t bufferSize = kDefaultBufferSize;
+
+    /// Budget for searching one file: steps of the regex engine (one per
+    /// character it moves over) and wall time; zero means unlimited. A file
+    /// that exceeds it is reported on stderr and the rest of it skipped, so a
+    /// pathological file cannot stall a parallel search.
+    size_t                    fileStepBudget = 0;
+    std::chrono::milliseconds fileTimeBudget{0};
+
+    /// Bytes the workers of a streaming parallelSearch may hold in matches,
+    /// shared evenly between them; zero means unlimited. A worker over its
+    /// share spills its matches to a temporary file (see MatchSpill.h).
+    size_t resultMemoryBudget = kDefaultResultMemoryBudget;
+};
+
+/// One query of CustomGrep::searchBatch, with the options that may differ
+/// between the queries of a batch; the other SearchOptions apply to all.
+struct BatchQuery
+{
+    std::string pattern;
+    bool        regexSearch = false;
+    bool        ignoreCase = false;
+};
+
+/// A query compiled once by CustomGrep::compile, holding the matcher
+/// selected for it with everything derived from the query: the literal or
+/// folded needle, the compiled regex and its prefilters. It is immutable and
+/// cheap to copy, and may be searched with from several threads at once,
+/// through any CustomGrep whose options match the same way as those of the
+/// one that compiled it.
+class CompiledQuery
+{
+public:
+    [[nodiscard]] const std::string& pattern() const { return m_pattern; }
+    [[nodiscard]] const QueryMatcher& matcher() const { return *m_matcher; }
+
+    /// Whether searching with `options` finds the same hits as with the
+    /// options the query was compiled for.
+    [[nodiscard]] bool matchesLike(const SearchOptions& options) const;
+
+private:
+    friend class CustomGrep;
+
+    CompiledQuery(std::string pattern, QueryMatcher matcher, const SearchOptions& options);
+
+    std::string                         m_pattern;
+    std::shared_ptr<const QueryMatcher> m_matcher;
+    SearchOptions                       m_options;
 };
 
 class CustomGrep
 {
 public:
     explicit CustomGrep(bool ignoreCase = false, bool regexSearch = false);
+    explicit CustomGrep(const SearchOptions& options);
     ~CustomGrep() = default;
     CustomGrep(const CustomGrep&) = default;
     CustomGrep& operator=(const CustomGrep&) = default;
@@ -27,32 +115,185 @@ public:
     CustomGrep& operator=(CustomGrep&&) noexcept = default;
 
     /// Perform the parallel search using the number of threads set in the constructor.
-    /// Each thread processes a contiguous subrange of `all_files` and calls `searchInFile`.
-    [[nodiscard]] std::vector<Match> parallelSearch(const std::vector<std::filesystem::path>& all_files,
+    /// Each thread processes a contiguous subrange of `all_files` into a MatchList
+    /// of its own; the lists are spliced together in file order.
+    /// Every parallel search takes the files either as paths or as a FileTable,
+    /// whose paths are rebuilt by the worker searching each file.
+    [[nodiscard]] MatchList parallelSearch(const std::vector<std::filesystem::path>& all_files,
                                       const std::string& query) const;
+    [[nodiscard]] MatchList parallelSearch(const FileTable& all_files, const std::string& query) const;
+
+    /// Compile `query` for the options of this CustomGrep, to search for it
+    /// repeatedly without deriving the matcher again (see also
+    /// SearchSession.h). Throws std::invalid_argument for a query the
+    /// searches would reject.
+    [[nodiscard]] CompiledQuery compile(const std::string& query) const;
+
+    /// The searches for a compiled query. They throw std::invalid_argument
+    /// if it was compiled for options that match differently from ours.
+    [[nodiscard]] MatchList parallelSearch(const std::vector<std::filesystem::path>& all_files,
+                                           const CompiledQuery& query) const;
+    [[nodiscard]] MatchList parallelSearch(const FileTable& all_files, const CompiledQuery& query) const;
+    [[nodiscard]] MatchList searchInFile(const std::filesystem::path& filePath, const CompiledQuery& query) const;
+    [[nodiscard]] size_t countInFile(const std::filesystem::path& filePath, const CompiledQuery& query) const;
+
+    /// Start a parallelSearch on threads of its own and return at once with
+    /// a handle to wait for its result, follow its progress or cancel it
+    /// (see AsyncSearch.h). The search works on its own copy of the files,
+    /// the query and the options. A stop request on `stop` cancels it too.
+    [[nodiscard]] AsyncSearch parallelSearchAsync(std::vector<std::filesystem::path> all_files,
+                                                  std::string query,
+                                                  std::stop_token stop = {}) const;
+    [[nodiscard]] AsyncSearch parallelSearchAsync(FileTable all_files, std::string query,
+                                                  std::stop_token stop = {}) const;
+
+    /// Like parallelSearch, but yield the matches as the search finds them.
+    /// The search runs on threads of its own from the first begin(), on its
+    /// own copy of the files, the query and the options; workers that get
+    /// about `bufferedMatches` matches ahead of the consumer wait for it.
+    /// The matches of a file come in line order, but those of files searched
+    /// by different workers interleave. The path, line and spans of a yielded
+    /// Match view the generator's buffers and are only valid until the next
+    /// increment; copy what must outlive it. Destroying the generator stops
+    /// the search, even before all matches were pulled. begin() throws what
+    /// parallelSearch would for the query.
+    [[nodiscard]] Generator<Match> parallelSearchLazy(std::vector<std::filesystem::path> all_files,
+                                                      std::string query,
+                                                      size_t bufferedMatches = kDefaultBufferedMatches) const;
+    [[nodiscard]] Generator<Match> parallelSearchLazy(FileTable all_files, std::string query,
+                                                      size_t bufferedMatches = kDefaultBufferedMatches) const;
+
+    /// Like parallelSearch, but hand the matches to `sink` in file order
+    /// once all files are searched, instead of returning them. The matches
+    /// buffered meanwhile stay within SearchOptions::resultMemoryBudget, so
+    /// memory use does not grow with the number of matches. A match only
+    /// lives during the call. Returns the number of matches.
+    size_t parallelSearch(const std::vector<std::filesystem::path>& all_files,
+                          const std::string& query,
+                          const std::function<void(const Match&)>& sink) const;
+    size_t parallelSearch(const FileTable& all_files, const std::string& query,
+                          const std::function<void(const Match&)>& sink) const;
+
+    /// Search for all of `queries` in one parallel pass over the files: a file
+    /// is read once and searched for each query that may match in it, as
+    /// told by one multi-literal scan for the literals the queries' hits must
+    /// contain (see BatchPrefilter.h). Every match is tagged with the index
+    /// of its query in Match::query_id; the matches come in file order, and
+    /// within a file by line, then query. All queries are compiled before
+    /// the search, so one that is rejected throws std::invalid_argument.
+    [[nodiscard]] MatchList searchBatch(const std::vector<std::filesystem::path>& all_files,
+                                        const std::vector<BatchQuery>& queries) const;
+    [[nodiscard]] MatchList searchBatch(const FileTable& all_files, const std::vector<BatchQuery>& queries) const;
+
+    /// Like parallelSearch, but only count the matching lines of every file.
+    /// Element i of the result is the count for `all_files[i]`.
+    [[nodiscard]] std::vector<size_t> parallelCount(const std::vector<std::filesystem::path>& all_files,
+                                      const std::string& query) const;
+    [[nodiscard]] std::vector<size_t> parallelCount(const FileTable& all_files, const std::string& query) const;
+
+    /// Like parallelSearch, but write only the hits, one `path:line_number:hit`
+    /// line each, to `out` (grep -o). Hits are copied straight from the scan
+    /// buffers into per-thread output buffers, which are written out in file
+    /// order. Returns the number of hits written; with invertMatch, as with
+    /// grep -o -v, there are none.
+    size_t parallelOnlyMatching(const std::vector<std::filesystem::path>& all_files,
+                                const std::string& query,
+                                std::ostream& out) const;
+    size_t parallelOnlyMatching(const FileTable& all_files, const std::string& query, std::ostream& out) const;
 
     /// Scan the entire file at `filePath` line by line, looking for `query`.
-    /// Returns a vector of Match for every line that contains `query`.
-    [[nodiscard]] std::vector<Match> searchInFile(const std::filesystem::path& filePath,
+    /// Returns a Match for every line that contains `query`.
+    [[nodiscard]] MatchList searchInFile(const std::filesystem::path& filePath,
                                             const std::string& query) const;
 
+    /// Count the lines of the file at `filePath` that contain `query`.
+    [[nodiscard]] size_t countInFile(const std::filesystem::path& filePath,
+                                     const std::string& query) const;
+
 private:
+    friend class SearchSession;
+
+    // Throw std::invalid_argument unless `query` matches like our options.
+    void checkCompiledFor(const CompiledQuery& query) const;
+
+    // The searches with a matcher compiled already, scanning with the given
+    // buffers (one per worker for the parallel searches)
+    [[nodiscard]] MatchList searchFilesWith(const std::vector<std::filesystem::path>& all_files,
+                                            const QueryMatcher& matcher, std::vector<ScanBuffer>* buffers) const;
+    [[nodiscard]] MatchList searchFilesWith(const FileTable& all_files, const QueryMatcher& matcher,
+                                            std::vector<ScanBuffer>* buffers) const;
+    size_t streamFilesWith(const std::vector<std::filesystem::path>& all_files, const QueryMatcher& matcher,
+                           std::vector<ScanBuffer>* buffers, const std::function<void(const Match&)>& sink) const;
+    size_t streamFilesWith(const FileTable& all_files, const QueryMatcher& matcher,
+                           std::vector<ScanBuffer>* buffers, const std::function<void(const Match&)>& sink) const;
+    [[nodiscard]] MatchList searchFileWith(const std::filesystem::path& filePath, const QueryMatcher& matcher,
+                                           ScanBuffer& buffer) const;
+    [[nodiscard]] size_t countFileWith(const std::filesystem::path& filePath, const QueryMatcher& matcher,
+                                       ScanBuffer& buffer) const;
+
+    // Hand the matching lines of a file, or of `data` reported as the file
+    // `name`, to `sink` straight from the scan buffer (see SearchSession)
+    size_t scanFileTo(const std::filesystem::path& filePath, const QueryMatcher& matcher, ScanBuffer& buffer,
+                      const std::function<bool(const Match&)>& sink) const;
+    size_t scanBufferTo(std::string_view data, const std::filesystem::path& name, const QueryMatcher& matcher,
+                        ScanBuffer& buffer, const std::function<bool(const Match&)>& sink) const;
+
+    // Select the matcher policy for `query` once; see SearchKernel.h.
+    // Throws std::invalid_argument for regexes that may backtrack exponentially.
+    [[nodiscard]] QueryMatcher compileQuery(const std::string& query) const;
+
+    // Open `filePath` and hand its matching lines to `lines`, using the
+    // calling worker's `buffer`; a stop request on `stop` ends the scan early.
+    template <typename LinePolicy>
+    void scanFile(const std::filesystem::path& filePath,
+                  const QueryMatcher& matcher,
+                  LinePolicy& lines,
+                  ScanBuffer& buffer,
+                  std::stop_token stop = {}) const;
+
+    // scanFile once the file is open, or for input read already
+    template <typename Input, typename LinePolicy>
+    void scanInput(Input& input,
+                   const std::filesystem::path& filePath,
+                   const QueryMatcher& matcher,
+                   LinePolicy& lines,
+                   ScanBuffer& buffer,
+                   std::stop_token stop = {}) const;
 
-    void regexSearch(const std::string& query,
-                     const std::filesystem::path& filePath,
-                     std::ifstream& ifs,
-                     std::vector<Match> &results) const;
+    // The parallel searches, for a file list of either kind. With `control`,
+    // collectMatches stops on its stop request and advances its counters;
+    // with `buffers`, its workers scan with (and keep) those buffers.
+    template <typename Files>
+    [[nodiscard]] MatchList collectMatches(const Files& all_files, const QueryMatcher& matcher,
+                                           SearchControl* control = nullptr,
+                                           std::vector<ScanBuffer>* buffers = nullptr) const;
+    template <typename Files>
+    [[nodiscard]] AsyncSearch startAsync(Files all_files, std::string query, std::stop_token stop) const;
+    template <typename Files>
+    static Generator<Match> generateMatches(CustomGrep grep, Files all_files, std::string query,
+                                            size_t bufferedMatches);
+    template <typename Files>
+    void feedMatches(const Files& all_files, const QueryMatcher& matcher, MatchChannel& channel,
+                     size_t batchSize, const std::stop_token& stop) const;
+    template <typename Files>
+    size_t streamMatches(const Files& all_files, const QueryMatcher& matcher,
+                         const std::function<void(const Match&)>& sink,
+                         std::vector<ScanBuffer>* buffers = nullptr) const;
+    template <typename Files>
+    [[nodiscard]] MatchList collectBatch(const Files& all_files, const std::vector<BatchQuery>& queries) const;
+    template <typename Files>
+    [[nodiscard]] std::vector<size_t> countMatches(const Files& all_files, const std::string& query) const;
+    template <typename Files>
+    size_t writeHits(const Files& all_files, const std::string& query, std::ostream& out) const;
 
-    void regularSearch(const std::string& query,
-                      const std::filesystem::path& filePath,
-                      std::ifstream& ifs,
-                      std::vector<Match> &results) const;
+    // Run `worker(thread_index, start, end)` over contiguous chunks of [0, total) in parallel.
+    template <typename Worker>
+    void runChunked(size_t total, Worker&& worker) const;
 
     // Number of worker threads to use. Determined in the constructor using
     // std::thread::hardware_concurrency() with a minimum of one.
     size_t m_threadCount = 1u;
-    bool m_ignoreCase = false; // perform case-insensitive search if true
-    bool m_regexSearch = false; // use regex search if true
+    SearchOptions m_options;
 };
 
 } // namespace cgrep
@@ -0,0 +1,123 @@
+#ifndef CUSTOM_GREP_C_H
+#define CUSTOM_GREP_C_H
+
+/*
+ * C API of the search engine, exported by libcustomgrep.so for embedding it
+ * in other languages without running grep_exec and parsing its output.
+ *
+ * A search compiles one query once; it is then fed files, lists of paths,
+ * directories or buffers, and every matching line is handed to a callback.
+ * The strings and spans of a match view the engine's own storage and are
+ * only valid during the callback. A search runs one call at a time; use one
+ * search per thread to search concurrently. No function throws; a failed
+ * call returns NULL or -1 and cgrep_last_error() tells why.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* CGREP_BUILDING is defined while the library itself is built */
+#if defined(_WIN32) && defined(CGREP_BUILDING)
+#define CGREP_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define CGREP_API __declspec(dllimport)
+#else
+#define CGREP_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Regex grammars, as for grep -P, -E and -G */
+enum cgrep_syntax
+{
+    CGREP_SYNTAX_ECMASCRIPT = 0,
+    CGREP_SYNTAX_EXTENDED = 1,
+    CGREP_SYNTAX_BASIC = 2
+};
+
+/* Search options; cgrep_options_init() sets the defaults and struct_size.
+   The library reads only the fields within struct_size, so callers built
+   against this header keep working when later versions add fields. */
+typedef struct cgrep_options
+{
+    size_t struct_size;     /* sizeof(cgrep_options) of the caller */
+    int    ignore_case;     /* non-zero: case-insensitive */
+    int    regex;           /* non-zero: the query is a regex */
+    int    syntax;          /* enum cgrep_syntax, with regex */
+    int    invert_match;    /* non-zero: report the lines without a hit (grep -v) */
+    int    word_regexp;     /* non-zero: hits must be whole words (grep -w) */
+    int    line_regexp;     /* non-zero: hits must be whole lines (grep -x) */
+    size_t max_line_length; /* longer lines are reported cut to this length */
+    size_t buffer_size;     /* bytes read and searched at a time per thread */
+    size_t result_memory;   /* bytes of matches a parallel search holds before
+                               spilling them to a temporary file; 0: no limit */
+} cgrep_options;
+
+/* One hit within a line: `length` bytes from byte `start` of the line. */
+typedef struct cgrep_span
+{
+    size_t start;
+    size_t length;
+} cgrep_span;
+
+/* A matching line. `path` and `line` are not NUL-terminated. */
+typedef struct cgrep_match
+{
+    const char*       path;
+    size_t            path_length;
+    size_t            line_number;
+    const char*       line;
+    size_t            line_length;
+    size_t            byte_offset; /* offset of the line in the file */
+    size_t            hit_offset;  /* offset of the first hit in the line */
+    int               truncated;   /* non-zero if `line` was cut to max_line_length */
+    const cgrep_span* spans;
+    size_t            span_count;
+} cgrep_match;
+
+/* Called for every matching line; return 0 to go on, non-zero to stop. */
+typedef int (*cgrep_match_callback)(const cgrep_match* match, void* user_data);
+
+typedef struct cgrep_search cgrep_search;
+
+CGREP_API void cgrep_options_init(cgrep_options* options);
+
+/* Compile `query` (`query_length` bytes) for `options`, or the defaults if
+   NULL. Returns NULL for a query the engine rejects, and for options whose
+   struct_size this library does not know. */
+CGREP_API cgrep_search* cgrep_search_new(const char* query, size_t query_length, const cgrep_options* options);
+CGREP_API void cgrep_search_free(cgrep_search* search);
+
+/* The searches return the number of matching lines handed to `callback`,
+   or -1 on failure. A file that cannot be read is skipped with a message on
+   stderr, as by grep_exec. */
+
+/* Search one file on the calling thread, handing over each line as found. */
+CGREP_API int64_t cgrep_search_file(cgrep_search* search, const char* path, cgrep_match_callback callback,
+                                    void* user_data);
+
+/* Search `size` bytes at `data`, reported as the file `name`. */
+CGREP_API int64_t cgrep_search_buffer(cgrep_search* search, const char* data, size_t size, const char* name,
+                                      cgrep_match_callback callback, void* user_data);
+
+/* Search `count` files in parallel; the matches are handed over in file
+   order once all files are searched. The matches held meanwhile stay within
+   result_memory, beyond which they wait in a temporary file. */
+CGREP_API int64_t cgrep_search_paths(cgrep_search* search, const char* const* paths, size_t count,
+                                     cgrep_match_callback callback, void* user_data);
+
+/* Search every regular file under the directory `root` in parallel, like
+   cgrep_search_paths. */
+CGREP_API int64_t cgrep_search_directory(cgrep_search* search, const char* root, cgrep_match_callback callback,
+                                         void* user_data);
+
+/* The reason the last failed call on this thread failed. */
+CGREP_API const char* cgrep_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CUSTOM_GREP_C_H */
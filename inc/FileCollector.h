@@ -1,5 +1,7 @@
 #pragma once
 
+#include "FileTable.h"
+
 #include <filesystem>
 #include <vector>
 
@@ -13,9 +15,13 @@ public:
     /// Throws std::filesystem::filesystem_error on failure.
     static std::vector<std::filesystem::path> collectFiles(const std::filesystem::path& dir);
 
+    /// Like collectFiles, but return the files as a compact FileTable, in the
+    /// same order. Use this for large trees.
+    static FileTable collectFileTable(const std::filesystem::path& dir);
+
 private:
-    static void collectFilesRecursive(const std::filesystem::path& dir,
-                                      std::vector<std::filesystem::path>& files);
+    // Report on stderr why `dir` is neither a directory nor a regular file.
+    static void reportInvalidInput(const std::filesystem::path& dir, const std::error_code& ec);
 };
 
 } // namespace cgrep
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// Compact list of files under a directory tree. Instead of one
+/// std::filesystem::path per file, each repeating the whole directory
+/// prefix, the table stores every file and directory name once in a string
+/// pool with the index of its parent directory, 16 bytes per entry. Paths
+/// are rebuilt on demand, root first, the same way directory iteration
+/// builds them (`parent / name`).
+class FileTable
+{
+public:
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+
+    /// Add a directory named `name` inside directory `parent` (kNoParent for
+    /// a root, whose name is its whole path) and return its index.
+    uint32_t addDirectory(uint32_t parent, std::string_view name);
+
+    /// Add a file named `name` inside directory `directory`; kNoParent makes
+    /// `name` the file's whole path.
+    void addFile(uint32_t directory, std::string_view name);
+
+    [[nodiscard]] size_t size() const { return m_files.size(); }
+    [[nodiscard]] bool empty() const { return m_files.empty(); }
+    [[nodiscard]] size_t directoryCount() const { return m_directories.size(); }
+
+    /// The path of file `index`.
+    [[nodiscard]] std::filesystem::path path(size_t index) const;
+
+    /// Store the path of file `index` in `out`, reusing its storage where
+    /// the standard library allows.
+    void pathInto(size_t index, std::filesystem::path& out) const;
+
+    /// Bytes held by the table.
+    [[nodiscard]] size_t memoryUsage() const;
+
+private:
+    struct Entry
+    {
+        uint64_t nameOffset = 0; // into m_names
+        uint32_t nameLength = 0;
+        uint32_t parent = kNoParent;
+    };
+
+    uint64_t storeName(std::string_view name);
+    [[nodiscard]] std::string_view name(const Entry& entry) const;
+
+    // Append the path of `directory`, root first, to `out`
+    void appendDirectory(uint32_t directory, std::filesystem::path& out) const;
+
+    std::vector<Entry> m_directories;
+    std::vector<Entry> m_files;
+    std::string        m_names;
+};
+
+} // namespace cgrep
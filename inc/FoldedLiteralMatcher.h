@@ -0,0 +1,51 @@
+#pragma once
+
+#include "LiteralMatcher.h"
+#include "MultiLiteralMatcher.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cgrep
+{
+
+/// Case-insensitive substring search over UTF-8 text using Unicode simple
+/// case folding. The needle is folded once; haystack bytes are decoded and
+/// folded on the fly while comparing, so searching never allocates.
+///
+/// Needles that are pure ASCII (and cannot be matched by a non-ASCII code
+/// point, which rules out 'k' and 's' because of KELVIN SIGN and LONG S) use
+/// the vectorized ASCII caseless LiteralMatcher. Other needles scan for every
+/// case variant of their first code point with a MultiLiteralMatcher and
+/// verify the rest of the needle from each candidate.
+class FoldedLiteralMatcher
+{
+public:
+    explicit FoldedLiteralMatcher(std::string_view needle);
+
+    /// Return the byte position of the first case-insensitive occurrence of
+    /// the needle in `haystack` at or after `from` (or npos) and store the
+    /// number of haystack bytes it spans in `length`, which can differ from
+    /// the needle's length (e.g. U+212A KELVIN SIGN is three bytes, 'k' one).
+    [[nodiscard]] size_t find(std::string_view haystack, size_t from, size_t& length) const;
+
+    /// Upper bound on the bytes a hit can span: four per needle code point.
+    [[nodiscard]] size_t maxMatchLength() const
+    {
+        return m_ascii ? m_ascii->needle().size() : m_folded.size() * 4;
+    }
+
+    /// The needle after case folding.
+    [[nodiscard]] const std::u32string& foldedNeedle() const { return m_folded; }
+
+    [[nodiscard]] bool usesAsciiFastPath() const { return m_ascii.has_value(); }
+
+private:
+    std::optional<LiteralMatcher>      m_ascii;
+    std::u32string                     m_folded;
+    std::optional<MultiLiteralMatcher> m_firstCodePoint;
+};
+
+} // namespace cgrep
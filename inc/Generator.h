@@ -0,0 +1,124 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace cgrep
+{
+
+/// A lazily evaluated sequence of `T`, produced by a coroutine that
+/// `co_yield`s the elements (a subset of C++23 std::generator). The body
+/// only starts on begin() and runs up to the next `co_yield` on each
+/// increment; an element is a reference into the coroutine, valid until the
+/// next increment. Destroying the generator destroys the coroutine with its
+/// locals, so a consumer that stops early stops the producer too. An
+/// exception thrown in the body is rethrown by begin() or the increment.
+template <typename T>
+class Generator
+{
+public:
+    struct promise_type
+    {
+        const T*           current = nullptr;
+        std::exception_ptr error;
+
+        Generator get_return_object() { return Generator{Handle::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const T& value) noexcept
+        {
+            current = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class iterator
+    {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        const T& operator*() const { return *m_coroutine.promise().current; }
+        const T* operator->() const { return m_coroutine.promise().current; }
+
+        iterator& operator++()
+        {
+            resume(m_coroutine);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept
+        {
+            return !it.m_coroutine || it.m_coroutine.done();
+        }
+
+    private:
+        friend class Generator;
+        explicit iterator(Handle coroutine) : m_coroutine(coroutine) {}
+
+        Handle m_coroutine = nullptr;
+    };
+
+    Generator() = default;
+    ~Generator()
+    {
+        if (m_coroutine)
+        {
+            m_coroutine.destroy();
+        }
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+    Generator(Generator&& other) noexcept : m_coroutine(std::exchange(other.m_coroutine, nullptr)) {}
+    Generator& operator=(Generator&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_coroutine)
+            {
+                m_coroutine.destroy();
+            }
+            m_coroutine = std::exchange(other.m_coroutine, nullptr);
+        }
+        return *this;
+    }
+
+    /// Run the body up to the first element. Call once.
+    iterator begin()
+    {
+        resume(m_coroutine);
+        return iterator{m_coroutine};
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    explicit Generator(Handle coroutine) : m_coroutine(coroutine) {}
+
+    static void resume(Handle coroutine)
+    {
+        if (coroutine && !coroutine.done())
+        {
+            coroutine.resume();
+            if (coroutine.promise().error)
+            {
+                std::rethrow_exception(std::exchange(coroutine.promise().error, nullptr));
+            }
+        }
+    }
+
+    Handle m_coroutine = nullptr;
+};
+
+} // namespace cgrep
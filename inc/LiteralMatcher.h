@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace cgrep
+{
+
+/// Exact substring search for a fixed needle. The search algorithm is chosen
+/// once in the constructor from the needle length and alphabet, so the same
+/// matcher can be reused for every line of every file searched for a query.
+/// With `asciiCaseInsensitive` the needle and haystack are compared with
+/// ASCII letters folded to lowercase; this always uses the rare-byte scan,
+/// matching both cases of each anchor byte.
+class LiteralMatcher
+{
+public:
+    enum class Algorithm
+    {
+        Direct,    // memchr on the first byte + memcmp (std::string_view::find)
+        RareBytes, // vector scan for the two rarest needle bytes + memcmp
+        Horspool,  // Boyer-Moore-Horspool with a rare "guard" byte check
+        TwoWay     // Crochemore-Perrin Two-Way, linear in the worst case
+    };
+
+    explicit LiteralMatcher(std::string needle, bool asciiCaseInsensitive = false);
+
+    /// Return the position of the first occurrence of the needle in
+    /// `haystack` at or after `from`, or std::string_view::npos.
+    [[nodiscard]] size_t find(std::string_view haystack, size_t from = 0) const;
+
+    /// The needle as searched for (lowercased in case-insensitive mode).
+    [[nodiscard]] const std::string& needle() const { return m_needle; }
+    [[nodiscard]] Algorithm algorithm() const { return m_algorithm; }
+
+private:
+    template <bool CaseInsensitive>
+    [[nodiscard]] size_t findRareBytes(std::string_view haystack, size_t from) const;
+    [[nodiscard]] size_t findHorspool(std::string_view haystack, size_t from) const;
+    [[nodiscard]] size_t findTwoWay(std::string_view haystack, size_t from) const;
+
+    void prepareRareBytes();
+    void prepareHorspool();
+    void prepareTwoWay();
+
+    std::string m_needle;
+    Algorithm   m_algorithm = Algorithm::Direct;
+    bool        m_caseInsensitive = false;
+
+    // Rare bytes: positions of the two needle bytes least likely to occur in
+    // text, used as anchors for the vector scan before verifying candidates.
+    size_t m_rare1Index = 0;
+    size_t m_rare2Index = 0;
+
+    // Horspool: bad-character shift per byte value and the index of the
+    // rarest needle byte, checked before the full comparison.
+    std::array<size_t, 256> m_skip{};
+    size_t m_guardIndex = 0;
+
+    // Two-Way: critical factorization position and period of the needle.
+    size_t m_critical = 0;
+    size_t m_period = 0;
+    bool   m_periodic = false;
+};
+
+} // namespace cgrep
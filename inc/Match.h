@@ -0,0 +1,88 @@
+#pragma once
+
+#include "MatchArena.h"
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// One hit within a line: `length` bytes starting at byte `start` of the line.
+struct Span
+{
+    size_t start = 0;
+    size_t length = 0;
+
+    bool operator==(const Span&) const = default;
+};
+
+/// Represents a single match of `query` inside `path` at line `line_number`.
+/// `line` holds the contents of that line (without the trailing newline).
+/// Lines longer than the configured maximum line length are cut to that
+/// length and flagged `truncated`; `hit_offset` locates the first hit within
+/// the whole line either way. `byte_offset` is the file offset of the line
+/// and `spans` lists every non-empty hit on it, left to right and
+/// non-overlapping, as found by the same scan that matched the line.
+/// `path`, `line` and `spans` view the storage of the MatchList holding the
+/// match and are valid as long as that list. `query_id` is the index of the
+/// query that matched in a CustomGrep::searchBatch, and 0 otherwise.
+struct Match
+{
+    std::string_view      path;
+    size_t                line_number = 0;
+    std::string_view      line;
+    size_t                hit_offset = 0; // byte offset of the first hit within the line
+    bool                  truncated = false;
+    size_t                byte_offset = 0; // offset of the line's first byte in the file
+    std::span<const Span> spans;
+    size_t                query_id = 0;
+};
+
+/// The matches of a search, in order, together with the arena their text
+/// lives in. Each worker fills a list of its own; the lists are merged by
+/// splicing their arena chunks, so match text is copied exactly once, from
+/// the scan buffer into the arena. Matches can be reordered freely (e.g.
+/// sorted); their views stay valid when the list is moved.
+class MatchList
+{
+public:
+    using iterator = std::vector<Match>::iterator;
+    using const_iterator = std::vector<Match>::const_iterator;
+
+    /// Copy `path` into the list's arena, once per file with matches.
+    [[nodiscard]] std::string_view storePath(const std::filesystem::path& path);
+
+    /// Record a match, copying `line` and `spans` into the arena. `path`
+    /// must come from storePath() of this list.
+    void add(std::string_view path, size_t lineNumber, std::string_view line, size_t hitOffset,
+             bool truncated, size_t byteOffset, std::span<const Span> spans, size_t queryId = 0);
+
+    /// Move the matches of `other` to the end of this list.
+    void append(MatchList&& other);
+
+    /// Drop the matches and free the arena, keeping the record capacity.
+    void clear();
+
+    void reserve(size_t count) { m_matches.reserve(count); }
+
+    [[nodiscard]] size_t size() const { return m_matches.size(); }
+    [[nodiscard]] bool empty() const { return m_matches.empty(); }
+    [[nodiscard]] const Match& operator[](size_t index) const { return m_matches[index]; }
+    [[nodiscard]] Match& operator[](size_t index) { return m_matches[index]; }
+    [[nodiscard]] iterator begin() { return m_matches.begin(); }
+    [[nodiscard]] iterator end() { return m_matches.end(); }
+    [[nodiscard]] const_iterator begin() const { return m_matches.begin(); }
+    [[nodiscard]] const_iterator end() const { return m_matches.end(); }
+
+    /// Bytes of the records held and of the arena chunks, used or not.
+    [[nodiscard]] size_t memoryUsage() const { return m_matches.size() * sizeof(Match) + m_arena.capacity(); }
+
+private:
+    std::vector<Match> m_matches;
+    MatchArena         m_arena;
+};
+
+} // namespace cgrep
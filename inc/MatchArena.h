@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace cgrep
+{
+
+/// Bump allocator for the text and spans of Match records (see MatchList). A worker copies
+/// everything a match refers to into its own arena, so recording a match
+/// costs no heap allocation beyond one chunk per kChunkSize bytes, and no
+/// worker contends with another in the allocator. Chunks never move once
+/// allocated: views handed out stay valid until the arena (or the arena
+/// its chunks were spliced into) is destroyed.
+class MatchArena
+{
+public:
+    static constexpr size_t kChunkSize = size_t{64} << 10;
+
+    MatchArena() = default;
+    MatchArena(const MatchArena&) = delete;
+    MatchArena& operator=(const MatchArena&) = delete;
+    MatchArena(MatchArena&&) noexcept = default;
+    MatchArena& operator=(MatchArena&&) noexcept = default;
+
+    /// Copy `text` into the arena and return a view of the copy.
+    [[nodiscard]] std::string_view copy(std::string_view text);
+
+    /// Copy `items` (of a trivially copyable type) into the arena.
+    template <typename T>
+    [[nodiscard]] std::span<const T> copy(std::span<const T> items)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (items.empty())
+        {
+            return {};
+        }
+        T* data = static_cast<T*>(allocate(items.size_bytes(), alignof(T)));
+        std::memcpy(static_cast<void*>(data), items.data(), items.size_bytes());
+        return { data, items.size() };
+    }
+
+    /// Take over the chunks of `other`, leaving it empty. Views into them
+    /// stay valid; no byte is copied.
+    void splice(MatchArena&& other);
+
+    /// Bytes held in chunks, used or not.
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+private:
+    [[nodiscard]] void* allocate(size_t size, size_t alignment);
+
+    std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+    std::byte* m_cursor = nullptr; // free space of the current chunk
+    std::byte* m_end = nullptr;
+    size_t     m_capacity = 0;
+};
+
+} // namespace cgrep
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Match.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+
+namespace cgrep
+{
+
+/// Bounded queue of MatchList batches, handed from the workers of a search
+/// to a single consumer. The matches queued stay within `capacity`, except
+/// that a batch is always taken into an empty channel; a worker pushing into
+/// a full channel waits for the consumer to catch up.
+class MatchChannel
+{
+public:
+    explicit MatchChannel(size_t capacity);
+
+    /// Queue `batch`, waiting while the channel is full. Returns false, and
+    /// drops the batch, if a stop is requested on `stop` meanwhile.
+    bool push(MatchList&& batch, const std::stop_token& stop);
+
+    /// Take the oldest batch, waiting for one; std::nullopt once the channel
+    /// is closed and every batch taken.
+    [[nodiscard]] std::optional<MatchList> pop();
+
+    /// Tell the consumer that no more batches will be pushed.
+    void close();
+
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+private:
+    std::mutex                  m_mutex;
+    std::condition_variable_any m_notFull;
+    std::condition_variable     m_notEmpty;
+    std::deque<MatchList>       m_batches;
+    size_t                      m_queued = 0; // matches in m_batches
+    size_t                      m_capacity;
+    bool                        m_closed = false;
+};
+
+} // namespace cgrep
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Match.h"
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace cgrep
+{
+
+/// Temporary file that MatchLists are spilled to when they outgrow their
+/// memory budget, and read back from in the order they were written.
+/// Records are stored in a compact binary form: fixed-size fields followed
+/// by the line text and spans, with the path written only when it differs
+/// from the previous record's and the query id only when it is not 0. The
+/// file is created on the first write and removed by the system when the
+/// spill is destroyed.
+class MatchSpill
+{
+public:
+    /// Append every match of `matches`. Lines over 4 GiB are cut to that
+    /// length and flagged truncated. Throws std::runtime_error if the
+    /// temporary file cannot be created or written, or for a path or span
+    /// list over 2^32 - 1 bytes or entries.
+    void write(const MatchList& matches);
+
+    /// Hand every spilled match to `sink` in the order written. The match
+    /// only lives during the call; memory use does not depend on the number
+    /// of matches. Returns the number of matches.
+    size_t replay(const std::function<void(const Match&)>& sink);
+
+    [[nodiscard]] size_t size() const { return m_count; }
+    [[nodiscard]] size_t bytes() const { return m_bytes; }
+
+private:
+    struct CloseFile
+    {
+        void operator()(std::FILE* file) const { std::fclose(file); }
+    };
+
+    std::unique_ptr<std::FILE, CloseFile> m_file;
+    std::string                           m_lastPath; // path of the last record written
+    std::string                           m_record;   // encoding buffer, reused
+    size_t                                m_count = 0;
+    size_t                                m_bytes = 0;
+};
+
+} // namespace cgrep
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// Search for any of a set of fixed strings at once (e.g. the alternatives of
+/// a `foo|bar|baz` regex). Small sets of up to 64 patterns use a Teddy-style
+/// SIMD scan: nibble lookup tables are applied with byte shuffles to up to
+/// three leading bytes of every position, flagging positions where one of
+/// eight pattern buckets may start. Larger sets, and CPUs without SSSE3, use
+/// an Aho-Corasick automaton with a full 256-entry transition table per state.
+class MultiLiteralMatcher
+{
+public:
+    enum class Algorithm
+    {
+        Teddy,
+        AhoCorasick
+    };
+
+    /// A hit of pattern `pattern` (index into `patterns()`) at `position`.
+    struct Hit
+    {
+        size_t position = 0;
+        size_t length = 0;
+        size_t pattern = 0;
+    };
+
+    explicit MultiLiteralMatcher(std::vector<std::string> patterns, bool asciiCaseInsensitive = false);
+
+    /// Find the leftmost occurrence of any pattern in `haystack` at or after
+    /// `from`; among patterns starting there the longest wins.
+    /// Returns false if no pattern occurs.
+    [[nodiscard]] bool find(std::string_view haystack, size_t from, Hit& hit) const;
+
+    /// The patterns as searched for (lowercased in case-insensitive mode).
+    [[nodiscard]] const std::vector<std::string>& patterns() const { return m_patterns; }
+    [[nodiscard]] Algorithm algorithm() const { return m_algorithm; }
+    /// Length of the longest pattern.
+    [[nodiscard]] size_t maxLength() const { return m_maxLength; }
+
+private:
+    static constexpr size_t kBuckets = 8;
+
+    [[nodiscard]] bool findTeddy(std::string_view haystack, size_t from, Hit& hit) const;
+    [[nodiscard]] bool findAhoCorasick(std::string_view haystack, size_t from, Hit& hit) const;
+
+    // Whether pattern `index` occurs at `position` (which must fit in the haystack).
+    [[nodiscard]] bool patternAt(std::string_view haystack, size_t position, size_t index) const;
+
+    // Check the patterns of every bucket set in `buckets` at `position`,
+    // storing the longest one that matches.
+    [[nodiscard]] bool verifyBuckets(std::string_view haystack, size_t position,
+                                     uint8_t buckets, Hit& hit) const;
+
+    void buildTeddy();
+    void buildAhoCorasick();
+
+    std::vector<std::string> m_patterns;
+    Algorithm m_algorithm = Algorithm::AhoCorasick;
+    size_t    m_maxLength = 0;
+    bool      m_hasEmpty = false; // an empty pattern matches everywhere
+    bool      m_caseInsensitive = false;
+
+    // Teddy: for each of the first `m_maskLength` bytes, bucket bits indexed
+    // by the low and high nibble of the byte, plus the patterns of each bucket.
+    size_t m_maskLength = 0;
+    std::array<std::array<uint8_t, 16>, 3> m_lowMasks{};
+    std::array<std::array<uint8_t, 16>, 3> m_highMasks{};
+    std::array<std::vector<size_t>, kBuckets> m_bucketPatterns;
+
+    // Aho-Corasick: dense DFA transitions (state * 256 + byte) and, for each
+    // state, the longest pattern ending there (length 0 if none).
+    std::vector<uint32_t> m_transitions;
+    std::vector<uint32_t> m_outputLength;
+    std::vector<uint32_t> m_outputPattern;
+};
+
+} // namespace cgrep
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "RegexParser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// Regex search with capture groups by a Pike VM: the regex is compiled to a
+/// small bytecode program that is run over the text breadth-first, with one
+/// thread per program counter and a copy of the capture slots per thread.
+/// Threads reaching a program counter that is already taken are dropped, so
+/// a search takes O(text length * program size) time on any pattern,
+/// including the nested quantifiers std::regex backtracks on.
+///
+/// Threads are kept in priority order, so hits and captures are the
+/// leftmost-first ones of a backtracking ECMAScript engine like std::regex
+/// (greedy quantifiers, earlier alternatives first).
+class PikeVM
+{
+public:
+    /// Most instructions a program may have after expanding counted repeats.
+    static constexpr size_t kMaxInstructions = size_t{1} << 16;
+
+    /// Thread lists and capture slots for running a program, reused from one
+    /// search to the next so that searching does not allocate once they have
+    /// grown to the program's size. One per worker thread.
+    class Scratch
+    {
+    public:
+        /// Capture slots of the last hit: the start and end of group k are
+        /// slots 2k and 2k + 1, npos for groups that did not take part.
+        [[nodiscard]] std::span<const size_t> captures() const { return m_captures; }
+
+    private:
+        friend class PikeVM;
+
+        // Sparse set of program counters in insertion (priority) order, with
+        // the capture slots of the thread at each program counter
+        struct ThreadList
+        {
+            std::vector<uint32_t> dense;
+            std::vector<uint32_t> sparse;
+            std::vector<size_t>   slots;
+            size_t                size = 0;
+
+            [[nodiscard]] bool contains(uint32_t pc) const
+            {
+                return sparse[pc] < size && dense[sparse[pc]] == pc;
+            }
+        };
+
+        // A step of the depth-first walk over the non-consuming instructions:
+        // visit `pc`, or restore capture `slot` to `value` on the way back
+        struct Frame
+        {
+            uint32_t pc = 0;
+            uint32_t slot = 0;
+            size_t   value = 0;
+            bool     restore = false;
+        };
+
+        void prepare(size_t instructions, size_t slots);
+
+        ThreadList          m_current;
+        ThreadList          m_next;
+        std::vector<size_t> m_slots; // captures of the thread being added
+        std::vector<size_t> m_captures;
+        std::vector<Frame>  m_stack;
+    };
+
+    /// Compile `root`, or return std::nullopt if the program would exceed
+    /// kMaxInstructions.
+    [[nodiscard]] static std::optional<PikeVM> compile(const RegexNode& root);
+
+    /// Search `text` for the leftmost-first hit starting at or after `from`
+    /// and store its capture slots in `scratch.captures()`. Past the start of
+    /// `text`, ^ does not match; with `lineContinues`, $, \b, \B and the -w
+    /// assertions do not match at the end of `text`.
+    [[nodiscard]] bool search(std::string_view text, size_t from, Scratch& scratch,
+                              bool lineContinues = false) const;
+
+    /// Number of capture groups, not counting the whole hit.
+    [[nodiscard]] size_t groups() const { return m_slotCount / 2 - 1; }
+
+    /// Whether hits never contain a line break (see BitParallelRegex).
+    [[nodiscard]] bool hitsStayInLine() const { return !m_lineAnchors; }
+
+    [[nodiscard]] size_t instructions() const { return m_program.size(); }
+
+    struct Instruction
+    {
+        enum class Op : uint8_t
+        {
+            Bytes,  // consume a byte of set `x`
+            Split,  // continue at `x`, then at `y`
+            Jump,   // continue at `x`
+            Save,   // store the position in capture slot `x`
+            Assert, // continue if assertion RegexNode::Kind `x` holds
+            Match
+        };
+
+        Op       op = Op::Match;
+        uint32_t x = 0;
+        uint32_t y = 0;
+    };
+
+private:
+    PikeVM() = default;
+
+    // Add the thread at `pc` with the capture slots in scratch.m_slots to
+    // `list`, following jumps, splits, saves and assertions
+    void addThread(Scratch& scratch, Scratch::ThreadList& list, uint32_t pc, std::string_view text,
+                   size_t position, bool lineContinues) const;
+
+    [[nodiscard]] bool assertionHolds(RegexNode::Kind kind, std::string_view text, size_t position,
+                                      bool lineContinues) const;
+
+    std::vector<Instruction> m_program;
+    std::vector<ByteSet>     m_byteSets;
+    size_t                   m_slotCount = 2;
+    bool                     m_lineAnchors = false;
+
+    // Bytes a hit can start with, used to skip ahead while no thread is
+    // running; not used if the program can match the empty string
+    std::array<bool, 256> m_startBytes{};
+    bool                  m_skipToStart = false;
+};
+
+} // namespace cgrep
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "RegexParser.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace cgrep
+{
+
+/// Return the offset of the first group of `pattern` (ECMAScript syntax)
+/// that holds an unbounded quantifier and is itself repeated by one, such
+/// as `(a+)+`, `(a*)*` or `(\w+\s?)*`, or std::string_view::npos if there is
+/// none. A backtracking engine can take time exponential in the line length
+/// on such nested quantifiers. The check is syntactic, so it also flags some
+/// harmless patterns like `(a+b)*`; other slow patterns (e.g. `(a|a)*`) are
+/// left to the search budget.
+[[nodiscard]] size_t findNestedQuantifier(std::string_view pattern);
+
+/// Spell the GNU ERE `pattern` in ECMAScript syntax, for the patterns
+/// parseRegex leaves to std::regex: its ERE grammar has no backreferences,
+/// which ECMAScript has. `.` does not match '\n', a backslash in a bracket
+/// expression is literal, quantifiers with nothing to repeat and braces
+/// that do not form an interval are literal, and \< \> become \b with a
+/// lookahead, as in grep -E. Invalid patterns stay invalid.
+[[nodiscard]] std::string extendedToECMAScript(std::string_view pattern);
+
+/// The literal bytes every hit of a ^-anchored regex starts its line with,
+/// such as "2026-10-16 ERROR" for `^2026-10-16 ERROR \w+`. A line that does
+/// not start with them cannot match, which one comparison decides before the
+/// regex engine runs. Letters given in both ASCII cases (as with ignoreCase)
+/// are stored lowercased and compared caselessly.
+struct LinePrefix
+{
+    bool        anchored = false; // the regex starts with ^
+    std::string bytes;
+    bool        asciiCaseInsensitive = false;
+
+    /// Whether a hit may start in `text` at or after `from`.
+    [[nodiscard]] bool admits(std::string_view text, size_t from) const
+    {
+        if (!anchored)
+        {
+            return true;
+        }
+        if (from > 0 || text.size() < bytes.size())
+        {
+            return false;
+        }
+        if (!asciiCaseInsensitive)
+        {
+            return std::memcmp(text.data(), bytes.data(), bytes.size()) == 0;
+        }
+        for (size_t i = 0; i < bytes.size(); ++i)
+        {
+            char c = text[i];
+            if (c >= 'A' && c <= 'Z')
+            {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+            if (c != bytes[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/// The line prefix of `root` (unanchored if it does not start with ^).
+[[nodiscard]] LinePrefix findLinePrefix(const RegexNode& root);
+
+/// A literal that every hit of a regex contains, such as "@example.com" for
+/// `\w+@example\.com`, with what can come before it in a hit: at most
+/// `maxLead` bytes (RegexNode::kUnbounded if not bounded), all from
+/// `leadBytes`. Empty `bytes` if the regex has no such literal.
+struct RequiredLiteral
+{
+    std::string bytes;
+    bool        asciiCaseInsensitive = false; // as for LinePrefix
+    size_t      maxLead = 0;
+    ByteSet     leadBytes;
+};
+
+/// The longest run of literal bytes in the top-level sequence of `root`.
+[[nodiscard]] RequiredLiteral findRequiredLiteral(const RegexNode& root);
+
+} // namespace cgrep
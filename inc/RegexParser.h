@@ -0,0 +1,78 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// A set of byte values, the alphabet of one regex position.
+using ByteSet = std::bitset<256>;
+
+/// Syntax tree of a regex, the common form consumed by the regex engines.
+/// Engines work on bytes: a multibyte UTF-8 character in the pattern is a
+/// concatenation of its bytes, as it is for std::regex over char.
+struct RegexNode
+{
+    enum class Kind
+    {
+        Empty,           // matches the empty string
+        Bytes,           // one byte out of `bytes`
+        Concat,          // `children` in sequence
+        Alternate,       // any one of `children`
+        Repeat,          // `children[0]` between `min` and `max` times
+        Group,           // `children[0]`, captured as group `capture` if > 0
+        LineStart,       // ^
+        LineEnd,         // $
+        WordBoundary,    // \b
+        NotWordBoundary, // \B
+        WordStart,       // \< (POSIX syntaxes)
+        WordEnd,         // \>
+        NoWordBefore,    // no isWordByte() byte before; grep -w, not written in patterns
+        NoWordAfter      // no isWordByte() byte after
+    };
+
+    static constexpr size_t kUnbounded = static_cast<size_t>(-1);
+
+    Kind                   kind = Kind::Empty;
+    ByteSet                bytes;
+    std::vector<RegexNode> children;
+    size_t                 min = 0;
+    size_t                 max = kUnbounded;
+    size_t                 capture = 0;
+};
+
+/// Whether `c` is a word constituent for grep -w: an ASCII letter or digit,
+/// '_', or any byte of a multibyte UTF-8 character.
+inline bool isWordByte(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c >= 0x80;
+}
+
+/// Regex syntaxes understood by parseRegex.
+enum class RegexSyntax
+{
+    ECMAScript, // the std::regex default, close to Perl (grep -P)
+    Extended,   // POSIX ERE with the GNU extensions \w \s \b \< \> (grep -E)
+    Basic       // POSIX BRE with the GNU extensions \| \+ \? (grep -G)
+};
+
+/// Parse a regex in `syntax` into a tree, with ASCII case folding applied to
+/// its bytes if `ignoreCase`. In the POSIX syntaxes `.` and bracket
+/// expressions match any byte but '\n', and a backslash inside a bracket
+/// expression is literal, as in GNU grep. Returns std::nullopt for anything
+/// outside the supported subset (backreferences, lookahead, lazy
+/// quantifiers, \u escapes beyond ASCII, collating symbols and equivalence
+/// classes other than a single byte like [.-.]) and for invalid patterns;
+/// callers fall back to std::regex, which reports the errors.
+[[nodiscard]] std::optional<RegexNode> parseRegex(std::string_view pattern, bool ignoreCase = false,
+                                                  RegexSyntax syntax = RegexSyntax::ECMAScript);
+
+/// Number of capture groups in `node`.
+[[nodiscard]] size_t countCaptures(const RegexNode& node);
+
+} // namespace cgrep
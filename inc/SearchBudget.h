@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+
+namespace cgrep
+{
+
+/// Thrown by StepBudget::charge() when the budget of a file scan is used up.
+class SearchBudgetExceeded : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// Step and time budget of a single file scan. Matchers whose running time
+/// is not linear in the input (std::regex backtracks) charge one step per
+/// character they examine, so a pathological pattern cannot pin a worker:
+/// the scan is aborted with SearchBudgetExceeded instead. The clock is only
+/// read every kClockInterval steps. A limit of zero means unlimited.
+class StepBudget
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kClockInterval = size_t{1} << 16;
+
+    StepBudget(size_t maxSteps, Clock::duration maxTime);
+
+    void charge(size_t steps = 1)
+    {
+        m_steps += steps;
+        if (m_steps >= m_nextCheck)
+        {
+            check();
+        }
+    }
+
+    /// Check the time limit now, e.g. once per block read.
+    void checkTime() const;
+
+    [[nodiscard]] size_t steps() const { return m_steps; }
+
+private:
+    void check();
+
+    size_t            m_steps = 0;
+    size_t            m_nextCheck = 0;
+    size_t            m_maxSteps = 0;
+    bool              m_timed = false;
+    Clock::time_point m_deadline;
+};
+
+} // namespace cgrep
@@ -0,0 +1,1184 @@
+#pragma once
+
+#include "BitParallelRegex.h"
+#include "FoldedLiteralMatcher.h"
+#include "LiteralMatcher.h"
+#include "Match.h"
+#include "MatchSpill.h"
+#include "MultiLiteralMatcher.h"
+#include "PikeVM.h"
+#include "RegexAnalysis.h"
+#include "SearchBudget.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <istream>
+#include <regex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cgrep
+{
+
+// The search loop is a template over two policies, so every combination is
+// compiled into its own loop with the matcher inlined and no mode checks:
+//
+// - A matcher policy owns the compiled query and provides
+//       size_t find(std::string_view text, size_t from, size_t& length,
+//                   const FindContext& context = {}) const
+//   returning the position of the first hit at or after `from` (or npos)
+//   and its length in bytes. `text` is a line, or a window of a line that
+//   does not fit the scan buffer (see FindContext). It also provides
+//       size_t maxMatchLength() const
+//   an upper bound on the length of a hit, used to overlap those windows, and
+//       bool hitsStayInLine() const
+//   which is true if no hit can contain a line break, so that a block of
+//   several lines can be searched at once.
+// - A line policy decides what happens to a matching line through
+//       void onMatch(const MatchedLine& line)
+//   and may also take every hit, as a view into the scan buffer, through
+//       void onHit(size_t lineNumber, std::string_view hit)
+
+/// Default size of the per-scan buffer. Lines up to this length are searched
+/// in one piece; longer ones in overlapping windows of this size.
+inline constexpr size_t kDefaultBufferSize = size_t{1} << 20;
+
+/// Default limit on the line text handed to line policies.
+inline constexpr size_t kDefaultMaxLineLength = kDefaultBufferSize;
+
+/// Smallest buffer scanStream works with.
+inline constexpr size_t kMinBufferSize = 64;
+
+/// Window overlap for regexes, whose hits have no length bound. A regex hit
+/// longer than this that crosses a window boundary of an over-long line is
+/// not found.
+inline constexpr size_t kRegexWindowOverlap = 4096;
+
+/// How a matcher policy is called for one piece of text.
+struct FindContext
+{
+    /// The line goes on past the end of the text, which is a window of a
+    /// line longer than the scan buffer.
+    bool lineContinues = false;
+
+    /// Budget of the current file scan, charged by matchers that can take
+    /// super-linear time; null if unlimited.
+    StepBudget* budget = nullptr;
+
+    /// Pike VM state of the worker running the scan; null to let the
+    /// matcher allocate its own.
+    PikeVM::Scratch* scratch = nullptr;
+};
+
+/// Whether `text` contains a '\r' or '\n'.
+inline bool hasLineBreak(std::string_view text)
+{
+    return text.find_first_of("\r\n") != std::string_view::npos;
+}
+
+/// Case-sensitive substring search.
+struct LiteralPolicy
+{
+    LiteralMatcher matcher;
+
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              const FindContext& /*context*/ = {}) const
+    {
+        length = matcher.needle().size();
+        return matcher.find(text, from);
+    }
+
+    [[nodiscard]] size_t maxMatchLength() const { return matcher.needle().size(); }
+    [[nodiscard]] bool hitsStayInLine() const { return !hasLineBreak(matcher.needle()); }
+};
+
+/// Case-insensitive substring search with Unicode simple case folding.
+struct FoldedLiteralPolicy
+{
+    FoldedLiteralMatcher matcher;
+
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              const FindContext& /*context*/ = {}) const
+    {
+        return matcher.find(text, from, length);
+    }
+
+    [[nodiscard]] size_t maxMatchLength() const { return matcher.maxMatchLength(); }
+
+    [[nodiscard]] bool hitsStayInLine() const
+    {
+        const auto& folded = matcher.foldedNeedle();
+        return folded.find_first_of(U"\r\n") == std::u32string::npos;
+    }
+};
+
+/// Any of several literals, e.g. a `foo|bar|baz` regex.
+struct MultiLiteralPolicy
+{
+    MultiLiteralMatcher matcher;
+
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              const FindContext& /*context*/ = {}) const
+    {
+        MultiLiteralMatcher::Hit hit;
+        if (!matcher.find(text, from, hit))
+        {
+            return std::string_view::npos;
+        }
+        length = hit.length;
+        return hit.position;
+    }
+
+    [[nodiscard]] size_t maxMatchLength() const { return matcher.maxLength(); }
+
+    [[nodiscard]] bool hitsStayInLine() const
+    {
+        return std::none_of(matcher.patterns().begin(), matcher.patterns().end(),
+                            [](const std::string& p) { return hasLineBreak(p); });
+    }
+};
+
+/// Iterator over the text handed to std::regex that charges a StepBudget
+/// for every character the engine moves over, so that a backtracking
+/// search can be aborted from inside the engine.
+class BudgetedIterator
+{
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = char;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char*;
+    using reference = const char&;
+
+    BudgetedIterator() = default;
+    BudgetedIterator(const char* position, StepBudget* budget) : m_position(position), m_budget(budget) {}
+
+    reference operator*() const { return *m_position; }
+    pointer operator->() const { return m_position; }
+
+    BudgetedIterator& operator++()
+    {
+        ++m_position;
+        m_budget->charge();
+        return *this;
+    }
+    BudgetedIterator operator++(int)
+    {
+        BudgetedIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+    BudgetedIterator& operator--()
+    {
+        --m_position;
+        m_budget->charge();
+        return *this;
+    }
+    BudgetedIterator operator--(int)
+    {
+        BudgetedIterator previous = *this;
+        --*this;
+        return previous;
+    }
+
+    bool operator==(const BudgetedIterator& other) const { return m_position == other.m_position; }
+
+    [[nodiscard]] const char* position() const { return m_position; }
+
+private:
+    const char* m_position = nullptr;
+    StepBudget* m_budget = nullptr;
+};
+
+/// General regular expressions through std::regex, compiled once per query.
+struct RegexPolicy
+{
+    std::regex regex;
+
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              const FindContext& context = {}) const
+    {
+        // Past the start of the line, ^ and \b must see the preceding byte
+        auto flags = from == 0 ? std::regex_constants::match_default
+                               : std::regex_constants::match_prev_avail;
+        if (context.lineContinues)
+        {
+            // The end of a window is not the end of the line; a hit that
+            // really ends there is found again by the next, overlapping window
+            flags |= std::regex_constants::match_not_eol | std::regex_constants::match_not_eow;
+        }
+        if (context.budget != nullptr)
+        {
+            BudgetedIterator first(text.data() + from, context.budget);
+            BudgetedIterator last(text.data() + text.size(), context.budget);
+            std::match_results<BudgetedIterator> m;
+            if (!std::regex_search(first, last, m, regex, flags))
+            {
+                return std::string_view::npos;
+            }
+            length = static_cast<size_t>(m[0].second.position() - m[0].first.position());
+            return static_cast<size_t>(m[0].first.position() - text.data());
+        }
+        std::cmatch m;
+        if (!std::regex_search(text.data() + from, text.data() + text.size(), m, regex, flags))
+        {
+            return std::string_view::npos;
+        }
+        length = static_cast<size_t>(m.length(0));
+        return from + static_cast<size_t>(m.position(0));
+    }
+
+    /// Whether a hit is exactly text[begin, end), with the bytes before
+    /// `begin` seen as by find().
+    [[nodiscard]] bool matches(std::string_view text, size_t begin, size_t end,
+                               const FindContext& context = {}) const
+    {
+        auto flags = begin == 0 ? std::regex_constants::match_default
+                                : std::regex_constants::match_prev_avail;
+        if (end < text.size() || context.lineContinues)
+        {
+            flags |= std::regex_constants::match_not_eol;
+        }
+        if (context.budget != nullptr)
+        {
+            return std::regex_match(BudgetedIterator(text.data() + begin, context.budget),
+                                    BudgetedIterator(text.data() + end, context.budget), regex, flags);
+        }
+        return std::regex_match(text.data() + begin, text.data() + end, regex, flags);
+    }
+
+    [[nodiscard]] size_t maxMatchLength() const { return kRegexWindowOverlap; }
+
+    // Character classes such as [^a] match line breaks
+    [[nodiscard]] bool hitsStayInLine() const { return false; }
+};
+
+/// Runs a regex engine only around the occurrences of a literal its hits
+/// contain (see RequiredLiteral): the literal is found with LiteralMatcher,
+/// the start of a possible hit is found by walking back over the bytes that
+/// may precede the literal, and the engine runs forward from there to the
+/// end of that line. Lines without the literal are never handed to the
+/// engine. A hit at a later occurrence of the literal cannot start before
+/// the walk stops either, as the byte there cannot be part of a hit's lead.
+struct LiteralPrefilter
+{
+    std::optional<LiteralMatcher> literal;
+    size_t                        maxLead = 0;
+    std::array<bool, 256>         leadBytes{};
+
+    LiteralPrefilter() = default;
+
+    explicit LiteralPrefilter(const RequiredLiteral& required)
+        : maxLead(required.maxLead)
+    {
+        if (!required.bytes.empty())
+        {
+            literal.emplace(required.bytes, required.asciiCaseInsensitive);
+        }
+        for (size_t c = 0; c < 256; ++c)
+        {
+            leadBytes[c] = required.leadBytes.test(c);
+        }
+    }
+
+    /// Return `search(text, start, atTextEnd)`, the engine's first hit in
+    /// `text` at or after `start`, for the lines of `text` that hold the
+    /// literal at or after `from`. `atTextEnd` tells whether `text` was cut
+    /// at the end of a line.
+    template <typename Search>
+    [[nodiscard]] size_t find(std::string_view text, size_t from, Search&& search) const
+    {
+        constexpr size_t npos = std::string_view::npos;
+        if (!literal)
+        {
+            return search(text, from, true);
+        }
+        for (size_t at = literal->find(text, from); at != npos; at = literal->find(text, from))
+        {
+            size_t lower = maxLead == RegexNode::kUnbounded ? from : std::max(from, at - std::min(at, maxLead));
+            size_t start = at;
+            while (start > lower && leadBytes[static_cast<unsigned char>(text[start - 1])])
+            {
+                --start;
+            }
+            size_t lineEnd = text.find('\n', at);
+            if (lineEnd == npos)
+            {
+                return search(text, start, true);
+            }
+            size_t hit = search(text.substr(0, lineEnd), start, false);
+            if (hit != npos)
+            {
+                return hit;
+            }
+            from = lineEnd + 1;
+        }
+        return npos;
+    }
+};
+
+/// Short regexes through the bit-parallel Glushkov engine, with
+/// leftmost-longest hits. Lines that do not start with the literal prefix
+/// of a ^-anchored regex, or lack a literal every hit contains, are
+/// rejected without running the engine.
+struct BitParallelPolicy
+{
+    BitParallelRegex regex;
+    LinePrefix       prefix{};
+    LiteralPrefilter prefilter{};
+
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              const FindContext& context = {}) const
+    {
+        if (!prefix.admits(text, from))
+        {
+            return std::string_view::npos;
+        }
+        return prefilter.find(text, from, [&](std::string_view lines, size_t start, bool atTextEnd)
+        {
+            return regex.find(lines, start, length, atTextEnd && context.lineContinues);
+        });
+    }
+
+    // One byte more than a hit, so that a $-anchored hit at a window end is
+    // searched again once the next window shows where the line ends
+    [[nodiscard]] size_t maxMatchLength() const
+    {
+        return regex.maxLength() == RegexNode::kUnbounded ? kRegexWindowOverlap : regex.maxLength() + 1;
+    }
+
+    [[nodiscard]] bool hitsStayInLine() const { return regex.hitsStayInLine(); }
+};
+
+/// Regexes the bit-parallel engine cannot run, and searches for a capture
+/// group, through the Pike VM. With `group` > 0 the hits are the spans of
+/// that capture group; hits where it did not take part are skipped. Like
+/// BitParallelPolicy, it checks the line prefix of ^-anchored regexes first.
+struct PikeVMPolicy
+{
+    PikeVM           vm;
+    size_t           group = 0;
+    LinePrefix       prefix{};
+    LiteralPrefilter prefilter{};
+
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              const FindContext& context = {}) const
+    {
+        if (!prefix.admits(text, from))
+        {
+            return std::string_view::npos;
+        }
+        PikeVM::Scratch local;
+        PikeVM::Scratch& scratch = context.scratch != nullptr ? *context.scratch : local;
+        return prefilter.find(text, from, [&](std::string_view lines, size_t start, bool atTextEnd)
+        {
+            while (vm.search(lines, start, scratch, atTextEnd && context.lineContinues))
+            {
+                auto captures = scratch.captures();
+                if (captures[2 * group] != std::string_view::npos)
+                {
+                    length = captures[2 * group + 1] - captures[2 * group];
+                    return captures[2 * group];
+                }
+                start = std::max(captures[1], captures[0] + 1);
+            }
+            return std::string_view::npos;
+        });
+    }
+
+    [[nodiscard]] size_t maxMatchLength() const { return kRegexWindowOverlap; }
+    [[nodiscard]] bool hitsStayInLine() const { return vm.hitsStayInLine(); }
+};
+
+/// Where a hit must sit to count: as a whole word (grep -w) or as the whole
+/// line (grep -x).
+enum class Boundary
+{
+    Word,
+    Line
+};
+
+/// Matcher policy that restricts the hits of `Inner` to whole words or whole
+/// lines by checking the bytes around each hit, so -w and -x queries keep
+/// the literal matchers, whose hits at a position all have one length. A
+/// rejected hit resumes the search one byte further for words, and at the
+/// next line for lines. Line checks also accept the '\n' or "\r\n" that
+/// ends a line inside a block of lines.
+///
+/// The regex engines have the boundary built into the compiled regex
+/// instead (see CustomGrep::compileQuery), as a rejected hit may have a
+/// shorter or longer alternative that counts. std::regex gets it as a
+/// lookahead in ECMAScript; for the POSIX syntaxes, the other lengths of a
+/// rejected hit are tried here.
+template <typename Inner, Boundary B>
+struct BoundedPolicy
+{
+    Inner inner;
+
+    [[nodiscard]] size_t find(std::string_view text, size_t from, size_t& length,
+                              const FindContext& context = {}) const
+    {
+        while (from <= text.size())
+        {
+            size_t hit = inner.find(text, from, length, context);
+            if (hit == std::string_view::npos)
+            {
+                return hit;
+            }
+            if (startsAtBoundary(text, hit))
+            {
+                if (endsAtBoundary(text, hit + length, context.lineContinues))
+                {
+                    return hit;
+                }
+                if constexpr (std::is_same_v<Inner, RegexPolicy>)
+                {
+                    // Longest first, as GNU grep picks among the hits there
+                    for (size_t end = text.size() + 1; end-- > hit;)
+                    {
+                        if (endsAtBoundary(text, end, context.lineContinues) &&
+                            inner.matches(text, hit, end, context))
+                        {
+                            length = end - hit;
+                            return hit;
+                        }
+                    }
+                }
+            }
+            if constexpr (B == Boundary::Line)
+            {
+                from = text.find('\n', hit);
+                if (from == std::string_view::npos)
+                {
+                    return from;
+                }
+            }
+            else
+            {
+                from = hit;
+            }
+            ++from;
+        }
+        return std::string_view::npos;
+    }
+
+    // Room for the byte(s) after a hit, which decide whether it counts
+    [[nodiscard]] size_t maxMatchLength() const { return inner.maxMatchLength() + 2; }
+    [[nodiscard]] bool hitsStayInLine() const { return inner.hitsStayInLine(); }
+
+private:
+    // A hit at 0 is at the start of the line: windows that continue a line
+    // are searched from 1, with the byte before as context
+    static bool startsAtBoundary(std::string_view text, size_t hit)
+    {
+        if (hit == 0)
+        {
+            return true;
+        }
+        unsigned char before = static_cast<unsigned char>(text[hit - 1]);
+        return B == Boundary::Word ? !isWordByte(before) : before == '\n';
+    }
+
+    static bool endsAtBoundary(std::string_view text, size_t end, bool lineContinues)
+    {
+        if (end == text.size())
+        {
+            return !lineContinues;
+        }
+        unsigned char after = static_cast<unsigned char>(text[end]);
+        if constexpr (B == Boundary::Word)
+        {
+            return !isWordByte(after);
+        }
+        if (after == '\r' && end + 1 < text.size())
+        {
+            after = static_cast<unsigned char>(text[end + 1]);
+        }
+        else if (after == '\r')
+        {
+            return !lineContinues;
+        }
+        return after == '\n';
+    }
+};
+
+/// A compiled query: exactly one matcher policy, chosen at query setup.
+using QueryMatcher = std::variant<LiteralPolicy, FoldedLiteralPolicy, MultiLiteralPolicy, BitParallelPolicy,
+                                  PikeVMPolicy, RegexPolicy,
+                                  BoundedPolicy<LiteralPolicy, Boundary::Word>,
+                                  BoundedPolicy<FoldedLiteralPolicy, Boundary::Word>,
+                                  BoundedPolicy<RegexPolicy, Boundary::Word>,
+                                  BoundedPolicy<LiteralPolicy, Boundary::Line>,
+                                  BoundedPolicy<FoldedLiteralPolicy, Boundary::Line>,
+                                  BoundedPolicy<RegexPolicy, Boundary::Line>>;
+
+/// A matching line as handed to line policies.
+struct MatchedLine
+{
+    size_t           lineNumber = 0;
+    size_t           byteOffset = 0; // offset of the line's first byte in the file
+    std::string_view text;           // the line, cut to ScanLimits::maxLineLength
+    size_t           lineLength = 0; // length of the whole line in bytes
+    size_t           hitOffset = 0;  // byte offset of the first hit within the line
+    bool             truncated = false; // `text` is only the head of the line
+    std::span<const Span> spans;     // every non-empty hit, for policies that collect spans
+};
+
+/// Consecutive non-matching lines as handed to line policies in invert mode:
+/// whole lines including their line breaks (the last line of a file may
+/// lack one), viewed in the scan buffer and only valid during the call.
+struct LineBlock
+{
+    size_t           firstLineNumber = 0;
+    size_t           byteOffset = 0; // offset of the block's first byte in the file
+    std::string_view text;
+};
+
+/// Number of lines in `text`, counting a last line without a line break.
+[[nodiscard]] size_t countLines(std::string_view text);
+
+/// Whether the line policy wants MatchedLine::spans filled in, declared by a
+/// `static constexpr bool kCollectSpans = true` member. Collecting spans
+/// continues the search past the first hit of each matching line.
+template <typename LinePolicy>
+inline constexpr bool kCollectsSpans = requires { requires LinePolicy::kCollectSpans; };
+
+/// Whether the line policy takes every non-empty hit through onHit(), called
+/// before onMatch() for the line. The view is only valid during the call.
+template <typename LinePolicy>
+inline constexpr bool kReceivesHits =
+    requires(LinePolicy& lines, size_t lineNumber, std::string_view hit) { lines.onHit(lineNumber, hit); };
+
+/// Whether the line policy takes the non-matching lines of invert mode
+/// through onLines(const LineBlock&).
+template <typename LinePolicy>
+inline constexpr bool kTakesLineBlocks =
+    requires(LinePolicy& lines, const LineBlock& block) { lines.onLines(block); };
+
+/// Whether the search goes on past the first hit of a line.
+template <typename LinePolicy>
+inline constexpr bool kFindsAllHits = kCollectsSpans<LinePolicy> || kReceivesHits<LinePolicy>;
+
+/// Line policy that records every matching line as a Match in `results`,
+/// copying its text into the list's arena (and the path once per file).
+/// With a `spill`, the list is written to it and cleared whenever its
+/// memory use exceeds `spillAbove` bytes.
+struct EmitLines
+{
+    static constexpr bool kCollectSpans = true;
+
+    const std::filesystem::path& path;
+    MatchList&                   results;
+    size_t                       maxLineLength = kDefaultMaxLineLength; // for lines of LineBlocks
+    MatchSpill*                  spill = nullptr;
+    size_t                       spillAbove = 0;
+    std::string_view             storedPath = {}; // `path` in the arena, once stored
+    size_t                       queryId = 0;     // see Match::query_id
+
+    void onMatch(const MatchedLine& line)
+    {
+        results.add(pathView(), line.lineNumber, line.text, line.hitOffset, line.truncated, line.byteOffset,
+                    line.spans, queryId);
+        spillIfFull();
+    }
+
+    void onLines(const LineBlock& block)
+    {
+        size_t lineNumber = block.firstLineNumber;
+        for (size_t start = 0; start < block.text.size(); ++lineNumber)
+        {
+            size_t end = std::min(block.text.find('\n', start), block.text.size());
+            std::string_view line = block.text.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            results.add(pathView(), lineNumber, line.substr(0, maxLineLength), 0, line.size() > maxLineLength,
+                        block.byteOffset + start, {}, queryId);
+            spillIfFull();
+            start = end + 1;
+        }
+    }
+
+    void spillIfFull()
+    {
+        if (spill != nullptr && results.memoryUsage() > spillAbove)
+        {
+            spill->write(results);
+            results.clear();
+            storedPath = {};
+        }
+    }
+
+    std::string_view pathView()
+    {
+        if (storedPath.data() == nullptr)
+        {
+            storedPath = results.storePath(path);
+        }
+        return storedPath;
+    }
+};
+
+/// Line policy that only counts matching lines.
+struct CountLines
+{
+    size_t count = 0;
+
+    void onMatch(const MatchedLine& /*line*/)
+    {
+        ++count;
+    }
+
+    void onLines(const LineBlock& block)
+    {
+        count += countLines(block.text);
+    }
+};
+
+/// Line policy for only-matching output: appends every hit to `out` as
+/// `path:line_number:hit`, copying it straight from the scan buffer, with no
+/// per-line strings or Match objects.
+struct WriteHits
+{
+    std::string_view path;
+    std::string&     out;
+    size_t           hits = 0;
+
+    void onHit(size_t lineNumber, std::string_view hit)
+    {
+        char digits[24];
+        char* end = std::to_chars(digits, digits + sizeof(digits), lineNumber).ptr;
+        out.append(path).append(1, ':').append(digits, end).append(1, ':').append(hit).append(1, '\n');
+        ++hits;
+    }
+
+    void onMatch(const MatchedLine& /*line*/)
+    {
+    }
+};
+
+/// Input for scanStream read from a file with read(2) straight into the scan
+/// buffer, without the locale and buffering layers of std::ifstream. Reading
+/// goes on until read(2) reports the end, so files that report size 0
+/// (procfs, sysfs) or grow meanwhile are read in full; the fstat() size of a
+/// regular file is only a hint for sizing buffers. Read errors throw
+/// std::system_error.
+class FileInput
+{
+public:
+    explicit FileInput(const std::filesystem::path& path);
+    ~FileInput();
+    FileInput(const FileInput&) = delete;
+    FileInput& operator=(const FileInput&) = delete;
+
+    /// Whether the file was opened; error() tells why not.
+    [[nodiscard]] bool isOpen() const { return m_fd >= 0; }
+    [[nodiscard]] std::error_code error() const { return m_error; }
+
+    /// Read up to `size` bytes into `data`, setting `atEnd` once the end of
+    /// the file is reached, and return the number of bytes read.
+    size_t read(char* data, size_t size, bool& atEnd);
+
+    /// Size of a regular file when it was opened, or 0 if unknown.
+    [[nodiscard]] size_t sizeHint() const { return m_sizeHint; }
+
+private:
+    int             m_fd = -1;
+    std::error_code m_error;
+    size_t          m_sizeHint = 0;
+};
+
+/// Input for scanStream from bytes already in memory, such as a file read
+/// once to be searched for several queries.
+class MemoryInput
+{
+public:
+    explicit MemoryInput(std::string_view data) : m_data(data) {}
+
+    size_t read(char* data, size_t size, bool& atEnd)
+    {
+        size_t count = std::min(size, m_data.size());
+        std::memcpy(data, m_data.data(), count);
+        m_data.remove_prefix(count);
+        atEnd = m_data.empty();
+        return count;
+    }
+
+private:
+    std::string_view m_data;
+};
+
+/// Read up to `size` bytes of `in` into `data` for scanStream, setting
+/// `atEnd` at the end of the input.
+inline size_t readInput(std::istream& in, char* data, size_t size, bool& atEnd)
+{
+    in.read(data, static_cast<std::streamsize>(size));
+    atEnd = !in;
+    return static_cast<size_t>(in.gcount());
+}
+
+inline size_t readInput(FileInput& in, char* data, size_t size, bool& atEnd)
+{
+    return in.read(data, size, atEnd);
+}
+
+inline size_t readInput(MemoryInput& in, char* data, size_t size, bool& atEnd)
+{
+    return in.read(data, size, atEnd);
+}
+
+/// Memory limits of scanStream.
+struct ScanLimits
+{
+    size_t bufferSize = kDefaultBufferSize;       // bytes read and searched at a time
+    size_t maxLineLength = kDefaultMaxLineLength; // longest line text handed to line policies
+
+    /// Budget per scan (see StepBudget); zero means unlimited. A scan that
+    /// exceeds it throws SearchBudgetExceeded.
+    size_t                              stepBudget = 0;
+    std::chrono::steady_clock::duration timeBudget{};
+
+    /// Checked before each buffer is read: once a stop is requested the scan
+    /// ends early, and the lines handed over until then are all it reports.
+    std::stop_token stop{};
+};
+
+/// Storage for scanStream, reused across files so that a worker allocates
+/// it once. Its size never exceeds the ScanLimits it is used with, apart
+/// from the spans of the current line.
+struct ScanBuffer
+{
+    std::vector<char> data;
+    std::string       longLineHead; // the kept head of an over-long line
+    std::vector<Span> spans;        // hits of the current line
+    PikeVM::Scratch   regexScratch;
+};
+
+/// The loop shared by scanStream and scanStreamInverted. With `Invert`
+/// set, runs of lines without hits go to `lines.onLines()` instead of the
+/// matching lines going to `lines.onMatch()`.
+template <bool Invert, typename Input, typename MatcherPolicy, typename LinePolicy>
+void scanBlocks(Input& in, const MatcherPolicy& matcher, LinePolicy& lines,
+                ScanBuffer& buffer, const ScanLimits& limits)
+{
+    constexpr size_t npos = std::string_view::npos;
+    constexpr bool findAllHits = !Invert && kFindsAllHits<LinePolicy>;
+
+    const size_t capacity = std::max(limits.bufferSize, kMinBufferSize);
+    // Bytes of a window carried into the next one: room for a hit starting
+    // in the last maxMatchLength() - 1 bytes, plus one byte of context so
+    // that ^ and \b know what precedes the new window
+    const size_t carry = std::min(matcher.maxMatchLength(), capacity / 2);
+    const size_t windowFrom = carry > 0 ? 1 : 0;
+
+    buffer.data.resize(capacity);
+    char* const data = buffer.data.data();
+
+    std::optional<StepBudget> budget;
+    if (limits.stepBudget > 0 || limits.timeBudget > std::chrono::steady_clock::duration::zero())
+    {
+        budget.emplace(limits.stepBudget, limits.timeBudget);
+    }
+    const FindContext lineContext{false, budget ? &*budget : nullptr, &buffer.regexScratch};
+    const FindContext windowContext{true, lineContext.budget, lineContext.scratch};
+
+    size_t filled = 0;
+    size_t consumed = 0; // file offset of data[0]
+    size_t lineNumber = 0;
+    size_t length = 0;
+
+    // Over-long line state: whether one is being scanned, its file offset,
+    // the offset within it of data[0], the offset of its first hit and
+    // where within it the search resumes
+    bool   inLongLine = false;
+    size_t longLineStart = 0;
+    size_t windowOffset = 0;
+    size_t longLineHit = npos;
+    size_t longLineNext = 0;
+
+    auto report = [&](std::string_view text, size_t byteOffset, size_t lineLength, size_t hit)
+    {
+        text = text.substr(0, limits.maxLineLength);
+        std::span<const Span> spans;
+        if constexpr (!Invert && kCollectsSpans<LinePolicy>)
+        {
+            spans = buffer.spans;
+        }
+        lines.onMatch(MatchedLine{lineNumber, byteOffset, text, lineLength, hit,
+                                  text.size() < lineLength, spans});
+    };
+
+    // Record the hit at `hit` and every later one in `text` as spans at
+    // `base` plus their position (and hand them to onHit), and return where
+    // the search resumes. In a
+    // window that ends mid-line, a hit reaching the window end that the next
+    // window searches again is left to that window, which sees all of it.
+    auto collectSpans = [&](std::string_view text, size_t hit, size_t base, bool lineContinues)
+    {
+        const size_t searchedAgain = text.size() - std::min(text.size(), carry) + windowFrom;
+        size_t next = hit;
+        while (hit != npos)
+        {
+            if (lineContinues && hit + length == text.size() && hit >= searchedAgain)
+            {
+                return base + hit;
+            }
+            if (length > 0)
+            {
+                if constexpr (kCollectsSpans<LinePolicy>)
+                {
+                    buffer.spans.push_back(Span{base + hit, length});
+                }
+                if constexpr (kReceivesHits<LinePolicy>)
+                {
+                    lines.onHit(lineNumber, text.substr(hit, length));
+                }
+            }
+            next = hit + std::max<size_t>(length, 1);
+            if (next > text.size())
+            {
+                break;
+            }
+            hit = matcher.find(text, next, length, lineContinues ? windowContext : lineContext);
+        }
+        return base + next;
+    };
+
+    // Search a window of an over-long line, which is [0, size) of the buffer
+    auto searchWindow = [&](size_t size, bool lineContinues)
+    {
+        size_t from = 0;
+        if (!inLongLine)
+        {
+            ++lineNumber;
+            inLongLine = true;
+            longLineStart = consumed;
+            windowOffset = 0;
+            longLineHit = npos;
+            longLineNext = 0;
+            buffer.spans.clear();
+            buffer.longLineHead.assign(data, std::min(size, limits.maxLineLength));
+        }
+        else
+        {
+            if (longLineHit != npos && !findAllHits)
+            {
+                return;
+            }
+            from = std::max(windowFrom, longLineNext > windowOffset ? longLineNext - windowOffset : 0);
+            if (from >= size)
+            {
+                return;
+            }
+        }
+
+        std::string_view window(data, size);
+        size_t hit = matcher.find(window, from, length, lineContinues ? windowContext : lineContext);
+        if (hit == npos)
+        {
+            return;
+        }
+        if (longLineHit == npos)
+        {
+            longLineHit = windowOffset + hit;
+        }
+        if constexpr (findAllHits)
+        {
+            longLineNext = collectSpans(window, hit, windowOffset, lineContinues);
+        }
+    };
+
+    // Handle the line ending at data[end], which starts at data[begin]
+    auto endLine = [&](size_t begin, size_t end)
+    {
+        if (end > begin && data[end - 1] == '\r') // to handle Windows-style line endings
+        {
+            --end;
+        }
+        if (!inLongLine)
+        {
+            ++lineNumber;
+            std::string_view line(data + begin, end - begin);
+            size_t hit = matcher.find(line, 0, length, lineContext);
+            if (hit != npos)
+            {
+                if constexpr (findAllHits)
+                {
+                    buffer.spans.clear();
+                    collectSpans(line, hit, 0, false);
+                }
+                report(line, consumed + begin, line.size(), hit);
+            }
+            return;
+        }
+        // Last window of an over-long line, which always starts at data[0]
+        searchWindow(end, false);
+        if (Invert ? longLineHit == npos : longLineHit != npos)
+        {
+            report(buffer.longLineHead, longLineStart, windowOffset + end, Invert ? 0 : longLineHit);
+        }
+        inLongLine = false;
+    };
+
+    // Search the complete lines data[begin, end) as one block; each hit
+    // locates a line that endLine() then searches on its own, as the hit may
+    // take in the '\r' of a line ending
+    auto searchBlock = [&](size_t begin, size_t end)
+    {
+        const std::string_view block(data + begin, end - begin);
+        size_t from = 0; // start of the lines not handed to endLine() yet
+        size_t hit = 0;
+        while (from < block.size() && (hit = matcher.find(block, from, length, lineContext)) < block.size())
+        {
+            size_t lineStart = hit > from ? block.rfind('\n', hit - 1) : npos;
+            lineStart = lineStart == npos || lineStart < from ? from : lineStart + 1;
+            size_t lineEnd = block.find('\n', hit);
+            lineNumber += countLines(block.substr(from, lineStart - from));
+            endLine(begin + lineStart, begin + lineEnd);
+            from = lineEnd + 1;
+        }
+        lineNumber += countLines(block.substr(from));
+    };
+
+    // Invert mode: hand the lines of data[begin, end) without hits to
+    // lines.onLines() in runs. When no hit can span lines the block is
+    // searched as a whole, so a block with few hits costs one matcher scan.
+    auto invertBlock = [&](size_t begin, size_t end)
+    {
+        const std::string_view block(data + begin, end - begin);
+        size_t pending = 0;              // start of the lines not handed over yet
+        size_t pendingLine = lineNumber + 1;
+
+        auto flush = [&](size_t upTo)
+        {
+            if (upTo > pending)
+            {
+                std::string_view run = block.substr(pending, upTo - pending);
+                if constexpr (Invert)
+                {
+                    lines.onLines(LineBlock{pendingLine, consumed + begin + pending, run});
+                }
+                pendingLine += countLines(run);
+                pending = upTo;
+            }
+        };
+        auto skipLine = [&](size_t lineStart, size_t lineEnd)
+        {
+            flush(lineStart);
+            ++pendingLine;
+            pending = lineEnd;
+        };
+        // The line block[start, lineEnd) without its line ending
+        auto lineText = [&](size_t start, size_t lineEnd)
+        {
+            std::string_view line = block.substr(start, lineEnd - start);
+            if (!line.empty() && line.back() == '\n')
+            {
+                line.remove_suffix(1);
+            }
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            return line;
+        };
+
+        if (matcher.hitsStayInLine())
+        {
+            // An empty hit may end an unterminated last line, as in scanBlocks
+            const size_t lastHit = block.back() == '\n' ? block.size() - 1 : block.size();
+            size_t from = 0;
+            size_t hit = 0;
+            while (from < block.size() && (hit = matcher.find(block, from, length, lineContext)) <= lastHit)
+            {
+                size_t lineStart = block.substr(0, hit).rfind('\n');
+                lineStart = lineStart == npos ? 0 : lineStart + 1;
+                size_t lineEnd = std::min(block.find('\n', hit), block.size() - 1) + 1;
+                // As in searchBlock(), the hit may take in the '\r' of a line
+                // ending, so such a line is searched again on its own
+                std::string_view line = lineText(lineStart, lineEnd);
+                if (lineStart + line.size() + 1 == lineEnd || matcher.find(line, 0, length, lineContext) != npos)
+                {
+                    skipLine(lineStart, lineEnd);
+                }
+                from = lineEnd;
+            }
+        }
+        else
+        {
+            for (size_t start = 0; start < block.size();)
+            {
+                size_t lineEnd = std::min(block.find('\n', start), block.size() - 1) + 1;
+                if (matcher.find(lineText(start, lineEnd), 0, length, lineContext) != npos)
+                {
+                    skipLine(start, lineEnd);
+                }
+                start = lineEnd;
+            }
+        }
+        flush(block.size());
+        lineNumber = pendingLine - 1;
+    };
+
+    while (true)
+    {
+        if (limits.stop.stop_requested())
+        {
+            return;
+        }
+        if (budget)
+        {
+            budget->checkTime();
+        }
+        bool atEnd = false;
+        filled += readInput(in, data + filled, capacity - filled, atEnd);
+
+        size_t begin = 0;
+        if constexpr (Invert)
+        {
+            // Finish an over-long line, then take all complete lines at once
+            if (const void* newline = inLongLine ? std::memchr(data, '\n', filled) : nullptr)
+            {
+                size_t end = static_cast<size_t>(static_cast<const char*>(newline) - data);
+                endLine(0, end);
+                begin = end + 1;
+            }
+            size_t lastNewline = inLongLine ? npos : std::string_view(data + begin, filled - begin).rfind('\n');
+            if (lastNewline != npos)
+            {
+                invertBlock(begin, begin + lastNewline + 1);
+                begin += lastNewline + 1;
+            }
+        }
+        else
+        {
+            if (inLongLine)
+            {
+                if (const void* newline = std::memchr(data, '\n', filled))
+                {
+                    size_t end = static_cast<size_t>(static_cast<const char*>(newline) - data);
+                    endLine(0, end);
+                    begin = end + 1;
+                }
+            }
+            if (!inLongLine && matcher.hitsStayInLine())
+            {
+                // Search all complete lines as one block and only split out
+                // the lines around hits, so a block without hits costs one
+                // matcher scan and one newline count
+                size_t lastNewline = std::string_view(data + begin, filled - begin).rfind('\n');
+                if (lastNewline != npos)
+                {
+                    searchBlock(begin, begin + lastNewline + 1);
+                    begin += lastNewline + 1;
+                }
+            }
+            while (const void* newline = std::memchr(data + begin, '\n', filled - begin))
+            {
+                size_t end = static_cast<size_t>(static_cast<const char*>(newline) - data);
+                endLine(begin, end);
+                begin = end + 1;
+            }
+        }
+
+        if (atEnd)
+        {
+            // A last line without a trailing newline
+            if (inLongLine)
+            {
+                endLine(begin, filled);
+            }
+            else if (begin < filled)
+            {
+                if constexpr (Invert)
+                {
+                    invertBlock(begin, filled);
+                }
+                else
+                {
+                    endLine(begin, filled);
+                }
+            }
+            return;
+        }
+
+        if (begin == 0 && filled == capacity)
+        {
+            // No newline in a full buffer: search this window of the line
+            // and keep only its tail
+            searchWindow(filled, true);
+            windowOffset += filled - carry;
+            consumed += filled - carry;
+            std::memmove(data, data + filled - carry, carry);
+            filled = carry;
+        }
+        else
+        {
+            consumed += begin;
+            std::memmove(data, data + begin, filled - begin);
+            filled -= begin;
+        }
+    }
+}
+
+/// Scan `in` (an std::istream or a FileInput) line by line, handing every
+/// line that contains a hit of `matcher` to `lines`. Trailing '\r' of
+/// Windows line endings is stripped.
+///
+/// Input is read in blocks into `buffer`, and lines are searched in place,
+/// so memory use is bounded by `limits` whatever the input looks like. A
+/// line that does not fit the buffer (e.g. minified JSON) is searched in
+/// windows that overlap by the matcher's maxMatchLength(); only its head is
+/// kept for reporting. With a budget in `limits`, the scan throws
+/// SearchBudgetExceeded once it is used up; lines handed over until then
+/// stay valid.
+template <typename Input, typename MatcherPolicy, typename LinePolicy>
+void scanStream(Input& in, const MatcherPolicy& matcher, LinePolicy& lines,
+                ScanBuffer& buffer, const ScanLimits& limits = {})
+{
+    scanBlocks<false>(in, matcher, lines, buffer, limits);
+}
+
+/// Scan `in` for the lines that do not contain a hit of `matcher` (grep -v).
+/// They are handed to `lines.onLines()` as LineBlocks of consecutive lines,
+/// raw as in the file, except lines that do not fit the buffer, which go to
+/// `lines.onMatch()` cut to their head like in scanStream.
+template <typename Input, typename MatcherPolicy, typename LinePolicy>
+void scanStreamInverted(Input& in, const MatcherPolicy& matcher, LinePolicy& lines,
+                        ScanBuffer& buffer, const ScanLimits& limits = {})
+{
+    scanBlocks<true>(in, matcher, lines, buffer, limits);
+}
+
+/// Run scanStream with whichever policy `matcher` holds. The variant is
+/// resolved once per call (i.e. per file), never per line.
+template <typename Input, typename LinePolicy>
+void scanStream(Input& in, const QueryMatcher& matcher, LinePolicy& lines,
+                ScanBuffer& buffer, const ScanLimits& limits = {})
+{
+    std::visit([&](const auto& policy) { scanStream(in, policy, lines, buffer, limits); }, matcher);
+}
+
+/// Run scanStreamInverted with whichever policy `matcher` holds.
+template <typename Input, typename LinePolicy>
+void scanStreamInverted(Input& in, const QueryMatcher& matcher, LinePolicy& lines,
+                        ScanBuffer& buffer, const ScanLimits& limits = {})
+{
+    std::visit([&](const auto& policy) { scanStreamInverted(in, policy, lines, buffer, limits); }, matcher);
+}
+
+} // namespace cgrep
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CustomGrep.h"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cgrep
+{
+
+/// One query searched for repeatedly with the same options, e.g. by a
+/// long-lived service: the query is compiled once (see CompiledQuery), and
+/// the scan buffers of the searches, one per worker thread, are allocated
+/// by the first search and reused by the later ones. A session runs one
+/// search at a time; sessions of several threads can share their query by
+/// copying compiled() into sessions of their own.
+class SearchSession
+{
+public:
+    /// Compile `query` for `options`; throws std::invalid_argument for a
+    /// query the searches would reject.
+    explicit SearchSession(const std::string& query, const SearchOptions& options = {});
+    /// Search for a query compiled already, which must match like `options`.
+    SearchSession(CompiledQuery query, const SearchOptions& options);
+
+    [[nodiscard]] const CompiledQuery& compiled() const { return m_query; }
+    [[nodiscard]] const CustomGrep& grep() const { return m_grep; }
+
+    /// As the CustomGrep searches of the same name.
+    [[nodiscard]] MatchList parallelSearch(const std::vector<std::filesystem::path>& all_files);
+    [[nodiscard]] MatchList parallelSearch(const FileTable& all_files);
+    size_t parallelSearch(const std::vector<std::filesystem::path>& all_files,
+                          const std::function<void(const Match&)>& sink);
+    size_t parallelSearch(const FileTable& all_files, const std::function<void(const Match&)>& sink);
+    [[nodiscard]] MatchList searchInFile(const std::filesystem::path& filePath);
+    [[nodiscard]] size_t countInFile(const std::filesystem::path& filePath);
+
+    /// Hand each matching line of the file at `filePath` to `sink` as soon
+    /// as the scan finds it, as a Match that views the scan buffer and only
+    /// lives during the call, so nothing is copied. `sink` returns false to
+    /// stop the search. Returns the number of lines handed over.
+    size_t scanFile(const std::filesystem::path& filePath, const std::function<bool(const Match&)>& sink);
+    /// Like scanFile, for the bytes of `data`, reported as the file `name`.
+    size_t scanBuffer(std::string_view data, const std::filesystem::path& name,
+                      const std::function<bool(const Match&)>& sink);
+
+private:
+    ScanBuffer& singleFileBuffer();
+
+    CustomGrep              m_grep;
+    CompiledQuery           m_query;
+    std::vector<ScanBuffer> m_buffers; // one per worker; the first also serves single files
+};
+
+} // namespace cgrep
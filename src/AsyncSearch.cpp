@@ -0,0 +1,83 @@
+#include "AsyncSearch.h"
+
+#include <utility>
+
+namespace cgrep
+{
+
+AsyncSearch::AsyncSearch(std::shared_ptr<SearchControl> control, const std::stop_token& stop)
+    : m_control(std::move(control))
+{
+    // Registered before the search starts, so a token that was already
+    // stopped keeps the workers from searching any file
+    if (stop.stop_possible())
+    {
+        m_forward = std::make_unique<std::stop_callback<ForwardStop>>(stop, ForwardStop{m_control->stop});
+    }
+}
+
+AsyncSearch::~AsyncSearch()
+{
+    if (m_result.valid())
+    {
+        cancel();
+        m_result.wait();
+    }
+}
+
+AsyncSearch& AsyncSearch::operator=(AsyncSearch&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_result.valid())
+        {
+            cancel();
+            m_result.wait();
+        }
+        m_result = std::move(other.m_result);
+        m_forward = std::move(other.m_forward);
+        m_control = std::move(other.m_control);
+    }
+    return *this;
+}
+
+MatchList AsyncSearch::get()
+{
+    return m_result.get();
+}
+
+void AsyncSearch::wait() const
+{
+    m_result.wait();
+}
+
+bool AsyncSearch::waitFor(std::chrono::milliseconds timeout) const
+{
+    return m_result.wait_for(timeout) == std::future_status::ready;
+}
+
+SearchProgress AsyncSearch::progress() const
+{
+    if (!m_control)
+    {
+        return {};
+    }
+    return SearchProgress{m_control->filesSearched.load(std::memory_order_relaxed),
+                          m_control->totalFiles,
+                          m_control->matches.load(std::memory_order_relaxed)};
+}
+
+void AsyncSearch::cancel()
+{
+    if (m_control)
+    {
+        m_control->stop.request_stop();
+    }
+}
+
+bool AsyncSearch::cancelRequested() const
+{
+    return m_control && m_control->stop.stop_requested();
+}
+
+} // namespace cgrep
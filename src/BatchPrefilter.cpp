@@ -0,0 +1,120 @@
+#include "BatchPrefilter.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace cgrep
+{
+
+void BatchPrefilter::addLiteral(size_t query, std::string literal, bool asciiCaseInsensitive)
+{
+    if (literal.empty())
+    {
+        addAlways(query);
+        return;
+    }
+    m_queryCount = std::max(m_queryCount, query + 1);
+    if (asciiCaseInsensitive)
+    {
+        // Lowercased as the matcher does, so that equal and prefix literals are found
+        std::transform(literal.begin(), literal.end(), literal.begin(),
+                       [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; });
+        add(m_caseless, query, std::move(literal));
+    }
+    else
+    {
+        add(m_exact, query, std::move(literal));
+    }
+}
+
+void BatchPrefilter::addAlways(size_t query)
+{
+    m_queryCount = std::max(m_queryCount, query + 1);
+    m_always.push_back(query);
+}
+
+void BatchPrefilter::add(Literals& literals, size_t query, std::string literal)
+{
+    auto it = std::find(literals.patterns.begin(), literals.patterns.end(), literal);
+    if (it != literals.patterns.end())
+    {
+        literals.queries[static_cast<size_t>(it - literals.patterns.begin())].push_back(query);
+        return;
+    }
+    literals.patterns.push_back(std::move(literal));
+    literals.queries.push_back({ query });
+}
+
+void BatchPrefilter::build()
+{
+    build(m_exact, false);
+    build(m_caseless, true);
+}
+
+void BatchPrefilter::build(Literals& literals, bool asciiCaseInsensitive)
+{
+    const auto& patterns = literals.patterns;
+    if (patterns.empty())
+    {
+        return;
+    }
+    literals.prefixes.assign(patterns.size(), {});
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        for (size_t k = 0; k < patterns.size(); ++k)
+        {
+            if (k != i && patterns[i].starts_with(patterns[k]))
+            {
+                literals.prefixes[i].push_back(k);
+            }
+        }
+    }
+    literals.matcher.emplace(patterns, asciiCaseInsensitive);
+}
+
+void BatchPrefilter::select(std::string_view text, std::vector<bool>& selected) const
+{
+    selected.assign(m_queryCount, false);
+    for (size_t query : m_always)
+    {
+        selected[query] = true;
+    }
+    select(m_exact, text, selected);
+    select(m_caseless, text, selected);
+}
+
+void BatchPrefilter::select(const Literals& literals, std::string_view text, std::vector<bool>& selected)
+{
+    if (!literals.matcher)
+    {
+        return;
+    }
+    std::vector<bool> found(literals.patterns.size(), false);
+    size_t remaining = literals.patterns.size();
+    auto mark = [&](size_t pattern)
+    {
+        if (!found[pattern])
+        {
+            found[pattern] = true;
+            --remaining;
+            for (size_t query : literals.queries[pattern])
+            {
+                selected[query] = true;
+            }
+        }
+    };
+
+    // Every position holding a literal is visited, so literals found inside
+    // or overlapping others are seen too; stop once all are found
+    MultiLiteralMatcher::Hit hit;
+    for (size_t from = 0; remaining > 0 && literals.matcher->find(text, from, hit); from = hit.position + 1)
+    {
+        mark(hit.pattern);
+        for (size_t prefix : literals.prefixes[hit.pattern])
+        {
+            mark(prefix);
+        }
+    }
+}
+
+} // namespace cgrep
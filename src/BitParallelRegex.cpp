@@ -0,0 +1,401 @@
+#include "BitParallelRegex.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace cgrep
+{
+
+namespace
+{
+
+// Glushkov construction: every byte set of the tree becomes a numbered
+// position; a subexpression is summarized by the positions a hit of it can
+// start and end with, and whether it matches the empty string.
+struct Fragment
+{
+    uint64_t first = 0;
+    uint64_t last = 0;
+    bool     nullable = true;
+};
+
+class GlushkovBuilder
+{
+public:
+    // Build `node`, or return false if it needs more than kMaxPositions
+    // positions or holds an assertion
+    bool build(const RegexNode& node, Fragment& fragment)
+    {
+        switch (node.kind)
+        {
+            case RegexNode::Kind::Empty:
+                fragment = Fragment{};
+                return true;
+            case RegexNode::Kind::Bytes:
+            {
+                if (positions.size() == BitParallelRegex::kMaxPositions)
+                {
+                    return false;
+                }
+                uint64_t bit = uint64_t{1} << positions.size();
+                positions.push_back(node.bytes);
+                fragment = Fragment{bit, bit, false};
+                return true;
+            }
+            case RegexNode::Kind::Group:
+                return build(node.children.front(), fragment);
+            case RegexNode::Kind::Concat:
+            {
+                fragment = Fragment{};
+                for (const auto& child : node.children)
+                {
+                    Fragment next;
+                    if (!build(child, next))
+                    {
+                        return false;
+                    }
+                    fragment = concat(fragment, next);
+                }
+                return true;
+            }
+            case RegexNode::Kind::Alternate:
+            {
+                fragment = Fragment{0, 0, false};
+                for (const auto& child : node.children)
+                {
+                    Fragment next;
+                    if (!build(child, next))
+                    {
+                        return false;
+                    }
+                    fragment.first |= next.first;
+                    fragment.last |= next.last;
+                    fragment.nullable = fragment.nullable || next.nullable;
+                }
+                return true;
+            }
+            case RegexNode::Kind::Repeat:
+                return buildRepeat(node, fragment);
+            default:
+                return false; // assertions
+        }
+    }
+
+    std::vector<ByteSet>  positions;
+    std::vector<uint64_t> follow;
+    bool                  cyclic = false;
+
+private:
+    void link(uint64_t from, uint64_t to)
+    {
+        follow.resize(positions.size(), 0);
+        for (; from != 0; from &= from - 1)
+        {
+            follow[static_cast<size_t>(std::countr_zero(from))] |= to;
+        }
+    }
+
+    Fragment concat(const Fragment& a, const Fragment& b)
+    {
+        link(a.last, b.first);
+        return Fragment{a.first | (a.nullable ? b.first : 0),
+                        b.last | (b.nullable ? a.last : 0),
+                        a.nullable && b.nullable};
+    }
+
+    // x{min,max} is built as min copies of x followed by max - min optional
+    // copies, or by a looping copy if max is unbounded
+    bool buildRepeat(const RegexNode& node, Fragment& fragment)
+    {
+        const RegexNode& child = node.children.front();
+        size_t before = positions.size();
+        Fragment copy;
+        if (!build(child, copy))
+        {
+            return false;
+        }
+        if (positions.size() == before || node.max == 0)
+        {
+            // No bytes to repeat (e.g. `()*`), or `x{0}`; the copy's
+            // positions can never be reached again from outside it
+            fragment = node.max == 0 ? Fragment{} : copy;
+            fragment.nullable = fragment.nullable || node.min == 0;
+            if (node.max == 0)
+            {
+                positions.resize(before);
+                follow.resize(before);
+            }
+            return true;
+        }
+
+        fragment = Fragment{};
+        size_t copies = std::max<size_t>(node.min, 1);
+        if (node.max != RegexNode::kUnbounded)
+        {
+            copies = node.max;
+        }
+        for (size_t i = 0; i < copies; ++i)
+        {
+            if (i > 0 && !build(child, copy))
+            {
+                return false;
+            }
+            bool optional = i >= node.min;
+            if (node.max == RegexNode::kUnbounded && i + 1 == copies)
+            {
+                link(copy.last, copy.first);
+                cyclic = true;
+            }
+            if (optional)
+            {
+                copy.nullable = true;
+            }
+            fragment = concat(fragment, copy);
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+std::optional<BitParallelRegex> BitParallelRegex::compile(const RegexNode& root)
+{
+    BitParallelRegex regex;
+
+    // Only a ^ at the very start and a $ at the very end are supported
+    const RegexNode* body = &root;
+    RegexNode trimmed;
+    if (root.kind == RegexNode::Kind::LineStart || root.kind == RegexNode::Kind::LineEnd)
+    {
+        regex.m_startAnchored = root.kind == RegexNode::Kind::LineStart;
+        regex.m_endAnchored = root.kind == RegexNode::Kind::LineEnd;
+        body = &trimmed;
+    }
+    else if (root.kind == RegexNode::Kind::Concat)
+    {
+        auto first = root.children.begin();
+        auto last = root.children.end();
+        if (first->kind == RegexNode::Kind::LineStart)
+        {
+            regex.m_startAnchored = true;
+            ++first;
+        }
+        if (first != last && std::prev(last)->kind == RegexNode::Kind::LineEnd)
+        {
+            regex.m_endAnchored = true;
+            --last;
+        }
+        trimmed.kind = RegexNode::Kind::Concat;
+        trimmed.children.assign(first, last);
+        body = &trimmed;
+    }
+
+    GlushkovBuilder builder;
+    Fragment fragment;
+    if (!builder.build(*body, fragment))
+    {
+        return std::nullopt;
+    }
+    builder.follow.resize(builder.positions.size(), 0);
+
+    regex.m_positions = builder.positions.size();
+    regex.m_first = fragment.first;
+    regex.m_last = fragment.last;
+    regex.m_nullable = fragment.nullable;
+    regex.m_maxLength = builder.cyclic ? RegexNode::kUnbounded : regex.m_positions;
+
+    for (size_t p = 0; p < regex.m_positions; ++p)
+    {
+        regex.m_follow[p] = builder.follow[p];
+        for (unsigned c = 0; c < 256; ++c)
+        {
+            if (c != '\n' && builder.positions[p].test(c))
+            {
+                regex.m_masks[c] |= uint64_t{1} << p;
+            }
+        }
+    }
+    for (unsigned c = 0; c < 256; ++c)
+    {
+        regex.m_startBytes[c] = (regex.m_masks[c] & regex.m_first) != 0;
+    }
+    if (std::count(regex.m_startBytes.begin(), regex.m_startBytes.end(), true) == 1)
+    {
+        auto single = std::find(regex.m_startBytes.begin(), regex.m_startBytes.end(), true);
+        regex.m_singleStartByte = static_cast<int>(single - regex.m_startBytes.begin());
+    }
+
+    // A plain sequence of positions steps by shifting the state word
+    regex.m_shiftAnd = regex.m_positions > 0 && regex.m_first == 1 &&
+                       regex.m_last == uint64_t{1} << (regex.m_positions - 1);
+    for (size_t p = 0; regex.m_shiftAnd && p < regex.m_positions; ++p)
+    {
+        uint64_t expected = p + 1 < regex.m_positions ? uint64_t{1} << (p + 1) : 0;
+        regex.m_shiftAnd = regex.m_follow[p] == expected;
+    }
+
+    regex.m_followChunks = (regex.m_positions + 7) / 8;
+    regex.m_followTable.assign(regex.m_followChunks * 256, 0);
+    for (size_t chunk = 0; chunk < regex.m_followChunks; ++chunk)
+    {
+        for (unsigned byte = 0; byte < 256; ++byte)
+        {
+            uint64_t next = 0;
+            for (unsigned bit = 0; bit < 8; ++bit)
+            {
+                size_t p = chunk * 8 + bit;
+                if ((byte >> bit & 1) != 0 && p < regex.m_positions)
+                {
+                    next |= regex.m_follow[p];
+                }
+            }
+            regex.m_followTable[chunk * 256 + byte] = next;
+        }
+    }
+    return regex;
+}
+
+size_t BitParallelRegex::find(std::string_view text, size_t from, size_t& length, bool lineContinues) const
+{
+    constexpr size_t npos = std::string_view::npos;
+    if (from > text.size() || (m_startAnchored && from > 0))
+    {
+        return npos;
+    }
+    if (m_nullable)
+    {
+        // The empty string may match right away
+        return findLeftmostLongest(text, from, length, lineContinues);
+    }
+
+    // First pass: run the automaton with hits starting everywhere until one
+    // ends, remembering the last position where no hit was in progress; the
+    // leftmost hit starts there or later
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    uint64_t states = 0;
+    size_t quiet = from;
+    for (size_t i = from; i < text.size(); ++i)
+    {
+        if (states == 0)
+        {
+            if (m_startAnchored && i > 0)
+            {
+                return npos;
+            }
+            if (m_singleStartByte >= 0)
+            {
+                const auto* next = static_cast<const unsigned char*>(
+                    std::memchr(bytes + i, m_singleStartByte, text.size() - i));
+                i = next == nullptr ? text.size() : static_cast<size_t>(next - bytes);
+            }
+            while (i < text.size() && !m_startBytes[bytes[i]])
+            {
+                ++i;
+            }
+            if (i == text.size())
+            {
+                return npos;
+            }
+            quiet = i;
+        }
+        uint64_t inject = (!m_startAnchored || i == 0) ? m_first : 0;
+        states = (follow(states) | inject) & m_masks[bytes[i]];
+        if ((states & m_last) != 0 && endAllowed(text, i + 1, lineContinues))
+        {
+            return findLeftmostLongest(text, quiet, length, lineContinues);
+        }
+    }
+    return npos;
+}
+
+size_t BitParallelRegex::findLeftmostLongest(std::string_view text, size_t begin, size_t& length,
+                                             bool lineContinues) const
+{
+    constexpr size_t npos = std::string_view::npos;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+
+    // Earliest start among the hits in progress at each position; hits that
+    // reach the same position continue identically, so only it matters
+    std::array<size_t, kMaxPositions> starts;
+    std::array<size_t, kMaxPositions> nextStarts;
+    uint64_t states = 0;
+    size_t bestStart = npos;
+    size_t bestEnd = 0;
+
+    for (size_t i = begin;; ++i)
+    {
+        // New hits may start here until one is found
+        bool startHere = bestStart == npos && (!m_startAnchored || i == 0);
+        if (startHere && m_nullable && endAllowed(text, i, lineContinues))
+        {
+            bestStart = i;
+            bestEnd = i;
+        }
+        if (i == text.size() || (states == 0 && !startHere && (bestStart != npos || m_startAnchored)))
+        {
+            break;
+        }
+
+        const uint64_t mask = m_masks[bytes[i]];
+        uint64_t next = 0;
+        for (uint64_t active = states; active != 0; active &= active - 1)
+        {
+            size_t p = static_cast<size_t>(std::countr_zero(active));
+            for (uint64_t targets = m_follow[p] & mask & ~next; targets != 0; targets &= targets - 1)
+            {
+                nextStarts[static_cast<size_t>(std::countr_zero(targets))] = starts[p];
+            }
+            for (uint64_t targets = m_follow[p] & mask & next; targets != 0; targets &= targets - 1)
+            {
+                size_t q = static_cast<size_t>(std::countr_zero(targets));
+                nextStarts[q] = std::min(nextStarts[q], starts[p]);
+            }
+            next |= m_follow[p] & mask;
+        }
+        if (startHere)
+        {
+            for (uint64_t targets = m_first & mask & ~next; targets != 0; targets &= targets - 1)
+            {
+                nextStarts[static_cast<size_t>(std::countr_zero(targets))] = i;
+            }
+            next |= m_first & mask;
+        }
+
+        // Hits starting after the best one found can never beat it
+        if (bestStart != npos)
+        {
+            for (uint64_t active = next; active != 0; active &= active - 1)
+            {
+                size_t q = static_cast<size_t>(std::countr_zero(active));
+                if (nextStarts[q] > bestStart)
+                {
+                    next &= ~(uint64_t{1} << q);
+                }
+            }
+        }
+
+        states = next;
+        std::swap(starts, nextStarts);
+        if ((states & m_last) != 0 && endAllowed(text, i + 1, lineContinues))
+        {
+            for (uint64_t accepted = states & m_last; accepted != 0; accepted &= accepted - 1)
+            {
+                size_t start = starts[static_cast<size_t>(std::countr_zero(accepted))];
+                if (start < bestStart || (start == bestStart && i + 1 > bestEnd))
+                {
+                    bestStart = start;
+                    bestEnd = i + 1;
+                }
+            }
+        }
+    }
+
+    if (bestStart != npos)
+    {
+        length = bestEnd - bestStart;
+    }
+    return bestStart;
+}
+
+} // namespace cgrep
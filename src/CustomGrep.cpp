@@ -1,28 +1,301 @@
 #include "CustomGrep.h"
+#include "BatchPrefilter.h"
+#include "RegexAnalysis.h"
+#include "RegexParser.h"
 
-#include <fstream>
 #include <thread>
 #include <algorithm>
+#include <cctype>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <regex>
 #include <iostream>
+#include <stdexcept>
 #include <system_error>
 
 namespace cgrep
 {
 
-// Helper: lowercase an ASCII string in place.
-static void lowercaseInPlace(std::string& s)
+// Helper: if the regex `query` is nothing but literal alternatives such as
+// `foo|bar|baz` (metacharacters may be escaped), store the alternatives in
+// `literals` and return true. Not for BRE, where '|' is a literal byte.
+static bool splitLiteralAlternation(const std::string& query, RegexSyntax syntax,
+                                    std::vector<std::string>& literals)
 {
-    std::transform(
-        s.begin(), s.end(),
-        s.begin(),
-        [](unsigned char c){ return static_cast<char>(std::tolower(c)); }
-    );
+    // The GNU anchors \< \> \` \' of ERE are escaped punctuation too
+    static constexpr std::string_view kPosixAnchors = "<>`'";
+    static constexpr std::string_view kMetaCharacters = "^$.|?*+()[]{}";
+    std::string current;
+    for (size_t i = 0; i < query.size(); ++i)
+    {
+        char c = query[i];
+        if (c == '\\')
+        {
+            // Escaped punctuation is literal; \d, \b, \1 and friends are not
+            if (i + 1 == query.size() || std::isalnum(static_cast<unsigned char>(query[i + 1])) ||
+                (syntax != RegexSyntax::ECMAScript && kPosixAnchors.find(query[i + 1]) != std::string_view::npos))
+            {
+                return false;
+            }
+            current += query[++i];
+        }
+        else if (c == '|')
+        {
+            literals.push_back(std::move(current));
+            current.clear();
+        }
+        else if (kMetaCharacters.find(c) != std::string_view::npos)
+        {
+            return false;
+        }
+        else
+        {
+            current += c;
+        }
+    }
+    literals.push_back(std::move(current));
+    return literals.size() > 1;
+}
+
+// Helper: the path of file `index` of a file list. FileTable paths are
+// rebuilt into the calling worker's `scratch`.
+static const std::filesystem::path& filePathAt(const std::vector<std::filesystem::path>& files, size_t index,
+                                               std::filesystem::path& /*scratch*/)
+{
+    return files[index];
+}
+
+static const std::filesystem::path& filePathAt(const FileTable& files, size_t index,
+                                               std::filesystem::path& scratch)
+{
+    files.pathInto(index, scratch);
+    return scratch;
+}
+
+namespace
+{
+
+// Line policy of parallelSearchLazy: EmitLines that hands its list over to
+// `channel` whenever it holds `batchSize` matches, and at the end of a file
+struct FeedLines : EmitLines
+{
+    MatchChannel&          channel;
+    size_t                 batchSize;
+    const std::stop_token& stop;
+
+    void onMatch(const MatchedLine& line)
+    {
+        EmitLines::onMatch(line);
+        if (results.size() >= batchSize)
+        {
+            handOver();
+        }
+    }
+
+    void onLines(const LineBlock& block)
+    {
+        EmitLines::onLines(block);
+        if (results.size() >= batchSize)
+        {
+            handOver();
+        }
+    }
+
+    void handOver()
+    {
+        if (!results.empty())
+        {
+            channel.push(std::move(results), stop);
+            results = MatchList{};
+            storedPath = {};
+        }
+    }
+};
+
+// Line policy of the SearchSession scans: hands every matching line to
+// `sink` as a Match viewing the scan buffer, until the sink asks to stop
+struct SinkLines
+{
+    static constexpr bool kCollectSpans = true;
+
+    const std::function<bool(const Match&)>& sink;
+    std::string_view                         path;
+    size_t                                   maxLineLength;
+    std::stop_source                         stop{};
+    size_t                                   count = 0;
+
+    void onMatch(const MatchedLine& line)
+    {
+        hand(Match{path, line.lineNumber, line.text, line.hitOffset, line.truncated, line.byteOffset, line.spans});
+    }
+
+    void onLines(const LineBlock& block)
+    {
+        size_t lineNumber = block.firstLineNumber;
+        for (size_t start = 0; start < block.text.size(); ++lineNumber)
+        {
+            size_t end = std::min(block.text.find('\n', start), block.text.size());
+            std::string_view line = block.text.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            hand(Match{path, lineNumber, line.substr(0, maxLineLength), 0, line.size() > maxLineLength,
+                       block.byteOffset + start, {}});
+            start = end + 1;
+        }
+    }
+
+    // The lines left in the buffer once the sink stopped the scan are dropped
+    void hand(const Match& match)
+    {
+        if (stop.stop_requested())
+        {
+            return;
+        }
+        ++count;
+        if (!sink(match))
+        {
+            stop.request_stop();
+        }
+    }
+};
+
+// A searchBatch worker's copy of the file being searched. It grows without
+// zero-filling the new room, and is kept for the next file only up to
+// `retained` bytes, so a worker does not hold on to an outsized file.
+struct FileContent
+{
+    std::unique_ptr<char[]> data;
+    size_t                  capacity = 0;
+    size_t                  size = 0;
+
+    [[nodiscard]] std::string_view view() const { return {data.get(), size}; }
+
+    void grow(size_t newCapacity)
+    {
+        auto grown = std::make_unique_for_overwrite<char[]>(newCapacity);
+        std::copy_n(data.get(), size, grown.get());
+        data = std::move(grown);
+        capacity = newCapacity;
+    }
+
+    void release(size_t retained)
+    {
+        size = 0;
+        if (capacity > retained)
+        {
+            data.reset();
+            capacity = 0;
+        }
+    }
+};
+
+} // namespace
+
+// Helper: report on stderr why `input` could not be opened.
+static void reportOpenError(const FileInput& input, const std::filesystem::path& filePath)
+{
+    std::error_code ec = input.error();
+
+    if (ec == std::errc::permission_denied)
+    {
+        std::cerr << "Permission denied, cannot access file: " << filePath.string() << "\n";
+    }
+    else
+    {
+        std::cerr << "Could not open file [" << filePath.string() << "]: " << ec.message() << "\n";
+    }
+}
+
+// Helper: read all of `input` into `content`, unless it holds more than
+// `limit` bytes. Returns whether it was read.
+static bool readWholeFile(FileInput& input, FileContent& content, size_t limit)
+{
+    // Room for the whole file and the read that finds its end, if it keeps
+    // the size it had when opened
+    content.size = 0;
+    size_t expected = std::min(std::max(input.sizeHint() + 1, size_t{64} << 10), limit + 1);
+    if (content.capacity < expected)
+    {
+        content.grow(expected);
+    }
+    bool atEnd = false;
+    while (!atEnd)
+    {
+        if (content.size == content.capacity)
+        {
+            if (content.size > limit)
+            {
+                return false;
+            }
+            content.grow(std::min(content.capacity * 2, limit + 1));
+        }
+        content.size += input.read(content.data.get() + content.size, content.capacity - content.size, atEnd);
+    }
+    return content.size <= limit;
+}
+
+// Helper: the longest run of `pattern` that a caseless search only matches
+// with ASCII letters of either case: ASCII bytes other than 'k' and 's',
+// which KELVIN SIGN and LONG S fold to (see FoldedLiteralMatcher).
+static std::string asciiFoldedRun(std::string_view pattern)
+{
+    std::string_view longest;
+    size_t start = 0;
+    for (size_t i = 0; i <= pattern.size(); ++i)
+    {
+        unsigned char c = i < pattern.size() ? static_cast<unsigned char>(pattern[i]) : 0x80;
+        if (c >= 0x80 || c == 'k' || c == 'K' || c == 's' || c == 'S')
+        {
+            if (i - start > longest.size())
+            {
+                longest = pattern.substr(start, i - start);
+            }
+            start = i + 1;
+        }
+    }
+    return std::string(longest);
+}
+
+// Helper: enter query `index` of a batch into `prefilter` with a literal
+// that all of its hits contain, if one is known; otherwise it is always
+// searched.
+static void addToPrefilter(BatchPrefilter& prefilter, size_t index, const BatchQuery& query, RegexSyntax syntax)
+{
+    if (!query.regexSearch)
+    {
+        if (query.ignoreCase)
+        {
+            prefilter.addLiteral(index, asciiFoldedRun(query.pattern), true);
+        }
+        else
+        {
+            prefilter.addLiteral(index, query.pattern);
+        }
+        return;
+    }
+
+    // The regexes std::regex runs are not analysed
+    auto tree = parseRegex(query.pattern, query.ignoreCase, syntax);
+    if (!tree)
+    {
+        prefilter.addAlways(index);
+        return;
+    }
+    RequiredLiteral required = findRequiredLiteral(*tree);
+    prefilter.addLiteral(index, std::move(required.bytes), required.asciiCaseInsensitive);
 }
 
 CustomGrep::CustomGrep(bool ignoreCase, bool regexSearch)
-    : m_ignoreCase(ignoreCase)
-    , m_regexSearch(regexSearch)
+    : CustomGrep(SearchOptions{ignoreCase, regexSearch})
+{
+}
+
+CustomGrep::CustomGrep(const SearchOptions& options)
+    : m_options(options)
 {
     // Determine how many threads to use. std::thread::hardware_concurrency()
     // may return 0 if the value is not well defined on a system. In that
@@ -32,63 +305,32 @@ CustomGrep::CustomGrep(bool ignoreCase, bool regexSearch)
 }
 
 
-// parallelSearch: perform the parallel search using the number of threads set in the constructor.
-// Each thread processes a contiguous subrange of `all_files` and calls `searchInFile`.
-// Every thread will handle a chunk of files, and the results will be collected and merged at the end.
-// Since each thread processes a different subrange of files and writes to its own local vector,
-// we do not need any synchronization.
-// All threads will write to their own vector, and we will merge them at the end.
-std::vector<Match> CustomGrep::parallelSearch(
-    const std::vector<std::filesystem::path>& all_files,
-    const std::string& query
-) const
+// runChunked: split [0, total) into one contiguous chunk per thread and run
+// `worker(thread_index, start_idx, end_idx)` for every chunk on its own thread.
+// Workers only touch their own chunk, so no synchronization is needed.
+template <typename Worker>
+void CustomGrep::runChunked(size_t total, Worker&& worker) const
 {
-    size_t total_files = all_files.size();
-    if (total_files == 0 || m_threadCount == 0)
-    {
-        std::cerr << "No files to search or no threads available." << std::endl;
-        return {}; // nothing to scan
-    }
-
-    // Compute how many files each thread will process (ceiling division)
-    size_t chunk_size = (total_files + m_threadCount - 1) / m_threadCount;
-
-    // Prepare per-thread storage for results
-    std::vector<std::vector<Match>> local_results(m_threadCount);
+    // Compute how many items each thread will process (ceiling division)
+    size_t chunk_size = (total + m_threadCount - 1) / m_threadCount;
 
-    // Launch exactly m_threadCount threads, each handling its subrange
+    // Launch at most m_threadCount threads, each handling its subrange
     std::vector<std::thread> threads;
     threads.reserve(m_threadCount);
 
     for (size_t thread_index = 0; thread_index < m_threadCount; ++thread_index)
     {
         size_t start_idx = thread_index * chunk_size;
-        if (start_idx >= total_files)
+        if (start_idx >= total)
         {
             // More threads than files: this (and subsequent) thread has no work
-            std::cout << "Thread " << thread_index
-                      << " has no files to process." << std::endl;
             break;
         }
-        size_t end_idx = std::min(start_idx + chunk_size, total_files);
+        size_t end_idx = std::min(start_idx + chunk_size, total);
 
-        threads.emplace_back([&, thread_index, start_idx, end_idx]
+        threads.emplace_back([&worker, thread_index, start_idx, end_idx]
         {
-            auto& out = local_results[thread_index];
-
-            for (size_t path_index = start_idx; path_index < end_idx; ++path_index)
-            {
-                const auto& path = all_files[path_index];
-                auto matches = searchInFile(path, query);
-                if (!matches.empty())
-                {
-                    out.insert(
-                        out.end(),
-                        std::make_move_iterator(matches.begin()),
-                        std::make_move_iterator(matches.end())
-                    );
-                }
-            }
+            worker(thread_index, start_idx, end_idx);
         });
     }
 
@@ -100,133 +342,789 @@ std::vector<Match> CustomGrep::parallelSearch(
             th.join();
         }
     }
+}
+
+// collectMatches (parallelSearch): perform the parallel search using the number of threads set in the constructor.
+// Each thread processes a contiguous subrange of `all_files` and calls `searchInFile`.
+// Every thread will handle a chunk of files, and the results will be collected and merged at the end.
+// Since each thread processes a different subrange of files and writes to its own MatchList,
+// we do not need any synchronization, and match text goes to the thread's own arena.
+// The lists are merged at the end by splicing their arena chunks, without copying any text.
+// With a SearchControl (parallelSearchAsync), every worker checks its stop
+// request before each file, and scanFile before each buffer it reads; the
+// progress counters are advanced after each file.
+template <typename Files>
+MatchList CustomGrep::collectMatches(const Files& all_files, const QueryMatcher& matcher,
+                                     SearchControl* control, std::vector<ScanBuffer>* buffers) const
+{
+    size_t total_files = all_files.size();
+    if (total_files == 0 || m_threadCount == 0)
+    {
+        std::cerr << "No files to search or no threads available." << std::endl;
+        return {}; // nothing to scan
+    }
+    if (buffers != nullptr)
+    {
+        buffers->resize(m_threadCount);
+    }
+
+    // Prepare per-thread storage for results
+    std::vector<MatchList> local_results(m_threadCount);
+
+    runChunked(total_files, [&](size_t thread_index, size_t start_idx, size_t end_idx)
+    {
+        auto& out = local_results[thread_index];
+        ScanBuffer local_buffer;
+        ScanBuffer& buffer = buffers != nullptr ? (*buffers)[thread_index] : local_buffer;
+        std::filesystem::path scratch;
+        const std::stop_token stop = control ? control->stop.get_token() : std::stop_token{};
+        for (size_t path_index = start_idx; path_index < end_idx; ++path_index)
+        {
+            if (stop.stop_requested())
+            {
+                break;
+            }
+            const auto& path = filePathAt(all_files, path_index, scratch);
+            const size_t before = out.size();
+            EmitLines lines{path, out, m_options.maxLineLength};
+            scanFile(path, matcher, lines, buffer, stop);
+            if (control)
+            {
+                control->matches.fetch_add(out.size() - before, std::memory_order_relaxed);
+                control->filesSearched.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
 
-    // Merge per-thread results into a single vector
-    std::vector<Match> all_results;
+    // Merge per-thread results into a single list
+    MatchList all_results;
     size_t total_matches = 0;
-    for (auto& vec : local_results)
+    for (auto& list : local_results)
     {
-        total_matches += vec.size();
+        total_matches += list.size();
     }
     all_results.reserve(total_matches);
 
-    for (auto& vec : local_results)
+    for (auto& list : local_results)
     {
-        all_results.insert(
-            all_results.end(),
-            std::make_move_iterator(vec.begin()),
-            std::make_move_iterator(vec.end())
-        );
+        all_results.append(std::move(list));
     }
 
     return all_results;
 }
 
-// searchInFile: scan the entire file at `filePath` line by line, looking for `query`.
-// Returns a vector of Match for every line that contains `query`.
-std::vector<Match> CustomGrep::searchInFile(const std::filesystem::path& filePath,
-                                            const std::string& query) const
+// collectBatch (searchBatch): like collectMatches, but each worker reads a
+// file into memory once and scans it for every query the prefilter picks
+// for it. Files over kBatchFileLimit are streamed from disk for each query.
+template <typename Files>
+MatchList CustomGrep::collectBatch(const Files& all_files, const std::vector<BatchQuery>& queries) const
 {
-    std::vector<Match> results;
-    std::ifstream ifs(filePath);
-    if (!ifs.is_open())
+    if (all_files.empty() || queries.empty() || m_threadCount == 0)
     {
-        std::error_code ec(errno, std::generic_category());
+        std::cerr << "No files or queries to search, or no threads available." << std::endl;
+        return {};
+    }
 
-        if (ec == std::errc::permission_denied)
+    // Compile every query once, with its own options
+    std::vector<QueryMatcher> matchers;
+    matchers.reserve(queries.size());
+    BatchPrefilter prefilter;
+    for (size_t index = 0; index < queries.size(); ++index)
+    {
+        SearchOptions options = m_options;
+        options.regexSearch = queries[index].regexSearch;
+        options.ignoreCase = queries[index].ignoreCase;
+        matchers.push_back(CustomGrep(options).compileQuery(queries[index].pattern));
+        addToPrefilter(prefilter, index, queries[index], m_options.syntax);
+    }
+    prefilter.build();
+    // The lines without a hit of a query may well be in a file without its literal
+    const bool usePrefilter = !m_options.invertMatch;
+
+    std::vector<MatchList> local_results(m_threadCount);
+
+    runChunked(all_files.size(), [&](size_t thread_index, size_t start_idx, size_t end_idx)
+    {
+        auto& out = local_results[thread_index];
+        ScanBuffer buffer;
+        std::filesystem::path scratch;
+        FileContent content;
+        std::vector<bool> selected;
+        for (size_t path_index = start_idx; path_index < end_idx; ++path_index)
         {
-            std::cerr << "Permission denied, cannot access file: " << filePath.string() << "\n";
+            const auto& path = filePathAt(all_files, path_index, scratch);
+            FileInput input(path);
+            if (!input.isOpen())
+            {
+                reportOpenError(input, path);
+                continue;
+            }
+            bool loaded = false;
+            try
+            {
+                loaded = readWholeFile(input, content, kBatchFileLimit);
+            }
+            catch (const std::system_error& e)
+            {
+                std::cerr << "Could not read file [" << path.string() << "]: " << e.code().message() << "\n";
+                content.release(m_options.bufferSize);
+                continue;
+            }
+
+            if (loaded && usePrefilter)
+            {
+                prefilter.select(content.view(), selected);
+            }
+            else
+            {
+                selected.assign(queries.size(), true);
+            }
+
+            // The queries share the copy of the path in the arena
+            const size_t first = out.size();
+            std::string_view storedPath;
+            for (size_t query = 0; query < queries.size(); ++query)
+            {
+                if (!selected[query])
+                {
+                    continue;
+                }
+                EmitLines lines{path, out, m_options.maxLineLength};
+                lines.storedPath = storedPath;
+                lines.queryId = query;
+                if (loaded)
+                {
+                    MemoryInput memory(content.view());
+                    scanInput(memory, path, matchers[query], lines, buffer);
+                }
+                else
+                {
+                    scanFile(path, matchers[query], lines, buffer);
+                }
+                storedPath = lines.storedPath;
+            }
+
+            // Stable, so the queries matching a line stay in order
+            std::stable_sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+                             [](const Match& a, const Match& b) { return a.line_number < b.line_number; });
+            // Between files, hold no more than a scan buffer's worth
+            content.release(m_options.bufferSize);
         }
-        else
+    });
+
+    MatchList all_results;
+    size_t total_matches = 0;
+    for (auto& list : local_results)
+    {
+        total_matches += list.size();
+    }
+    all_results.reserve(total_matches);
+    for (auto& list : local_results)
+    {
+        all_results.append(std::move(list));
+    }
+    return all_results;
+}
+
+// streamMatches (parallelSearch with a sink): like collectMatches, but each worker spills its
+// MatchList to its own temporary file whenever the list outgrows the worker's
+// share of the result memory budget. At the end, every worker's spilled
+// matches and then the ones still in memory go to `sink`, in thread (and so
+// file) order.
+template <typename Files>
+size_t CustomGrep::streamMatches(const Files& all_files, const QueryMatcher& matcher,
+                                 const std::function<void(const Match&)>& sink,
+                                 std::vector<ScanBuffer>* buffers) const
+{
+    if (all_files.empty())
+    {
+        return 0;
+    }
+    if (buffers != nullptr)
+    {
+        buffers->resize(m_threadCount);
+    }
+
+    std::vector<MatchList> local_results(m_threadCount);
+    std::vector<MatchSpill> local_spills(m_threadCount);
+    const size_t share = m_options.resultMemoryBudget / m_threadCount;
+
+    runChunked(all_files.size(), [&](size_t thread_index, size_t start_idx, size_t end_idx)
+    {
+        ScanBuffer local_buffer;
+        ScanBuffer& buffer = buffers != nullptr ? (*buffers)[thread_index] : local_buffer;
+        std::filesystem::path scratch;
+        for (size_t path_index = start_idx; path_index < end_idx; ++path_index)
         {
-            std::cerr << "Could not open file [" << filePath.string() << "]: " << ec.message() << "\n";
+            const auto& path = filePathAt(all_files, path_index, scratch);
+            EmitLines lines{path, local_results[thread_index], m_options.maxLineLength,
+                            m_options.resultMemoryBudget > 0 ? &local_spills[thread_index] : nullptr, share};
+            scanFile(path, matcher, lines, buffer);
         }
-        return results;
-    }
-    if (m_regexSearch)
+    });
+
+    size_t total_matches = 0;
+    for (size_t thread_index = 0; thread_index < m_threadCount; ++thread_index)
     {
-        // Compile regex once, with icase if requested
-        regexSearch(query, filePath, ifs, results);
+        total_matches += local_spills[thread_index].replay(sink);
+        for (const auto& match : local_results[thread_index])
+        {
+            sink(match);
+        }
+        total_matches += local_results[thread_index].size();
     }
-    else
+    return total_matches;
+}
+
+// countMatches (parallelCount): like collectMatches, but each thread only counts matching
+// lines, writing the count of file i to counts[i].
+template <typename Files>
+std::vector<size_t> CustomGrep::countMatches(const Files& all_files, const std::string& query) const
+{
+    std::vector<size_t> counts(all_files.size(), 0);
+    if (all_files.empty())
     {
-        // Regular search: case-sensitive or case-insensitive
-        regularSearch(query, filePath, ifs, results);
+        return counts;
     }
-    return results;
+
+    const QueryMatcher matcher = compileQuery(query);
+    runChunked(all_files.size(), [&](size_t /*thread_index*/, size_t start_idx, size_t end_idx)
+    {
+        ScanBuffer buffer;
+        std::filesystem::path scratch;
+        for (size_t path_index = start_idx; path_index < end_idx; ++path_index)
+        {
+            CountLines lines;
+            scanFile(filePathAt(all_files, path_index, scratch), matcher, lines, buffer);
+            counts[path_index] = lines.count;
+        }
+    });
+    return counts;
 }
 
-void CustomGrep::regexSearch(const std::string& query,
-                             const std::filesystem::path& filePath,
-                             std::ifstream& ifs,
-                             std::vector<Match> &results) const
+// writeHits (parallelOnlyMatching): like collectMatches, but every thread appends the hits
+// of its files to its own output buffer as text, and the buffers are written
+// to `out` in thread (and so file) order.
+template <typename Files>
+size_t CustomGrep::writeHits(const Files& all_files, const std::string& query, std::ostream& out) const
 {
-    // Compile regex once, with icase if requested
-    std::regex_constants::syntax_option_type flags =
-        std::regex_constants::ECMAScript;
-    if (m_ignoreCase)
+    if (all_files.empty())
     {
-        flags = flags | std::regex_constants::icase;
+        return 0;
     }
 
-    std::regex re(query, flags);
+    const QueryMatcher matcher = compileQuery(query);
+    if (m_options.invertMatch)
+    {
+        return 0; // the lines grep -v selects have no hits to write
+    }
+    std::vector<std::string> local_output(m_threadCount);
+    std::vector<size_t> local_hits(m_threadCount, 0);
 
-    std::string line;
-    size_t      lineNumber = 0;
-    while (std::getline(ifs, line))
+    runChunked(all_files.size(), [&](size_t thread_index, size_t start_idx, size_t end_idx)
     {
-        if (!line.empty() && line.back() == '\r') // to handle Windows-style line endings
+        ScanBuffer buffer;
+        std::filesystem::path scratch;
+        for (size_t path_index = start_idx; path_index < end_idx; ++path_index)
         {
-            line.pop_back();
+            const auto& filePath = filePathAt(all_files, path_index, scratch);
+            const std::string path = filePath.string();
+            WriteHits lines{path, local_output[thread_index]};
+            scanFile(filePath, matcher, lines, buffer);
+            local_hits[thread_index] += lines.hits;
         }
-        ++lineNumber;
-        if (std::regex_search(line, re))
+    });
+
+    size_t total_hits = 0;
+    for (size_t thread_index = 0; thread_index < m_threadCount; ++thread_index)
+    {
+        out.write(local_output[thread_index].data(),
+                  static_cast<std::streamsize>(local_output[thread_index].size()));
+        total_hits += local_hits[thread_index];
+    }
+    return total_hits;
+}
+
+// startAsync (parallelSearchAsync): run collectMatches on a thread of its own,
+// which owns copies of everything the search reads, so that the caller's
+// objects may go away before the search ends.
+template <typename Files>
+AsyncSearch CustomGrep::startAsync(Files all_files, std::string query, std::stop_token stop) const
+{
+    auto control = std::make_shared<SearchControl>();
+    control->totalFiles = all_files.size();
+
+    AsyncSearch search(control, stop);
+    search.m_result = std::async(std::launch::async,
+        [grep = *this, files = std::move(all_files), query = std::move(query), control]
         {
-            results.push_back(Match{filePath, lineNumber, line});
+            return grep.collectMatches(files, grep.compileQuery(query), control.get());
+        });
+    return search;
+}
+
+// feedMatches (parallelSearchLazy): the workers of collectMatches, except that
+// each hands its matches over to `channel` in batches as it finds them, and
+// stops once a stop is requested on `stop`.
+template <typename Files>
+void CustomGrep::feedMatches(const Files& all_files, const QueryMatcher& matcher, MatchChannel& channel,
+                             size_t batchSize, const std::stop_token& stop) const
+{
+    runChunked(all_files.size(), [&](size_t /*thread_index*/, size_t start_idx, size_t end_idx)
+    {
+        MatchList out;
+        ScanBuffer buffer;
+        std::filesystem::path scratch;
+        for (size_t path_index = start_idx; path_index < end_idx && !stop.stop_requested(); ++path_index)
+        {
+            const auto& path = filePathAt(all_files, path_index, scratch);
+            FeedLines lines{{path, out, m_options.maxLineLength}, channel, batchSize, stop};
+            scanFile(path, matcher, lines, buffer, stop);
+            lines.handOver();
         }
+    });
+}
+
+// generateMatches (parallelSearchLazy): the coroutine pulls batches from a
+// channel that a background search fills. When the consumer drops the
+// generator, the coroutine's locals are destroyed: the jthread requests a
+// stop, which also wakes workers waiting on a full channel, and joins.
+template <typename Files>
+Generator<Match> CustomGrep::generateMatches(CustomGrep grep, Files all_files, std::string query,
+                                             size_t bufferedMatches)
+{
+    const QueryMatcher matcher = grep.compileQuery(query);
+    if (all_files.empty())
+    {
+        co_return;
     }
+    MatchChannel channel(std::max<size_t>(bufferedMatches, 1));
+    // Half the capacity for the batches being filled, half for the queue
+    const size_t batchSize = std::max<size_t>(channel.capacity() / (2 * grep.m_threadCount), 1);
+
+    std::jthread search([&](std::stop_token stop)
+    {
+        grep.feedMatches(all_files, matcher, channel, batchSize, stop);
+        channel.close();
+    });
+
+    while (std::optional<MatchList> batch = channel.pop())
+    {
+        for (const Match& match : *batch)
+        {
+            co_yield match;
+        }
+    }
+}
+
+MatchList CustomGrep::parallelSearch(const std::vector<std::filesystem::path>& all_files,
+                                     const std::string& query) const
+{
+    return collectMatches(all_files, compileQuery(query));
+}
+
+MatchList CustomGrep::parallelSearch(const FileTable& all_files, const std::string& query) const
+{
+    return collectMatches(all_files, compileQuery(query));
+}
+
+CompiledQuery CustomGrep::compile(const std::string& query) const
+{
+    return CompiledQuery(query, compileQuery(query), m_options);
 }
 
-void CustomGrep::regularSearch(const std::string& query,
-                               const std::filesystem::path& filePath,
-                               std::ifstream& ifs,
-                               std::vector<Match> &results) const
+MatchList CustomGrep::parallelSearch(const std::vector<std::filesystem::path>& all_files,
+                                     const CompiledQuery& query) const
 {
-    std::string line;
-    size_t      lineNumber = 0;
+    checkCompiledFor(query);
+    return collectMatches(all_files, query.matcher());
+}
+
+MatchList CustomGrep::parallelSearch(const FileTable& all_files, const CompiledQuery& query) const
+{
+    checkCompiledFor(query);
+    return collectMatches(all_files, query.matcher());
+}
+
+AsyncSearch CustomGrep::parallelSearchAsync(std::vector<std::filesystem::path> all_files, std::string query,
+                                            std::stop_token stop) const
+{
+    return startAsync(std::move(all_files), std::move(query), std::move(stop));
+}
+
+AsyncSearch CustomGrep::parallelSearchAsync(FileTable all_files, std::string query, std::stop_token stop) const
+{
+    return startAsync(std::move(all_files), std::move(query), std::move(stop));
+}
+
+Generator<Match> CustomGrep::parallelSearchLazy(std::vector<std::filesystem::path> all_files, std::string query,
+                                                size_t bufferedMatches) const
+{
+    return generateMatches(*this, std::move(all_files), std::move(query), bufferedMatches);
+}
+
+Generator<Match> CustomGrep::parallelSearchLazy(FileTable all_files, std::string query,
+                                                size_t bufferedMatches) const
+{
+    return generateMatches(*this, std::move(all_files), std::move(query), bufferedMatches);
+}
+
+size_t CustomGrep::parallelSearch(const std::vector<std::filesystem::path>& all_files, const std::string& query,
+                                  const std::function<void(const Match&)>& sink) const
+{
+    return streamMatches(all_files, compileQuery(query), sink);
+}
+
+size_t CustomGrep::parallelSearch(const FileTable& all_files, const std::string& query,
+                                  const std::function<void(const Match&)>& sink) const
+{
+    return streamMatches(all_files, compileQuery(query), sink);
+}
+
+MatchList CustomGrep::searchBatch(const std::vector<std::filesystem::path>& all_files,
+                                  const std::vector<BatchQuery>& queries) const
+{
+    return collectBatch(all_files, queries);
+}
+
+MatchList CustomGrep::searchBatch(const FileTable& all_files, const std::vector<BatchQuery>& queries) const
+{
+    return collectBatch(all_files, queries);
+}
+
+std::vector<size_t> CustomGrep::parallelCount(const std::vector<std::filesystem::path>& all_files,
+                                              const std::string& query) const
+{
+    return countMatches(all_files, query);
+}
+
+std::vector<size_t> CustomGrep::parallelCount(const FileTable& all_files, const std::string& query) const
+{
+    return countMatches(all_files, query);
+}
+
+size_t CustomGrep::parallelOnlyMatching(const std::vector<std::filesystem::path>& all_files,
+                                        const std::string& query, std::ostream& out) const
+{
+    return writeHits(all_files, query, out);
+}
+
+size_t CustomGrep::parallelOnlyMatching(const FileTable& all_files, const std::string& query,
+                                        std::ostream& out) const
+{
+    return writeHits(all_files, query, out);
+}
+
+// searchInFile: scan the entire file at `filePath` line by line, looking for `query`.
+// The file is read in blocks of the configured buffer size, never a whole line at once.
+// Returns a Match for every line that contains `query`.
+MatchList CustomGrep::searchInFile(const std::filesystem::path& filePath,
+                                   const std::string& query) const
+{
+    ScanBuffer buffer;
+    return searchFileWith(filePath, compileQuery(query), buffer);
+}
+
+size_t CustomGrep::countInFile(const std::filesystem::path& filePath,
+                               const std::string& query) const
+{
+    ScanBuffer buffer;
+    return countFileWith(filePath, compileQuery(query), buffer);
+}
+
+MatchList CustomGrep::searchInFile(const std::filesystem::path& filePath, const CompiledQuery& query) const
+{
+    checkCompiledFor(query);
+    ScanBuffer buffer;
+    return searchFileWith(filePath, query.matcher(), buffer);
+}
 
-    // For case-insensitive search, convert the query string to lowercase
-    std::string lowerQuery;
-    if (m_ignoreCase)
+size_t CustomGrep::countInFile(const std::filesystem::path& filePath, const CompiledQuery& query) const
+{
+    checkCompiledFor(query);
+    ScanBuffer buffer;
+    return countFileWith(filePath, query.matcher(), buffer);
+}
+
+MatchList CustomGrep::searchFilesWith(const std::vector<std::filesystem::path>& all_files,
+                                      const QueryMatcher& matcher, std::vector<ScanBuffer>* buffers) const
+{
+    return collectMatches(all_files, matcher, nullptr, buffers);
+}
+
+MatchList CustomGrep::searchFilesWith(const FileTable& all_files, const QueryMatcher& matcher,
+                                      std::vector<ScanBuffer>* buffers) const
+{
+    return collectMatches(all_files, matcher, nullptr, buffers);
+}
+
+size_t CustomGrep::streamFilesWith(const std::vector<std::filesystem::path>& all_files,
+                                   const QueryMatcher& matcher, std::vector<ScanBuffer>* buffers,
+                                   const std::function<void(const Match&)>& sink) const
+{
+    return streamMatches(all_files, matcher, sink, buffers);
+}
+
+size_t CustomGrep::streamFilesWith(const FileTable& all_files, const QueryMatcher& matcher,
+                                   std::vector<ScanBuffer>* buffers,
+                                   const std::function<void(const Match&)>& sink) const
+{
+    return streamMatches(all_files, matcher, sink, buffers);
+}
+
+MatchList CustomGrep::searchFileWith(const std::filesystem::path& filePath, const QueryMatcher& matcher,
+                                     ScanBuffer& buffer) const
+{
+    MatchList results;
+    EmitLines lines{filePath, results, m_options.maxLineLength};
+    scanFile(filePath, matcher, lines, buffer);
+    return results;
+}
+
+size_t CustomGrep::countFileWith(const std::filesystem::path& filePath, const QueryMatcher& matcher,
+                                 ScanBuffer& buffer) const
+{
+    CountLines lines;
+    scanFile(filePath, matcher, lines, buffer);
+    return lines.count;
+}
+
+size_t CustomGrep::scanFileTo(const std::filesystem::path& filePath, const QueryMatcher& matcher,
+                              ScanBuffer& buffer, const std::function<bool(const Match&)>& sink) const
+{
+    SinkLines lines{sink, filePath.native(), m_options.maxLineLength};
+    scanFile(filePath, matcher, lines, buffer, lines.stop.get_token());
+    return lines.count;
+}
+
+size_t CustomGrep::scanBufferTo(std::string_view data, const std::filesystem::path& name,
+                                const QueryMatcher& matcher, ScanBuffer& buffer,
+                                const std::function<bool(const Match&)>& sink) const
+{
+    SinkLines lines{sink, name.native(), m_options.maxLineLength};
+    MemoryInput input(data);
+    scanInput(input, name, matcher, lines, buffer, lines.stop.get_token());
+    return lines.count;
+}
+
+CompiledQuery::CompiledQuery(std::string pattern, QueryMatcher matcher, const SearchOptions& options)
+    : m_pattern(std::move(pattern))
+    , m_matcher(std::make_shared<const QueryMatcher>(std::move(matcher)))
+    , m_options(options)
+{
+}
+
+// matchesLike: the options compileQuery reads
+bool CompiledQuery::matchesLike(const SearchOptions& options) const
+{
+    return options.ignoreCase == m_options.ignoreCase && options.regexSearch == m_options.regexSearch &&
+           options.wordRegexp == m_options.wordRegexp && options.lineRegexp == m_options.lineRegexp &&
+           options.captureGroup == m_options.captureGroup &&
+           (!options.regexSearch || options.syntax == m_options.syntax);
+}
+
+void CustomGrep::checkCompiledFor(const CompiledQuery& query) const
+{
+    if (!query.matchesLike(m_options))
+    {
+        throw std::invalid_argument("query " + query.pattern() + " was compiled for other search options");
+    }
+}
+
+// Helper: restrict the hits of `policy` to whole words or lines if requested.
+template <typename Policy>
+static QueryMatcher withBoundary(Policy policy, const SearchOptions& options)
+{
+    if (options.lineRegexp)
+    {
+        return BoundedPolicy<Policy, Boundary::Line>{std::move(policy)};
+    }
+    if (options.wordRegexp)
+    {
+        return BoundedPolicy<Policy, Boundary::Word>{std::move(policy)};
+    }
+    return policy;
+}
+
+// Helper: build -x or -w into a regex tree, so the engine finds any hit that
+// meets the boundary rather than checking only the hit it prefers
+static RegexNode boundedTree(RegexNode tree, const SearchOptions& options)
+{
+    if (!options.lineRegexp && !options.wordRegexp)
+    {
+        return tree;
+    }
+    RegexNode bounded;
+    bounded.kind = RegexNode::Kind::Concat;
+    bounded.children.emplace_back().kind =
+        options.lineRegexp ? RegexNode::Kind::LineStart : RegexNode::Kind::NoWordBefore;
+    if (tree.kind == RegexNode::Kind::Concat)
+    {
+        // Spliced in, so that a ^ and literal prefix stay visible to the analyses
+        std::move(tree.children.begin(), tree.children.end(), std::back_inserter(bounded.children));
+    }
+    else
     {
-        lowerQuery = query;
-        lowercaseInPlace(lowerQuery);
+        bounded.children.push_back(std::move(tree));
     }
+    bounded.children.emplace_back().kind =
+        options.lineRegexp ? RegexNode::Kind::LineEnd : RegexNode::Kind::NoWordAfter;
+    return bounded;
+}
 
-    while (std::getline(ifs, line))
+// Helper: build -x or -w into an ECMAScript pattern for std::regex. -w only
+// gets the end of the hit checked this way, as there is no lookbehind; the
+// BoundedPolicy around it checks the start.
+static std::string boundedPattern(const std::string& pattern, const SearchOptions& options)
+{
+    if (options.lineRegexp)
     {
-        if (!line.empty() && line.back() == '\r') // to handle Windows-style line endings
+        return "^(?:" + pattern + ")$";
+    }
+    if (options.wordRegexp)
+    {
+        return "(?:" + pattern + ")(?!\\w|[^\\x00-\\x7f])";
+    }
+    return pattern;
+}
+
+// compileQuery: pick the matcher policy for `query` from the search options.
+// This is the only place the options are inspected; the search loops are
+// instantiated per policy and never branch on them.
+QueryMatcher CustomGrep::compileQuery(const std::string& query) const
+{
+    if (m_options.regexSearch)
+    {
+        auto tree = parseRegex(query, m_options.ignoreCase, m_options.syntax);
+        if (m_options.captureGroup > 0)
         {
-            line.pop_back();
+            if (!tree)
+            {
+                throw std::invalid_argument("capture groups are not supported for regex " + query);
+            }
+            if (m_options.captureGroup > countCaptures(*tree))
+            {
+                throw std::invalid_argument("regex " + query + " has no capture group " +
+                                            std::to_string(m_options.captureGroup));
+            }
+            RegexNode bounded = boundedTree(std::move(*tree), m_options);
+            auto vm = PikeVM::compile(bounded);
+            if (!vm)
+            {
+                throw std::invalid_argument("regex too large: " + query);
+            }
+            return PikeVMPolicy{std::move(*vm), m_options.captureGroup, findLinePrefix(bounded),
+                                LiteralPrefilter(findRequiredLiteral(bounded))};
+        }
+
+        // A regex made only of literal alternatives needs no regex engine,
+        // unless -w or -x may reject its longest hit for a shorter one
+        std::vector<std::string> literals;
+        if (m_options.syntax != RegexSyntax::Basic && !m_options.wordRegexp && !m_options.lineRegexp &&
+            splitLiteralAlternation(query, m_options.syntax, literals))
+        {
+            return MultiLiteralPolicy{MultiLiteralMatcher(std::move(literals), m_options.ignoreCase)};
         }
-        ++lineNumber;
-        if (m_ignoreCase)
+
+        // Short regexes run on the bit-parallel engine and the others on the
+        // Pike VM, both in linear time. A ^-anchored regex first compares
+        // the start of each line with its literal prefix, and a regex whose
+        // hits all contain a literal only runs around its occurrences.
+        if (tree)
         {
-            // For case-insensitive search, convert the line to lowercase
-            std::string lowerLine = line;
-            lowercaseInPlace(lowerLine);
-            if (lowerLine.find(lowerQuery) != std::string::npos)
+            RegexNode bounded = boundedTree(std::move(*tree), m_options);
+            LinePrefix prefix = findLinePrefix(bounded);
+            LiteralPrefilter prefilter(findRequiredLiteral(bounded));
+            if (auto regex = BitParallelRegex::compile(bounded))
+            {
+                return BitParallelPolicy{std::move(*regex), std::move(prefix), std::move(prefilter)};
+            }
+            if (auto vm = PikeVM::compile(bounded))
             {
-                results.push_back(Match{filePath, lineNumber, line});
+                return PikeVMPolicy{std::move(*vm), 0, std::move(prefix), std::move(prefilter)};
             }
         }
-        else
+
+        // The ERE grammar of std::regex has no backreferences, so what is
+        // left of grep -E runs in ECMAScript spelling
+        const bool basic = m_options.syntax == RegexSyntax::Basic;
+        const std::string pattern = m_options.syntax == RegexSyntax::Extended ? extendedToECMAScript(query) : query;
+
+        // Refuse patterns that std::regex may take exponential time on
+        size_t nested = basic ? std::string::npos : findNestedQuantifier(pattern);
+        if (nested != std::string::npos)
+        {
+            throw std::invalid_argument("regex may backtrack exponentially: nested quantifier at offset " +
+                                        std::to_string(nested) + " of " + pattern);
+        }
+
+        // Compile regex once in the requested grammar, with icase if requested
+        std::regex_constants::syntax_option_type flags =
+            basic ? std::regex_constants::basic : std::regex_constants::ECMAScript;
+        if (m_options.ignoreCase)
         {
-            if (line.find(query) != std::string::npos)
+            flags = flags | std::regex_constants::icase;
+        }
+        if (!basic)
+        {
+            return withBoundary(RegexPolicy{std::regex(boundedPattern(pattern, m_options), flags)}, m_options);
+        }
+        return withBoundary(RegexPolicy{std::regex(query, flags)}, m_options);
+    }
+
+    if (m_options.ignoreCase)
+    {
+        return withBoundary(FoldedLiteralPolicy{FoldedLiteralMatcher(query)}, m_options);
+    }
+    return withBoundary(LiteralPolicy{LiteralMatcher(query)}, m_options);
+}
+
+template <typename LinePolicy>
+void CustomGrep::scanFile(const std::filesystem::path& filePath,
+                          const QueryMatcher& matcher,
+                          LinePolicy& lines,
+                          ScanBuffer& buffer,
+                          std::stop_token stop) const
+{
+    FileInput input(filePath);
+    if (!input.isOpen())
+    {
+        reportOpenError(input, filePath);
+        return;
+    }
+    scanInput(input, filePath, matcher, lines, buffer, std::move(stop));
+}
+
+template <typename Input, typename LinePolicy>
+void CustomGrep::scanInput(Input& input,
+                           const std::filesystem::path& filePath,
+                           const QueryMatcher& matcher,
+                           LinePolicy& lines,
+                           ScanBuffer& buffer,
+                           std::stop_token stop) const
+{
+    const ScanLimits limits{m_options.bufferSize, m_options.maxLineLength,
+                            m_options.fileStepBudget, m_options.fileTimeBudget, std::move(stop)};
+    try
+    {
+        if constexpr (kTakesLineBlocks<LinePolicy>)
+        {
+            if (m_options.invertMatch)
             {
-                results.push_back(Match{filePath, lineNumber, line});
+                scanStreamInverted(input, matcher, lines, buffer, limits);
+                return;
             }
         }
+        scanStream(input, matcher, lines, buffer, limits);
+    }
+    catch (const SearchBudgetExceeded& e)
+    {
+        std::cerr << "Search budget exceeded, skipped the rest of file [" << filePath.string()
+                  << "]: " << e.what() << "\n";
+    }
+    catch (const std::system_error& e)
+    {
+        std::cerr << "Could not read file [" << filePath.string() << "]: " << e.code().message() << "\n";
     }
 }
 
@@ -0,0 +1,240 @@
+#include "CustomGrepC.h"
+#include "FileCollector.h"
+#include "SearchSession.h"
+
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The C handle: a session with the compiled query, and room for the spans
+// of the match being handed over
+struct cgrep_search
+{
+    cgrep::SearchSession    session;
+    std::vector<cgrep_span> spans;
+};
+
+namespace
+{
+
+thread_local std::string lastError;
+
+// Size of the first cgrep_options layout, the shortest one accepted
+constexpr size_t kFirstOptionsSize = sizeof(cgrep_options);
+
+// Helper: record why a call failed for cgrep_last_error()
+void setError(const char* what)
+{
+    lastError = what;
+}
+
+// Helper: hand `match` to the C callback; returns whether to go on
+bool handOver(cgrep_search& search, const cgrep::Match& match, cgrep_match_callback callback, void* userData)
+{
+    search.spans.clear();
+    for (const auto& span : match.spans)
+    {
+        search.spans.push_back(cgrep_span{span.start, span.length});
+    }
+    const cgrep_match view{match.path.data(),  match.path.size(),   match.line_number,
+                           match.line.data(),  match.line.size(),   match.byte_offset,
+                           match.hit_offset,   match.truncated ? 1 : 0,
+                           search.spans.data(), search.spans.size()};
+    return callback(&view, userData) == 0;
+}
+
+// Helper: run a parallel search of the session with a sink that hands its
+// matches to the C callback until it asks to stop
+template <typename Files>
+int64_t handOverAll(cgrep_search& search, const Files& files, cgrep_match_callback callback, void* userData)
+{
+    int64_t count = 0;
+    bool goOn = true;
+    search.session.parallelSearch(files, [&](const cgrep::Match& match)
+    {
+        if (goOn)
+        {
+            ++count;
+            goOn = handOver(search, match, callback, userData);
+        }
+    });
+    return count;
+}
+
+// Helper: run `body`, turning exceptions and missing arguments into -1
+template <typename Body>
+int64_t guarded(cgrep_search* search, cgrep_match_callback callback, Body&& body)
+{
+    if (search == nullptr || callback == nullptr)
+    {
+        setError("search and callback must not be NULL");
+        return -1;
+    }
+    try
+    {
+        return body(*search);
+    }
+    catch (const std::exception& e)
+    {
+        setError(e.what());
+    }
+    catch (...)
+    {
+        setError("unknown error");
+    }
+    return -1;
+}
+
+} // namespace
+
+extern "C" {
+
+void cgrep_options_init(cgrep_options* options)
+{
+    if (options != nullptr)
+    {
+        *options = cgrep_options{sizeof(cgrep_options), 0, 0, CGREP_SYNTAX_ECMASCRIPT, 0, 0, 0,
+                                 cgrep::kDefaultMaxLineLength, cgrep::kDefaultBufferSize,
+                                 cgrep::kDefaultResultMemoryBudget};
+    }
+}
+
+cgrep_search* cgrep_search_new(const char* query, size_t query_length, const cgrep_options* options)
+{
+    if (query == nullptr && query_length > 0)
+    {
+        setError("query must not be NULL");
+        return nullptr;
+    }
+    // Fields past the caller's struct_size keep their defaults; every
+    // layout so far is at least as long as the first
+    cgrep_options given;
+    cgrep_options_init(&given);
+    if (options != nullptr)
+    {
+        if (options->struct_size < kFirstOptionsSize || options->struct_size > sizeof(cgrep_options))
+        {
+            setError("unknown cgrep_options::struct_size; set it with cgrep_options_init()");
+            return nullptr;
+        }
+        std::memcpy(&given, options, options->struct_size);
+    }
+    if (given.syntax < CGREP_SYNTAX_ECMASCRIPT || given.syntax > CGREP_SYNTAX_BASIC)
+    {
+        setError("unknown regex syntax");
+        return nullptr;
+    }
+
+    cgrep::SearchOptions searchOptions;
+    searchOptions.ignoreCase = given.ignore_case != 0;
+    searchOptions.regexSearch = given.regex != 0;
+    searchOptions.syntax = given.syntax == CGREP_SYNTAX_BASIC      ? cgrep::RegexSyntax::Basic
+                           : given.syntax == CGREP_SYNTAX_EXTENDED ? cgrep::RegexSyntax::Extended
+                                                                   : cgrep::RegexSyntax::ECMAScript;
+    searchOptions.invertMatch = given.invert_match != 0;
+    searchOptions.wordRegexp = given.word_regexp != 0;
+    searchOptions.lineRegexp = given.line_regexp != 0;
+    searchOptions.maxLineLength = given.max_line_length;
+    searchOptions.bufferSize = given.buffer_size;
+    searchOptions.resultMemoryBudget = given.result_memory;
+    try
+    {
+        return new cgrep_search{cgrep::SearchSession(std::string(query != nullptr ? query : "", query_length),
+                                                     searchOptions),
+                                {}};
+    }
+    catch (const std::exception& e)
+    {
+        setError(e.what());
+    }
+    catch (...)
+    {
+        setError("unknown error");
+    }
+    return nullptr;
+}
+
+void cgrep_search_free(cgrep_search* search)
+{
+    delete search;
+}
+
+int64_t cgrep_search_file(cgrep_search* search, const char* path, cgrep_match_callback callback, void* user_data)
+{
+    return guarded(search, callback, [&](cgrep_search& s) -> int64_t
+    {
+        if (path == nullptr)
+        {
+            throw std::invalid_argument("path must not be NULL");
+        }
+        return static_cast<int64_t>(s.session.scanFile(path, [&](const cgrep::Match& match)
+        {
+            return handOver(s, match, callback, user_data);
+        }));
+    });
+}
+
+int64_t cgrep_search_buffer(cgrep_search* search, const char* data, size_t size, const char* name,
+                            cgrep_match_callback callback, void* user_data)
+{
+    return guarded(search, callback, [&](cgrep_search& s) -> int64_t
+    {
+        if (data == nullptr && size > 0)
+        {
+            throw std::invalid_argument("data must not be NULL");
+        }
+        std::string_view bytes(data != nullptr ? data : "", size);
+        const char* fileName = name != nullptr ? name : "";
+        return static_cast<int64_t>(s.session.scanBuffer(bytes, fileName, [&](const cgrep::Match& match)
+        {
+            return handOver(s, match, callback, user_data);
+        }));
+    });
+}
+
+int64_t cgrep_search_paths(cgrep_search* search, const char* const* paths, size_t count,
+                           cgrep_match_callback callback, void* user_data)
+{
+    return guarded(search, callback, [&](cgrep_search& s) -> int64_t
+    {
+        if (paths == nullptr && count > 0)
+        {
+            throw std::invalid_argument("paths must not be NULL");
+        }
+        std::vector<std::filesystem::path> files;
+        files.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (paths[i] == nullptr)
+            {
+                throw std::invalid_argument("paths must not hold NULL");
+            }
+            files.emplace_back(paths[i]);
+        }
+        return handOverAll(s, files, callback, user_data);
+    });
+}
+
+int64_t cgrep_search_directory(cgrep_search* search, const char* root, cgrep_match_callback callback,
+                               void* user_data)
+{
+    return guarded(search, callback, [&](cgrep_search& s) -> int64_t
+    {
+        if (root == nullptr)
+        {
+            throw std::invalid_argument("root must not be NULL");
+        }
+        return handOverAll(s, cgrep::FileCollector::collectFileTable(root), callback, user_data);
+    });
+}
+
+const char* cgrep_last_error(void)
+{
+    return lastError.c_str();
+}
+
+} // extern "C"
@@ -5,8 +5,13 @@
 namespace cgrep
 {
 
-void FileCollector::collectFilesRecursive(const std::filesystem::path& dir,
-                                          std::vector<std::filesystem::path>& files)
+// Helper: walk `dir` depth first, handing each regular file to
+// `addFile(parent, entry)` and each subdirectory to `addDirectory(parent,
+// entry)`, which returns the parent of the subdirectory's own entries.
+// Entries that cannot be accessed are reported on stderr and skipped.
+template <typename Parent, typename AddFile, typename AddDirectory>
+static void walkDirectory(const std::filesystem::path& dir, Parent parent, AddFile& addFile,
+                          AddDirectory& addDirectory)
 {
     std::error_code ec;
     std::filesystem::directory_iterator it(dir, ec);
@@ -22,11 +27,11 @@ void FileCollector::collectFilesRecursive(const std::filesystem::path& dir,
         std::error_code entry_ec;
         if (entry.is_directory(entry_ec))
         {
-            collectFilesRecursive(entry.path(), files);
+            walkDirectory(entry.path(), addDirectory(parent, entry), addFile, addDirectory);
         }
         else if (entry.is_regular_file(entry_ec))
         {
-            files.push_back(entry.path());
+            addFile(parent, entry);
         }
 
         if (entry_ec)
@@ -37,6 +42,24 @@ void FileCollector::collectFilesRecursive(const std::filesystem::path& dir,
     }
 }
 
+void FileCollector::reportInvalidInput(const std::filesystem::path& dir, const std::error_code& ec)
+{
+    if (ec)
+    {
+        std::cerr << "Error accessing path: [" << dir.string() << "]: "
+                  << ec.message() << std::endl;
+    }
+    else if (std::filesystem::exists(dir))
+    {
+        std::cerr << "Input path: [" << dir.string()
+                  << "] is not a regular file or a directory." << std::endl;
+    }
+    else
+    {
+        std::cerr << "Input path: [" << dir.string() << "] does not exist." << std::endl;
+    }
+}
+
 std::vector<std::filesystem::path>
 FileCollector::collectFiles(const std::filesystem::path& dir)
 {
@@ -45,7 +68,10 @@ FileCollector::collectFiles(const std::filesystem::path& dir)
 
     if (std::filesystem::is_directory(dir, ec))
     {
-        collectFilesRecursive(dir, files);
+        // A list of paths has no parents to track
+        auto addFile = [&](int, const std::filesystem::directory_entry& entry) { files.push_back(entry.path()); };
+        auto addDirectory = [](int, const std::filesystem::directory_entry&) { return 0; };
+        walkDirectory(dir, 0, addFile, addDirectory);
     }
     else if (std::filesystem::is_regular_file(dir, ec))
     {
@@ -53,26 +79,38 @@ FileCollector::collectFiles(const std::filesystem::path& dir)
     }
     else
     {
-        if (ec)
-        {
-            std::cerr << "Error accessing path: [" << dir.string() << "]: "
-                      << ec.message() << std::endl;
-        }
-        else if (std::filesystem::exists(dir))
-        {
-            std::cerr << "Input path: [" << dir.string()
-                      << "] is not a regular file or a directory." << std::endl;
-        }
-        else
-        {
-            std::cerr << "Input path: [" << dir.string() << "] does not exist." << std::endl;
-        }
+        reportInvalidInput(dir, ec);
         return {};
     }
 
-    if (!files.empty())
+    return files;
+}
+
+FileTable FileCollector::collectFileTable(const std::filesystem::path& dir)
+{
+    FileTable files;
+    std::error_code ec;
+
+    if (std::filesystem::is_directory(dir, ec))
+    {
+        auto addFile = [&](uint32_t parent, const std::filesystem::directory_entry& entry)
+        {
+            files.addFile(parent, entry.path().filename().native());
+        };
+        auto addDirectory = [&](uint32_t parent, const std::filesystem::directory_entry& entry)
+        {
+            return files.addDirectory(parent, entry.path().filename().native());
+        };
+        walkDirectory(dir, files.addDirectory(FileTable::kNoParent, dir.native()), addFile, addDirectory);
+    }
+    else if (std::filesystem::is_regular_file(dir, ec))
     {
-        std::cout << files.size() << " files found" << std::endl;
+        files.addFile(FileTable::kNoParent, dir.native());
+    }
+    else
+    {
+        reportInvalidInput(dir, ec);
+        return {};
     }
 
     return files;
@@ -0,0 +1,62 @@
+#include "FileTable.h"
+
+namespace cgrep
+{
+
+uint64_t FileTable::storeName(std::string_view name)
+{
+    uint64_t offset = m_names.size();
+    m_names.append(name);
+    return offset;
+}
+
+std::string_view FileTable::name(const Entry& entry) const
+{
+    return std::string_view(m_names).substr(entry.nameOffset, entry.nameLength);
+}
+
+uint32_t FileTable::addDirectory(uint32_t parent, std::string_view name)
+{
+    m_directories.push_back(Entry{storeName(name), static_cast<uint32_t>(name.size()), parent});
+    return static_cast<uint32_t>(m_directories.size() - 1);
+}
+
+void FileTable::addFile(uint32_t directory, std::string_view name)
+{
+    m_files.push_back(Entry{storeName(name), static_cast<uint32_t>(name.size()), directory});
+}
+
+std::filesystem::path FileTable::path(size_t index) const
+{
+    std::filesystem::path result;
+    pathInto(index, result);
+    return result;
+}
+
+void FileTable::appendDirectory(uint32_t directory, std::filesystem::path& out) const
+{
+    const Entry& entry = m_directories[directory];
+    if (entry.parent != kNoParent)
+    {
+        appendDirectory(entry.parent, out);
+    }
+    out /= name(entry);
+}
+
+void FileTable::pathInto(size_t index, std::filesystem::path& out) const
+{
+    const Entry& file = m_files[index];
+    out.clear();
+    if (file.parent != kNoParent)
+    {
+        appendDirectory(file.parent, out);
+    }
+    out /= name(file);
+}
+
+size_t FileTable::memoryUsage() const
+{
+    return (m_directories.capacity() + m_files.capacity()) * sizeof(Entry) + m_names.capacity();
+}
+
+} // namespace cgrep
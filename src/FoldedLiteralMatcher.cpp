@@ -0,0 +1,69 @@
+#include "FoldedLiteralMatcher.h"
+#include "CaseFolding.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace cgrep
+{
+
+FoldedLiteralMatcher::FoldedLiteralMatcher(std::string_view needle)
+    : m_folded(foldUtf8(needle))
+{
+    // Only 'k' and 's' are the folding of a non-ASCII code point
+    bool asciiOnly = std::all_of(m_folded.begin(), m_folded.end(),
+        [](char32_t cp) { return cp < 0x80 && cp != 'k' && cp != 's'; });
+    if (asciiOnly || m_folded.empty())
+    {
+        m_ascii.emplace(std::string(needle), true);
+        return;
+    }
+
+    std::vector<std::string> encodings;
+    for (char32_t variant : caseVariants(m_folded.front()))
+    {
+        std::string encoded;
+        appendUtf8(encoded, variant);
+        encodings.push_back(std::move(encoded));
+    }
+    m_firstCodePoint.emplace(std::move(encodings));
+}
+
+size_t FoldedLiteralMatcher::find(std::string_view haystack, size_t from, size_t& length) const
+{
+    if (m_ascii)
+    {
+        size_t pos = m_ascii->find(haystack, from);
+        length = m_ascii->needle().size();
+        return pos;
+    }
+
+    MultiLiteralMatcher::Hit hit;
+    size_t pos = from;
+    while (m_firstCodePoint->find(haystack, pos, hit))
+    {
+        // Compare the remaining code points, decoding the haystack as we go
+        size_t end = hit.position + hit.length;
+        size_t matched = 1;
+        while (matched < m_folded.size() && end < haystack.size())
+        {
+            size_t codePointLength = 0;
+            if (foldCodePoint(decodeUtf8(haystack, end, codePointLength)) != m_folded[matched])
+            {
+                break;
+            }
+            end += codePointLength;
+            ++matched;
+        }
+        if (matched == m_folded.size())
+        {
+            length = end - hit.position;
+            return hit.position;
+        }
+        pos = hit.position + 1;
+    }
+    length = 0;
+    return std::string_view::npos;
+}
+
+} // namespace cgrep
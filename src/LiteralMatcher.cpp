@@ -0,0 +1,444 @@
+#include "LiteralMatcher.h"
+#include "ByteFrequencies.h"
+#include "CaseFolding.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cgrep
+{
+
+// Needles shorter than this always use the rare-byte vector scan: the skip
+// loops cannot shift far enough to beat it.
+static constexpr size_t kSkipSearchMinLength = 16;
+
+// Longer needles only use the rare-byte scan when their rarest byte ranks at
+// most this high in kByteFrequencyRank; needles made entirely of the most
+// common bytes (space, 'e', 't', ...) produce too many candidates and use
+// Horspool, whose shifts grow with the needle length.
+static constexpr uint8_t kRareByteMaxRank = 240;
+
+// Needles with at most this many distinct bytes give Horspool only short
+// shifts and quadratic worst cases, so they use Two-Way instead.
+static constexpr size_t kLowAlphabetSize = 4;
+
+// Helper: compute the maximal suffix of `needle` for the byte order given
+// by `reversed`, as in the Crochemore-Perrin critical factorization.
+// Returns the index preceding the suffix (SIZE_MAX for the whole needle)
+// and stores the period of that suffix in `period`.
+static size_t maximalSuffix(const std::string& needle, bool reversed, size_t& period)
+{
+    const auto* x = reinterpret_cast<const unsigned char*>(needle.data());
+    size_t n = needle.size();
+    size_t maxSuffix = SIZE_MAX;
+    size_t j = 0;
+    size_t k = 1;
+    size_t p = 1;
+    while (j + k < n)
+    {
+        unsigned char a = x[j + k];
+        unsigned char b = x[maxSuffix + k]; // wraps to x[k - 1] initially
+        if (reversed)
+        {
+            std::swap(a, b);
+        }
+
+        if (a < b)
+        {
+            // Suffix is smaller, period is the entire prefix so far
+            j += k;
+            k = 1;
+            p = j - maxSuffix;
+        }
+        else if (a == b)
+        {
+            // Advance through a repetition of the current period
+            if (k != p)
+            {
+                ++k;
+            }
+            else
+            {
+                j += p;
+                k = 1;
+            }
+        }
+        else
+        {
+            // Suffix is larger, start over from the current location
+            maxSuffix = j++;
+            k = 1;
+            p = 1;
+        }
+    }
+    period = p;
+    return maxSuffix;
+}
+
+// Helper: the rarer of two bytes according to kByteFrequencyRank.
+static bool isRarer(unsigned char a, unsigned char b)
+{
+    return kByteFrequencyRank[a] < kByteFrequencyRank[b];
+}
+
+LiteralMatcher::LiteralMatcher(std::string needle, bool asciiCaseInsensitive)
+    : m_needle(std::move(needle))
+    , m_caseInsensitive(asciiCaseInsensitive)
+{
+    if (m_caseInsensitive)
+    {
+        for (auto& c : m_needle)
+        {
+            c = static_cast<char>(foldAscii(static_cast<unsigned char>(c)));
+        }
+        if (!m_needle.empty())
+        {
+            m_algorithm = Algorithm::RareBytes;
+            prepareRareBytes();
+        }
+        return;
+    }
+
+    if (m_needle.size() < 2)
+    {
+        m_algorithm = Algorithm::Direct;
+        return;
+    }
+    if (m_needle.size() < kSkipSearchMinLength)
+    {
+        m_algorithm = Algorithm::RareBytes;
+        prepareRareBytes();
+        return;
+    }
+
+    std::array<bool, 256> seen{};
+    size_t distinct = 0;
+    for (unsigned char c : m_needle)
+    {
+        if (!seen[c])
+        {
+            seen[c] = true;
+            ++distinct;
+        }
+    }
+
+    if (distinct <= kLowAlphabetSize)
+    {
+        m_algorithm = Algorithm::TwoWay;
+        prepareTwoWay();
+        return;
+    }
+
+    prepareRareBytes();
+    if (kByteFrequencyRank[static_cast<unsigned char>(m_needle[m_rare1Index])] <= kRareByteMaxRank)
+    {
+        m_algorithm = Algorithm::RareBytes;
+    }
+    else
+    {
+        m_algorithm = Algorithm::Horspool;
+        prepareHorspool();
+    }
+}
+
+void LiteralMatcher::prepareRareBytes()
+{
+    const auto byteAt = [this](size_t i) { return static_cast<unsigned char>(m_needle[i]); };
+
+    m_rare1Index = 0;
+    for (size_t i = 1; i < m_needle.size(); ++i)
+    {
+        if (isRarer(byteAt(i), byteAt(m_rare1Index)))
+        {
+            m_rare1Index = i;
+        }
+    }
+
+    // The second anchor should be a different byte value where possible:
+    // two copies of the same byte filter far fewer candidates. A one-byte
+    // needle simply checks its only byte twice.
+    m_rare2Index = (m_needle.size() == 1 || m_rare1Index != 0) ? 0 : 1;
+    for (size_t i = 0; i < m_needle.size(); ++i)
+    {
+        if (i == m_rare1Index)
+        {
+            continue;
+        }
+        bool candidateDistinct = byteAt(i) != byteAt(m_rare1Index);
+        bool currentDistinct = byteAt(m_rare2Index) != byteAt(m_rare1Index);
+        if ((candidateDistinct && !currentDistinct)
+            || (candidateDistinct == currentDistinct && isRarer(byteAt(i), byteAt(m_rare2Index))))
+        {
+            m_rare2Index = i;
+        }
+    }
+}
+
+void LiteralMatcher::prepareHorspool()
+{
+    size_t n = m_needle.size();
+    m_skip.fill(n);
+    for (size_t i = 0; i + 1 < n; ++i)
+    {
+        m_skip[static_cast<unsigned char>(m_needle[i])] = n - 1 - i;
+    }
+
+    // The last byte is always compared first; guard with the rarest of the others
+    m_guardIndex = 0;
+    for (size_t i = 1; i + 1 < n; ++i)
+    {
+        if (isRarer(static_cast<unsigned char>(m_needle[i]),
+                    static_cast<unsigned char>(m_needle[m_guardIndex])))
+        {
+            m_guardIndex = i;
+        }
+    }
+}
+
+void LiteralMatcher::prepareTwoWay()
+{
+    size_t forwardPeriod = 0;
+    size_t reversePeriod = 0;
+    size_t forward = maximalSuffix(m_needle, false, forwardPeriod);
+    size_t reverse = maximalSuffix(m_needle, true, reversePeriod);
+
+    // The critical position is the later of the two maximal suffixes
+    // (SIZE_MAX + 1 wraps to 0 for a suffix covering the whole needle).
+    if (forward + 1 >= reverse + 1)
+    {
+        m_critical = forward + 1;
+        m_period = forwardPeriod;
+    }
+    else
+    {
+        m_critical = reverse + 1;
+        m_period = reversePeriod;
+    }
+
+    m_periodic = m_critical + m_period <= m_needle.size()
+        && std::memcmp(m_needle.data(), m_needle.data() + m_period, m_critical) == 0;
+    if (!m_periodic)
+    {
+        m_period = std::max(m_critical, m_needle.size() - m_critical) + 1;
+    }
+}
+
+size_t LiteralMatcher::find(std::string_view haystack, size_t from) const
+{
+    switch (m_algorithm)
+    {
+        case Algorithm::RareBytes:
+            return m_caseInsensitive ? findRareBytes<true>(haystack, from)
+                                     : findRareBytes<false>(haystack, from);
+        case Algorithm::Horspool:
+            return findHorspool(haystack, from);
+        case Algorithm::TwoWay:
+            return findTwoWay(haystack, from);
+        case Algorithm::Direct:
+            break;
+    }
+    return haystack.find(m_needle, from);
+}
+
+template <bool CaseInsensitive>
+size_t LiteralMatcher::findRareBytes(std::string_view haystack, size_t from) const
+{
+    const size_t n = m_needle.size();
+    const size_t size = haystack.size();
+    if (from > size || size - from < n)
+    {
+        return std::string_view::npos;
+    }
+
+    const auto* hay = reinterpret_cast<const unsigned char*>(haystack.data());
+    const auto* needle = reinterpret_cast<const unsigned char*>(m_needle.data());
+    const unsigned char rare1 = needle[m_rare1Index];
+    const unsigned char rare2 = needle[m_rare2Index];
+    const size_t lastStart = size - n; // last position a match can start at
+
+    const auto matchesAt = [&](size_t candidate)
+    {
+        if constexpr (CaseInsensitive)
+        {
+            return equalsAsciiFolded(hay + candidate, needle, n);
+        }
+        else
+        {
+            return std::memcmp(hay + candidate, needle, n) == 0;
+        }
+    };
+
+    size_t pos = from;
+
+#if defined(__SSE2__)
+    // Compare 16 candidate start positions at once: a candidate survives only
+    // if both anchor bytes are in place, which is rare for rare bytes.
+    // In case-insensitive mode each anchor also matches its uppercase form
+    // (identical to the lowercase one for non-letters).
+    const auto upper = [](unsigned char c) { return (c >= 'a' && c <= 'z') ? c - 0x20 : c; };
+    const __m128i anchor1 = _mm_set1_epi8(static_cast<char>(rare1));
+    const __m128i anchor2 = _mm_set1_epi8(static_cast<char>(rare2));
+    const __m128i anchor1Upper = _mm_set1_epi8(static_cast<char>(upper(rare1)));
+    const __m128i anchor2Upper = _mm_set1_epi8(static_cast<char>(upper(rare2)));
+    const size_t maxAnchor = std::max(m_rare1Index, m_rare2Index);
+    while (pos + maxAnchor + 16 <= size)
+    {
+        __m128i block1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + pos + m_rare1Index));
+        __m128i block2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + pos + m_rare2Index));
+        __m128i eq1 = _mm_cmpeq_epi8(block1, anchor1);
+        __m128i eq2 = _mm_cmpeq_epi8(block2, anchor2);
+        if constexpr (CaseInsensitive)
+        {
+            eq1 = _mm_or_si128(eq1, _mm_cmpeq_epi8(block1, anchor1Upper));
+            eq2 = _mm_or_si128(eq2, _mm_cmpeq_epi8(block2, anchor2Upper));
+        }
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(eq1, eq2)));
+        while (mask != 0)
+        {
+            size_t candidate = pos + static_cast<size_t>(__builtin_ctz(mask));
+            if (candidate > lastStart)
+            {
+                return std::string_view::npos;
+            }
+            if (matchesAt(candidate))
+            {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+        pos += 16;
+    }
+#endif
+
+    // Scalar scan (and the tail of the vector scan): memchr for the rarest byte
+    if constexpr (CaseInsensitive)
+    {
+        for (; pos <= lastStart; ++pos)
+        {
+            if (foldAscii(hay[pos + m_rare1Index]) == rare1 && matchesAt(pos))
+            {
+                return pos;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    while (pos <= lastStart)
+    {
+        const void* hit = std::memchr(hay + pos + m_rare1Index, rare1, lastStart - pos + 1);
+        if (hit == nullptr)
+        {
+            break;
+        }
+        size_t candidate = static_cast<size_t>(static_cast<const unsigned char*>(hit) - hay) - m_rare1Index;
+        if (hay[candidate + m_rare2Index] == rare2 && matchesAt(candidate))
+        {
+            return candidate;
+        }
+        pos = candidate + 1;
+    }
+    return std::string_view::npos;
+}
+
+size_t LiteralMatcher::findHorspool(std::string_view haystack, size_t from) const
+{
+    const size_t n = m_needle.size();
+    const size_t last = n - 1;
+    const auto* hay = reinterpret_cast<const unsigned char*>(haystack.data());
+    const auto* needle = reinterpret_cast<const unsigned char*>(m_needle.data());
+    const unsigned char lastByte = needle[last];
+    const unsigned char guardByte = needle[m_guardIndex];
+
+    size_t pos = from;
+    while (pos + n <= haystack.size())
+    {
+        unsigned char c = hay[pos + last];
+        if (c == lastByte
+            && hay[pos + m_guardIndex] == guardByte
+            && std::memcmp(hay + pos, needle, last) == 0)
+        {
+            return pos;
+        }
+        pos += m_skip[c];
+    }
+    return std::string_view::npos;
+}
+
+size_t LiteralMatcher::findTwoWay(std::string_view haystack, size_t from) const
+{
+    const size_t n = m_needle.size();
+    const auto* hay = reinterpret_cast<const unsigned char*>(haystack.data());
+    const auto* needle = reinterpret_cast<const unsigned char*>(m_needle.data());
+
+    size_t j = from;
+    if (m_periodic)
+    {
+        // Remember how much of the left half is known to match after a
+        // period shift so it is never compared twice.
+        size_t memory = 0;
+        while (j + n <= haystack.size())
+        {
+            size_t i = std::max(m_critical, memory);
+            while (i < n && needle[i] == hay[i + j])
+            {
+                ++i;
+            }
+            if (i >= n)
+            {
+                i = m_critical - 1;
+                while (memory < i + 1 && needle[i] == hay[i + j])
+                {
+                    --i;
+                }
+                if (i + 1 < memory + 1)
+                {
+                    return j;
+                }
+                j += m_period;
+                memory = n - m_period;
+            }
+            else
+            {
+                j += i - m_critical + 1;
+                memory = 0;
+            }
+        }
+    }
+    else
+    {
+        while (j + n <= haystack.size())
+        {
+            size_t i = m_critical;
+            while (i < n && needle[i] == hay[i + j])
+            {
+                ++i;
+            }
+            if (i >= n)
+            {
+                i = m_critical - 1;
+                while (i != SIZE_MAX && needle[i] == hay[i + j])
+                {
+                    --i;
+                }
+                if (i == SIZE_MAX)
+                {
+                    return j;
+                }
+                j += m_period;
+            }
+            else
+            {
+                j += i - m_critical + 1;
+            }
+        }
+    }
+    return std::string_view::npos;
+}
+
+} // namespace cgrep
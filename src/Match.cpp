@@ -0,0 +1,38 @@
+#include "Match.h"
+
+namespace cgrep
+{
+
+std::string_view MatchList::storePath(const std::filesystem::path& path)
+{
+    return m_arena.copy(std::string_view(path.native()));
+}
+
+void MatchList::add(std::string_view path, size_t lineNumber, std::string_view line, size_t hitOffset,
+                    bool truncated, size_t byteOffset, std::span<const Span> spans, size_t queryId)
+{
+    m_matches.push_back(Match{path, lineNumber, m_arena.copy(line), hitOffset, truncated, byteOffset,
+                              m_arena.copy(spans), queryId});
+}
+
+void MatchList::append(MatchList&& other)
+{
+    if (m_matches.empty() && m_matches.capacity() < other.m_matches.size())
+    {
+        m_matches = std::move(other.m_matches);
+    }
+    else
+    {
+        m_matches.insert(m_matches.end(), other.m_matches.begin(), other.m_matches.end());
+    }
+    m_arena.splice(std::move(other.m_arena));
+    other.m_matches.clear();
+}
+
+void MatchList::clear()
+{
+    m_matches.clear();
+    m_arena = MatchArena();
+}
+
+} // namespace cgrep
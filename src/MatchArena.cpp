@@ -0,0 +1,66 @@
+#include "MatchArena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace cgrep
+{
+
+void* MatchArena::allocate(size_t size, size_t alignment)
+{
+    auto address = reinterpret_cast<uintptr_t>(m_cursor);
+    size_t padding = (alignment - address % alignment) % alignment;
+    if (m_cursor != nullptr && padding + size <= static_cast<size_t>(m_end - m_cursor))
+    {
+        void* result = m_cursor + padding;
+        m_cursor += padding + size;
+        return result;
+    }
+
+    // new[] aligns for any fundamental type, so a fresh chunk needs no
+    // padding. Allocations over a quarter chunk (long lines) get a chunk of
+    // their own and leave the current one in use.
+    if (size > kChunkSize / 4)
+    {
+        m_chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+        m_capacity += size;
+        return m_chunks.back().get();
+    }
+    m_chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(kChunkSize));
+    m_capacity += kChunkSize;
+    m_cursor = m_chunks.back().get() + size;
+    m_end = m_chunks.back().get() + kChunkSize;
+    return m_chunks.back().get();
+}
+
+std::string_view MatchArena::copy(std::string_view text)
+{
+    if (text.empty())
+    {
+        return {};
+    }
+    char* data = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(data, text.data(), text.size());
+    return { data, text.size() };
+}
+
+void MatchArena::splice(MatchArena&& other)
+{
+    if (m_chunks.empty())
+    {
+        *this = std::move(other);
+    }
+    else
+    {
+        m_chunks.insert(m_chunks.end(), std::make_move_iterator(other.m_chunks.begin()),
+                        std::make_move_iterator(other.m_chunks.end()));
+        m_capacity += other.m_capacity;
+    }
+    other.m_chunks.clear();
+    other.m_cursor = nullptr;
+    other.m_end = nullptr;
+    other.m_capacity = 0;
+}
+
+} // namespace cgrep
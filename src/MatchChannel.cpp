@@ -0,0 +1,57 @@
+#include "MatchChannel.h"
+
+#include <utility>
+
+namespace cgrep
+{
+
+MatchChannel::MatchChannel(size_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+bool MatchChannel::push(MatchList&& batch, const std::stop_token& stop)
+{
+    const size_t count = batch.size();
+    {
+        std::unique_lock lock(m_mutex);
+        if (!m_notFull.wait(lock, stop, [&] { return m_queued == 0 || m_queued + count <= m_capacity; }))
+        {
+            return false;
+        }
+        m_queued += count;
+        m_batches.push_back(std::move(batch));
+    }
+    m_notEmpty.notify_one();
+    return true;
+}
+
+std::optional<MatchList> MatchChannel::pop()
+{
+    std::optional<MatchList> batch;
+    {
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [&] { return !m_batches.empty() || m_closed; });
+        if (m_batches.empty())
+        {
+            return std::nullopt;
+        }
+        batch.emplace(std::move(m_batches.front()));
+        m_batches.pop_front();
+        m_queued -= batch->size();
+    }
+    // Several workers may fit into the room made
+    m_notFull.notify_all();
+    return batch;
+}
+
+void MatchChannel::close()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_closed = true;
+    }
+    m_notEmpty.notify_all();
+}
+
+} // namespace cgrep
@@ -0,0 +1,162 @@
+#include "MatchSpill.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace cgrep
+{
+
+namespace
+{
+
+// Record flags
+constexpr uint8_t kTruncated = 1;
+constexpr uint8_t kNewPath = 2;
+constexpr uint8_t kQueryId = 4; // a query id follows the fixed fields
+
+// Longest line, path and span list a record can hold (u32 lengths)
+constexpr size_t kMaxLength = UINT32_MAX;
+
+template <typename T>
+void appendValue(std::string& out, T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::FILE* file, T& value)
+{
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+bool readBytes(std::FILE* file, std::string& out, size_t length)
+{
+    out.resize(length);
+    return length == 0 || std::fread(out.data(), 1, length, file) == length;
+}
+
+} // namespace
+
+// Record layout: flags (u8), line number, hit offset, byte offset (u64),
+// line length, span count (u32), [path length (u32), path], line, spans as
+// (u64 start, u64 length) pairs.
+void MatchSpill::write(const MatchList& matches)
+{
+    if (matches.empty())
+    {
+        return;
+    }
+    if (!m_file)
+    {
+        m_file.reset(std::tmpfile());
+        if (!m_file)
+        {
+            throw std::runtime_error("cannot create a temporary file to spill matches to");
+        }
+    }
+
+    for (const auto& match : matches)
+    {
+        if (match.path.size() > kMaxLength || match.spans.size() > kMaxLength)
+        {
+            throw std::runtime_error("match too large to spill: " + std::string(match.path.substr(0, 256)));
+        }
+        // A longer line is cut, as lines over the maximum line length are
+        std::string_view line = match.line.substr(0, kMaxLength);
+        bool truncated = match.truncated || line.size() < match.line.size();
+
+        m_record.clear();
+        bool newPath = m_count == 0 || match.path != m_lastPath;
+        appendValue<uint8_t>(m_record, static_cast<uint8_t>((truncated ? kTruncated : 0) |
+                                                            (newPath ? kNewPath : 0) |
+                                                            (match.query_id != 0 ? kQueryId : 0)));
+        appendValue<uint64_t>(m_record, match.line_number);
+        appendValue<uint64_t>(m_record, match.hit_offset);
+        appendValue<uint64_t>(m_record, match.byte_offset);
+        appendValue<uint32_t>(m_record, static_cast<uint32_t>(line.size()));
+        appendValue<uint32_t>(m_record, static_cast<uint32_t>(match.spans.size()));
+        if (match.query_id != 0)
+        {
+            appendValue<uint64_t>(m_record, match.query_id);
+        }
+        if (newPath)
+        {
+            appendValue<uint32_t>(m_record, static_cast<uint32_t>(match.path.size()));
+            m_record.append(match.path);
+            m_lastPath.assign(match.path);
+        }
+        m_record.append(line);
+        for (const auto& span : match.spans)
+        {
+            appendValue<uint64_t>(m_record, span.start);
+            appendValue<uint64_t>(m_record, span.length);
+        }
+
+        if (std::fwrite(m_record.data(), 1, m_record.size(), m_file.get()) != m_record.size())
+        {
+            throw std::runtime_error("cannot write spilled matches to a temporary file");
+        }
+        m_bytes += m_record.size();
+        ++m_count;
+    }
+}
+
+size_t MatchSpill::replay(const std::function<void(const Match&)>& sink)
+{
+    if (!m_file)
+    {
+        return 0;
+    }
+    if (std::fflush(m_file.get()) != 0 || std::fseek(m_file.get(), 0, SEEK_SET) != 0)
+    {
+        throw std::runtime_error("cannot read spilled matches back");
+    }
+
+    std::string path;
+    std::string line;
+    std::vector<Span> spans;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        uint8_t flags = 0;
+        uint64_t lineNumber = 0;
+        uint64_t hitOffset = 0;
+        uint64_t byteOffset = 0;
+        uint32_t lineLength = 0;
+        uint32_t spanCount = 0;
+        bool ok = readValue(m_file.get(), flags) && readValue(m_file.get(), lineNumber) &&
+                  readValue(m_file.get(), hitOffset) && readValue(m_file.get(), byteOffset) &&
+                  readValue(m_file.get(), lineLength) && readValue(m_file.get(), spanCount);
+        uint64_t queryId = 0;
+        if (ok && (flags & kQueryId) != 0)
+        {
+            ok = readValue(m_file.get(), queryId);
+        }
+        if (ok && (flags & kNewPath) != 0)
+        {
+            uint32_t pathLength = 0;
+            ok = readValue(m_file.get(), pathLength) && readBytes(m_file.get(), path, pathLength);
+        }
+        ok = ok && readBytes(m_file.get(), line, lineLength);
+        spans.resize(spanCount);
+        for (size_t k = 0; ok && k < spanCount; ++k)
+        {
+            uint64_t start = 0;
+            uint64_t length = 0;
+            ok = readValue(m_file.get(), start) && readValue(m_file.get(), length);
+            spans[k] = Span{start, length};
+        }
+        if (!ok)
+        {
+            throw std::runtime_error("cannot read spilled matches back");
+        }
+
+        sink(Match{path, lineNumber, line, hitOffset, (flags & kTruncated) != 0, byteOffset, spans, queryId});
+    }
+    return m_count;
+}
+
+} // namespace cgrep
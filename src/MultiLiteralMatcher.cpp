@@ -0,0 +1,426 @@
+#include "MultiLiteralMatcher.h"
+#include "CaseFolding.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CGREP_HAVE_TEDDY 1
+#include <immintrin.h>
+#endif
+
+namespace cgrep
+{
+
+// Teddy is used for sets of at most this many patterns; beyond that the
+// buckets hold too many patterns and verification dominates.
+static constexpr size_t kTeddyMaxPatterns = 64;
+
+static constexpr uint32_t kNoState = UINT32_MAX;
+
+#ifdef CGREP_HAVE_TEDDY
+
+using TeddyMasks = std::array<std::array<uint8_t, 16>, 3>;
+
+// Scan 16 positions per step with SSSE3 byte shuffles, starting at `pos`.
+// On success `pos` is the start of the first block containing candidates and
+// `out` holds the bucket bits of its 16 positions; otherwise `pos` is the
+// first position left for the scalar tail.
+__attribute__((target("ssse3")))
+static bool teddyScanSsse3(const unsigned char* hay, size_t& pos, size_t limit,
+                           const TeddyMasks& low, const TeddyMasks& high, uint8_t* out)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i lowMask[3];
+    __m128i highMask[3];
+    for (size_t k = 0; k < 3; ++k)
+    {
+        lowMask[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low[k].data()));
+        highMask[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high[k].data()));
+    }
+
+    for (; pos + 2 + 16 <= limit; pos += 16)
+    {
+        __m128i buckets = _mm_set1_epi8(-1);
+        for (size_t k = 0; k < 3; ++k)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + pos + k));
+            __m128i lo = _mm_and_si128(chunk, nibble);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble);
+            buckets = _mm_and_si128(buckets,
+                _mm_and_si128(_mm_shuffle_epi8(lowMask[k], lo), _mm_shuffle_epi8(highMask[k], hi)));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(buckets, _mm_setzero_si128())) != 0xFFFF)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), buckets);
+            return true;
+        }
+    }
+    return false;
+}
+
+// AVX2 variant of teddyScanSsse3 covering 32 positions per step. Byte
+// shuffles work per 128-bit lane, so the tables are repeated in both lanes.
+__attribute__((target("avx2")))
+static bool teddyScanAvx2(const unsigned char* hay, size_t& pos, size_t limit,
+                          const TeddyMasks& low, const TeddyMasks& high, uint8_t* out)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i lowMask[3];
+    __m256i highMask[3];
+    for (size_t k = 0; k < 3; ++k)
+    {
+        lowMask[k] = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(low[k].data())));
+        highMask[k] = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(high[k].data())));
+    }
+
+    for (; pos + 2 + 32 <= limit; pos += 32)
+    {
+        __m256i buckets = _mm256_set1_epi8(-1);
+        for (size_t k = 0; k < 3; ++k)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + pos + k));
+            __m256i lo = _mm256_and_si256(chunk, nibble);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble);
+            buckets = _mm256_and_si256(buckets,
+                _mm256_and_si256(_mm256_shuffle_epi8(lowMask[k], lo), _mm256_shuffle_epi8(highMask[k], hi)));
+        }
+        if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(buckets, _mm256_setzero_si256())))
+            != 0xFFFFFFFFu)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), buckets);
+            return true;
+        }
+    }
+    return false;
+}
+
+using TeddyScanFn = bool (*)(const unsigned char*, size_t&, size_t,
+                             const TeddyMasks&, const TeddyMasks&, uint8_t*);
+
+// Helper: pick the widest Teddy scan the CPU supports, once per process.
+// Returns the scan function and its block width, or {nullptr, 0}.
+static std::pair<TeddyScanFn, size_t> selectTeddyScan()
+{
+    static const std::pair<TeddyScanFn, size_t> selected = []() -> std::pair<TeddyScanFn, size_t>
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return { teddyScanAvx2, 32 };
+        }
+        if (__builtin_cpu_supports("ssse3"))
+        {
+            return { teddyScanSsse3, 16 };
+        }
+        return { nullptr, 0 };
+    }();
+    return selected;
+}
+
+#endif // CGREP_HAVE_TEDDY
+
+MultiLiteralMatcher::MultiLiteralMatcher(std::vector<std::string> patterns, bool asciiCaseInsensitive)
+    : m_patterns(std::move(patterns))
+    , m_caseInsensitive(asciiCaseInsensitive)
+{
+    size_t minLength = SIZE_MAX;
+    for (auto& p : m_patterns)
+    {
+        if (m_caseInsensitive)
+        {
+            for (auto& c : p)
+            {
+                c = static_cast<char>(foldAscii(static_cast<unsigned char>(c)));
+            }
+        }
+        m_maxLength = std::max(m_maxLength, p.size());
+        minLength = std::min(minLength, p.size());
+        m_hasEmpty = m_hasEmpty || p.empty();
+    }
+
+    bool useTeddy = !m_patterns.empty() && !m_hasEmpty && m_patterns.size() <= kTeddyMaxPatterns;
+#ifdef CGREP_HAVE_TEDDY
+    useTeddy = useTeddy && selectTeddyScan().first != nullptr;
+#else
+    useTeddy = false;
+#endif
+
+    if (useTeddy)
+    {
+        m_algorithm = Algorithm::Teddy;
+        m_maskLength = std::min<size_t>(3, minLength);
+        buildTeddy();
+    }
+    else
+    {
+        m_algorithm = Algorithm::AhoCorasick;
+        buildAhoCorasick();
+    }
+}
+
+void MultiLiteralMatcher::buildTeddy()
+{
+    // Sorted patterns share prefixes with their neighbours; giving contiguous
+    // runs to the same bucket keeps the bucket masks selective.
+    std::vector<size_t> order(m_patterns.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [this](size_t a, size_t b) { return m_patterns[a] < m_patterns[b]; });
+
+    // Unused mask positions accept every byte
+    for (size_t k = 0; k < 3; ++k)
+    {
+        m_lowMasks[k].fill(k < m_maskLength ? 0 : 0xFF);
+        m_highMasks[k].fill(k < m_maskLength ? 0 : 0xFF);
+    }
+
+    for (size_t rank = 0; rank < order.size(); ++rank)
+    {
+        size_t bucket = rank * kBuckets / order.size();
+        size_t index = order[rank];
+        m_bucketPatterns[bucket].push_back(index);
+
+        auto bit = static_cast<uint8_t>(1u << bucket);
+        for (size_t k = 0; k < m_maskLength; ++k)
+        {
+            auto c = static_cast<unsigned char>(m_patterns[index][k]);
+            m_lowMasks[k][c & 0x0F] |= bit;
+            m_highMasks[k][c >> 4] |= bit;
+            if (m_caseInsensitive && c >= 'a' && c <= 'z')
+            {
+                auto upper = static_cast<unsigned char>(c - 0x20);
+                m_lowMasks[k][upper & 0x0F] |= bit;
+                m_highMasks[k][upper >> 4] |= bit;
+            }
+        }
+    }
+}
+
+void MultiLiteralMatcher::buildAhoCorasick()
+{
+    // Trie construction: kNoState marks missing edges until the BFS below
+    // turns the trie into a complete DFA.
+    m_transitions.assign(256, kNoState);
+    m_outputLength.assign(1, 0);
+    m_outputPattern.assign(1, 0);
+
+    for (size_t index = 0; index < m_patterns.size(); ++index)
+    {
+        uint32_t state = 0;
+        for (unsigned char c : m_patterns[index])
+        {
+            uint32_t& next = m_transitions[state * 256u + c];
+            if (next == kNoState)
+            {
+                next = static_cast<uint32_t>(m_outputLength.size());
+                m_transitions.resize(m_transitions.size() + 256, kNoState);
+                m_outputLength.push_back(0);
+                m_outputPattern.push_back(0);
+            }
+            state = m_transitions[state * 256u + c];
+        }
+        if (m_outputLength[state] == 0) // first of duplicate patterns wins
+        {
+            m_outputLength[state] = static_cast<uint32_t>(m_patterns[index].size());
+            m_outputPattern[state] = static_cast<uint32_t>(index);
+        }
+    }
+
+    // Breadth-first: fill missing edges from the failure state. A state's own
+    // pattern is always the longest one ending there; states without one
+    // inherit the (shorter) output of their failure state.
+    std::vector<uint32_t> failure(m_outputLength.size(), 0);
+    std::queue<uint32_t> pending;
+    for (size_t c = 0; c < 256; ++c)
+    {
+        uint32_t& next = m_transitions[c];
+        if (next == kNoState)
+        {
+            next = 0;
+        }
+        else
+        {
+            failure[next] = 0;
+            pending.push(next);
+        }
+    }
+
+    while (!pending.empty())
+    {
+        uint32_t state = pending.front();
+        pending.pop();
+        if (m_outputLength[state] == 0 && m_outputLength[failure[state]] != 0)
+        {
+            m_outputLength[state] = m_outputLength[failure[state]];
+            m_outputPattern[state] = m_outputPattern[failure[state]];
+        }
+
+        for (size_t c = 0; c < 256; ++c)
+        {
+            uint32_t& next = m_transitions[state * 256u + c];
+            uint32_t fallback = m_transitions[failure[state] * 256u + c];
+            if (next == kNoState)
+            {
+                next = fallback;
+            }
+            else
+            {
+                failure[next] = fallback;
+                pending.push(next);
+            }
+        }
+    }
+
+    // Patterns are lowercase: uppercase letters follow the lowercase edges
+    if (m_caseInsensitive)
+    {
+        for (size_t state = 0; state < m_outputLength.size(); ++state)
+        {
+            for (size_t c = 'A'; c <= 'Z'; ++c)
+            {
+                m_transitions[state * 256u + c] = m_transitions[state * 256u + c + 0x20];
+            }
+        }
+    }
+}
+
+bool MultiLiteralMatcher::find(std::string_view haystack, size_t from, Hit& hit) const
+{
+    if (from > haystack.size())
+    {
+        return false;
+    }
+    if (m_hasEmpty)
+    {
+        // The empty pattern matches right away; prefer a longer one starting here
+        hit = Hit{from, 0, 0};
+        for (size_t index = 0; index < m_patterns.size(); ++index)
+        {
+            const auto& p = m_patterns[index];
+            if (p.empty() && hit.length == 0)
+            {
+                hit.pattern = index;
+            }
+            else if (p.size() > hit.length && p.size() <= haystack.size() - from
+                     && patternAt(haystack, from, index))
+            {
+                hit = Hit{from, p.size(), index};
+            }
+        }
+        return true;
+    }
+    if (m_algorithm == Algorithm::Teddy)
+    {
+        return findTeddy(haystack, from, hit);
+    }
+    return findAhoCorasick(haystack, from, hit);
+}
+
+bool MultiLiteralMatcher::patternAt(std::string_view haystack, size_t position, size_t index) const
+{
+    const auto& p = m_patterns[index];
+    const auto* hay = reinterpret_cast<const unsigned char*>(haystack.data()) + position;
+    if (m_caseInsensitive)
+    {
+        return equalsAsciiFolded(hay, reinterpret_cast<const unsigned char*>(p.data()), p.size());
+    }
+    return std::memcmp(hay, p.data(), p.size()) == 0;
+}
+
+bool MultiLiteralMatcher::verifyBuckets(std::string_view haystack, size_t position,
+                                        uint8_t buckets, Hit& hit) const
+{
+    bool found = false;
+    while (buckets != 0)
+    {
+        auto bucket = static_cast<size_t>(__builtin_ctz(buckets));
+        buckets = static_cast<uint8_t>(buckets & (buckets - 1));
+        for (size_t index : m_bucketPatterns[bucket])
+        {
+            const auto& p = m_patterns[index];
+            if ((!found || p.size() > hit.length)
+                && p.size() <= haystack.size() - position
+                && patternAt(haystack, position, index))
+            {
+                hit = Hit{position, p.size(), index};
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+bool MultiLiteralMatcher::findTeddy(std::string_view haystack, size_t from, Hit& hit) const
+{
+    const auto* hay = reinterpret_cast<const unsigned char*>(haystack.data());
+    const size_t size = haystack.size();
+    size_t pos = from;
+
+#ifdef CGREP_HAVE_TEDDY
+    auto [scan, width] = selectTeddyScan();
+    alignas(32) uint8_t blockBuckets[32];
+    while (scan(hay, pos, size, m_lowMasks, m_highMasks, blockBuckets))
+    {
+        for (size_t j = 0; j < width; ++j)
+        {
+            if (blockBuckets[j] != 0 && verifyBuckets(haystack, pos + j, blockBuckets[j], hit))
+            {
+                return true;
+            }
+        }
+        pos += width;
+    }
+#endif
+
+    // Scalar tail: evaluate the same nibble masks one position at a time
+    for (; pos + m_maskLength <= size; ++pos)
+    {
+        uint8_t buckets = 0xFF;
+        for (size_t k = 0; k < m_maskLength; ++k)
+        {
+            unsigned char c = hay[pos + k];
+            buckets &= static_cast<uint8_t>(m_lowMasks[k][c & 0x0F] & m_highMasks[k][c >> 4]);
+        }
+        if (buckets != 0 && verifyBuckets(haystack, pos, buckets, hit))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MultiLiteralMatcher::findAhoCorasick(std::string_view haystack, size_t from, Hit& hit) const
+{
+    const auto* hay = reinterpret_cast<const unsigned char*>(haystack.data());
+    bool found = false;
+    uint32_t state = 0;
+    for (size_t i = from; i < haystack.size(); ++i)
+    {
+        state = m_transitions[state * 256u + hay[i]];
+        uint32_t length = m_outputLength[state];
+        if (length != 0)
+        {
+            // The longest pattern ending here has the leftmost start
+            size_t start = i + 1 - length;
+            if (!found || start <= hit.position)
+            {
+                hit = Hit{start, length, m_outputPattern[state]};
+                found = true;
+            }
+        }
+        // A match ending later than this cannot start at or before the best one
+        if (found && i + 1 >= hit.position + m_maxLength)
+        {
+            break;
+        }
+    }
+    return found;
+}
+
+} // namespace cgrep
@@ -0,0 +1,410 @@
+#include "PikeVM.h"
+
+#include <algorithm>
+
+namespace cgrep
+{
+
+namespace
+{
+
+using Instruction = PikeVM::Instruction;
+using Op = PikeVM::Instruction::Op;
+
+// ECMAScript \w, which \b and \B test
+bool isRegexWordByte(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Emits the program for a tree; every emit returns false once the program
+// grows past PikeVM::kMaxInstructions
+class ProgramBuilder
+{
+public:
+    std::vector<Instruction> program;
+    std::vector<ByteSet>     byteSets;
+    bool                     lineAnchors = false;
+
+    bool emit(const RegexNode& node)
+    {
+        switch (node.kind)
+        {
+            case RegexNode::Kind::Empty:
+                return true;
+            case RegexNode::Kind::Bytes:
+            {
+                ByteSet bytes = node.bytes;
+                bytes.reset('\n'); // never part of a line
+                byteSets.push_back(bytes);
+                return push(Op::Bytes, static_cast<uint32_t>(byteSets.size() - 1));
+            }
+            case RegexNode::Kind::Concat:
+                return std::all_of(node.children.begin(), node.children.end(),
+                                   [this](const RegexNode& child) { return emit(child); });
+            case RegexNode::Kind::Alternate:
+                return emitAlternate(node);
+            case RegexNode::Kind::Repeat:
+                return emitRepeat(node);
+            case RegexNode::Kind::Group:
+                if (node.capture == 0)
+                {
+                    return emit(node.children.front());
+                }
+                return push(Op::Save, static_cast<uint32_t>(2 * node.capture)) &&
+                       emit(node.children.front()) &&
+                       push(Op::Save, static_cast<uint32_t>(2 * node.capture + 1));
+            default:
+                lineAnchors = lineAnchors || node.kind == RegexNode::Kind::LineStart ||
+                              node.kind == RegexNode::Kind::LineEnd;
+                return push(Op::Assert, static_cast<uint32_t>(node.kind));
+        }
+    }
+
+    bool push(Op op, uint32_t x = 0, uint32_t y = 0)
+    {
+        program.push_back(Instruction{op, x, y});
+        return program.size() <= PikeVM::kMaxInstructions;
+    }
+
+private:
+    uint32_t here() const { return static_cast<uint32_t>(program.size()); }
+
+    bool emitAlternate(const RegexNode& node)
+    {
+        // Split to each alternative in turn; all of them jump to the end
+        std::vector<uint32_t> jumps;
+        for (size_t i = 0; i + 1 < node.children.size(); ++i)
+        {
+            uint32_t split = here();
+            if (!push(Op::Split, split + 1) || !emit(node.children[i]))
+            {
+                return false;
+            }
+            jumps.push_back(here());
+            if (!push(Op::Jump))
+            {
+                return false;
+            }
+            program[split].y = here();
+        }
+        if (!emit(node.children.back()))
+        {
+            return false;
+        }
+        for (uint32_t jump : jumps)
+        {
+            program[jump].x = here();
+        }
+        return true;
+    }
+
+    // x{min,max} is min copies of x followed by max - min nested optional
+    // copies; an unbounded x{min,} ends with a looping copy. Quantifiers are
+    // greedy, so each split prefers another copy.
+    bool emitRepeat(const RegexNode& node)
+    {
+        const RegexNode& child = node.children.front();
+        if (node.max == RegexNode::kUnbounded)
+        {
+            for (size_t i = 1; i < node.min; ++i)
+            {
+                if (!emit(child))
+                {
+                    return false;
+                }
+            }
+            if (node.min == 0)
+            {
+                uint32_t split = here();
+                if (!push(Op::Split, split + 1) || !emit(child) || !push(Op::Jump, split))
+                {
+                    return false;
+                }
+                program[split].y = here();
+                return true;
+            }
+            uint32_t loop = here();
+            if (!emit(child) || !push(Op::Split, loop))
+            {
+                return false;
+            }
+            program.back().y = here();
+            return true;
+        }
+
+        for (size_t i = 0; i < node.min; ++i)
+        {
+            if (!emit(child))
+            {
+                return false;
+            }
+        }
+        std::vector<uint32_t> splits;
+        for (size_t i = node.min; i < node.max; ++i)
+        {
+            splits.push_back(here());
+            if (!push(Op::Split, here() + 1) || !emit(child))
+            {
+                return false;
+            }
+        }
+        for (uint32_t split : splits)
+        {
+            program[split].y = here();
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+void PikeVM::Scratch::prepare(size_t instructions, size_t slots)
+{
+    for (ThreadList* list : { &m_current, &m_next })
+    {
+        if (list->sparse.size() < instructions)
+        {
+            list->dense.resize(instructions);
+            list->sparse.resize(instructions);
+        }
+        if (list->slots.size() < instructions * slots)
+        {
+            list->slots.resize(instructions * slots);
+        }
+        list->size = 0;
+    }
+    m_slots.resize(slots);
+    m_captures.resize(slots);
+    if (m_stack.capacity() < instructions * 2)
+    {
+        m_stack.reserve(instructions * 2);
+    }
+}
+
+std::optional<PikeVM> PikeVM::compile(const RegexNode& root)
+{
+    ProgramBuilder builder;
+    if (!builder.push(Op::Save, 0) || !builder.emit(root) || !builder.push(Op::Save, 1) ||
+        !builder.push(Op::Match))
+    {
+        return std::nullopt;
+    }
+
+    PikeVM vm;
+    vm.m_program = std::move(builder.program);
+    vm.m_byteSets = std::move(builder.byteSets);
+    vm.m_slotCount = 2 * (countCaptures(root) + 1);
+    vm.m_lineAnchors = builder.lineAnchors;
+
+    // Collect the bytes reachable from the start without consuming any;
+    // assertions are assumed to hold, which only widens the set
+    ByteSet start;
+    bool matchesEmpty = false;
+    std::vector<bool> seen(vm.m_program.size(), false);
+    std::vector<uint32_t> pending = { 0 };
+    while (!pending.empty())
+    {
+        uint32_t pc = pending.back();
+        pending.pop_back();
+        if (seen[pc])
+        {
+            continue;
+        }
+        seen[pc] = true;
+        const Instruction& instruction = vm.m_program[pc];
+        switch (instruction.op)
+        {
+            case Op::Bytes:
+                start |= vm.m_byteSets[instruction.x];
+                break;
+            case Op::Split:
+                pending.push_back(instruction.x);
+                pending.push_back(instruction.y);
+                break;
+            case Op::Jump:
+                pending.push_back(instruction.x);
+                break;
+            case Op::Save:
+            case Op::Assert:
+                pending.push_back(pc + 1);
+                break;
+            case Op::Match:
+                matchesEmpty = true;
+                break;
+        }
+    }
+    vm.m_skipToStart = !matchesEmpty;
+    for (unsigned c = 0; c < 256; ++c)
+    {
+        vm.m_startBytes[c] = start.test(c);
+    }
+    return vm;
+}
+
+bool PikeVM::assertionHolds(RegexNode::Kind kind, std::string_view text, size_t position,
+                            bool lineContinues) const
+{
+    switch (kind)
+    {
+        case RegexNode::Kind::LineStart:
+            return position == 0;
+        case RegexNode::Kind::LineEnd:
+            return position == text.size() && !lineContinues;
+        case RegexNode::Kind::WordBoundary:
+        case RegexNode::Kind::NotWordBoundary:
+        case RegexNode::Kind::WordStart:
+        case RegexNode::Kind::WordEnd:
+        {
+            if (position == text.size() && lineContinues)
+            {
+                return false; // decided by the next window
+            }
+            bool before = position > 0 && isRegexWordByte(static_cast<unsigned char>(text[position - 1]));
+            bool after = position < text.size() && isRegexWordByte(static_cast<unsigned char>(text[position]));
+            if (kind == RegexNode::Kind::WordStart || kind == RegexNode::Kind::WordEnd)
+            {
+                return kind == RegexNode::Kind::WordStart ? !before && after : before && !after;
+            }
+            return (before != after) == (kind == RegexNode::Kind::WordBoundary);
+        }
+        case RegexNode::Kind::NoWordBefore:
+            return position == 0 || !isWordByte(static_cast<unsigned char>(text[position - 1]));
+        case RegexNode::Kind::NoWordAfter:
+            if (position == text.size())
+            {
+                return !lineContinues;
+            }
+            return !isWordByte(static_cast<unsigned char>(text[position]));
+        default:
+            return false;
+    }
+}
+
+void PikeVM::addThread(Scratch& scratch, Scratch::ThreadList& list, uint32_t pc, std::string_view text,
+                       size_t position, bool lineContinues) const
+{
+    auto& stack = scratch.m_stack;
+    stack.clear();
+    stack.push_back(Scratch::Frame{pc});
+    while (!stack.empty())
+    {
+        Scratch::Frame frame = stack.back();
+        stack.pop_back();
+        if (frame.restore)
+        {
+            scratch.m_slots[frame.slot] = frame.value;
+            continue;
+        }
+
+        pc = frame.pc;
+        while (!list.contains(pc))
+        {
+            list.sparse[pc] = static_cast<uint32_t>(list.size);
+            list.dense[list.size++] = pc;
+
+            const Instruction& instruction = m_program[pc];
+            if (instruction.op == Op::Jump)
+            {
+                pc = instruction.x;
+            }
+            else if (instruction.op == Op::Split)
+            {
+                stack.push_back(Scratch::Frame{instruction.y});
+                pc = instruction.x;
+            }
+            else if (instruction.op == Op::Save)
+            {
+                stack.push_back(Scratch::Frame{0, instruction.x, scratch.m_slots[instruction.x], true});
+                scratch.m_slots[instruction.x] = position;
+                ++pc;
+            }
+            else if (instruction.op == Op::Assert)
+            {
+                if (!assertionHolds(static_cast<RegexNode::Kind>(instruction.x), text, position, lineContinues))
+                {
+                    break;
+                }
+                ++pc;
+            }
+            else
+            {
+                // Bytes or Match: the thread waits here for the next step
+                std::copy(scratch.m_slots.begin(), scratch.m_slots.end(),
+                          list.slots.begin() + static_cast<std::ptrdiff_t>(pc * m_slotCount));
+                break;
+            }
+        }
+    }
+}
+
+bool PikeVM::search(std::string_view text, size_t from, Scratch& scratch, bool lineContinues) const
+{
+    constexpr size_t npos = std::string_view::npos;
+    if (from > text.size())
+    {
+        return false;
+    }
+    scratch.prepare(m_program.size(), m_slotCount);
+    Scratch::ThreadList* current = &scratch.m_current;
+    Scratch::ThreadList* next = &scratch.m_next;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    bool matched = false;
+
+    for (size_t position = from;; ++position)
+    {
+        if (!matched)
+        {
+            if (current->size == 0 && m_skipToStart)
+            {
+                while (position < text.size() && !m_startBytes[bytes[position]])
+                {
+                    ++position;
+                }
+                if (position == text.size())
+                {
+                    break;
+                }
+            }
+            // A new thread has the lowest priority: it starts further right
+            std::fill(scratch.m_slots.begin(), scratch.m_slots.end(), npos);
+            addThread(scratch, *current, 0, text, position, lineContinues);
+        }
+        if (current->size == 0)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < current->size; ++i)
+        {
+            uint32_t pc = current->dense[i];
+            const Instruction& instruction = m_program[pc];
+            const size_t* slots = current->slots.data() + pc * m_slotCount;
+            if (instruction.op == Op::Bytes)
+            {
+                if (position < text.size() && m_byteSets[instruction.x].test(bytes[position]))
+                {
+                    std::copy(slots, slots + m_slotCount, scratch.m_slots.begin());
+                    addThread(scratch, *next, pc + 1, text, position + 1, lineContinues);
+                }
+            }
+            else if (instruction.op == Op::Match)
+            {
+                // Threads after this one have lower priority
+                matched = true;
+                std::copy(slots, slots + m_slotCount, scratch.m_captures.begin());
+                break;
+            }
+        }
+
+        std::swap(current, next);
+        next->size = 0;
+        if (position == text.size())
+        {
+            break;
+        }
+    }
+    return matched;
+}
+
+} // namespace cgrep
@@ -0,0 +1,505 @@
+#include "RegexAnalysis.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace cgrep
+{
+
+size_t findNestedQuantifier(std::string_view pattern)
+{
+    constexpr size_t npos = std::string_view::npos;
+
+    // Open groups, with whether they contain an unbounded quantifier; the
+    // bottom entry stands for the whole pattern
+    struct Group
+    {
+        size_t start = 0;
+        bool   unbounded = false;
+    };
+    std::vector<Group> groups(1);
+
+    // The atom a following quantifier applies to: a closed group or not
+    bool   atomIsGroup = false;
+    Group  atom;
+
+    size_t i = 0;
+    while (i < pattern.size())
+    {
+        char c = pattern[i];
+        if (c == '\\')
+        {
+            atomIsGroup = false;
+            i += 2;
+        }
+        else if (c == '[')
+        {
+            // Skip the class; a ']' right after '[' or '[^' is literal
+            size_t j = i + 1;
+            if (j < pattern.size() && pattern[j] == '^')
+            {
+                ++j;
+            }
+            if (j < pattern.size() && pattern[j] == ']')
+            {
+                ++j;
+            }
+            while (j < pattern.size() && pattern[j] != ']')
+            {
+                j += pattern[j] == '\\' ? 2 : 1;
+            }
+            atomIsGroup = false;
+            i = j + 1;
+        }
+        else if (c == '(')
+        {
+            groups.push_back(Group{i, false});
+            atomIsGroup = false;
+            ++i;
+            if (i < pattern.size() && pattern[i] == '?')
+            {
+                i += 2; // (?: (?= (?!
+            }
+        }
+        else if (c == ')' && groups.size() > 1)
+        {
+            atom = groups.back();
+            atomIsGroup = true;
+            groups.pop_back();
+            // What is inside a group is inside the enclosing one too
+            groups.back().unbounded = groups.back().unbounded || atom.unbounded;
+            ++i;
+        }
+        else if (c == '*' || c == '+' || c == '?' || c == '{')
+        {
+            bool unbounded = c != '?';
+            size_t end = i + 1;
+            if (c == '{')
+            {
+                end = pattern.find('}', i);
+                if (end == npos)
+                {
+                    return npos; // not a valid quantifier; the regex compiler rejects it
+                }
+                std::string_view bounds = pattern.substr(i + 1, end - i - 1);
+                unbounded = !bounds.empty() && bounds.back() == ',';
+                ++end;
+            }
+            if (unbounded && atomIsGroup && atom.unbounded)
+            {
+                return atom.start;
+            }
+            groups.back().unbounded = groups.back().unbounded || unbounded;
+            atomIsGroup = false;
+            i = end;
+            if (i < pattern.size() && pattern[i] == '?')
+            {
+                ++i; // lazy
+            }
+        }
+        else
+        {
+            atomIsGroup = false;
+            ++i;
+        }
+    }
+    return npos;
+}
+
+// Helper: append `c` to an ECMAScript pattern as a literal, inside a class
+// if `inClass`
+static void appendLiteral(std::string& out, char c, bool inClass)
+{
+    std::string_view special = inClass ? "\\[]-^" : "\\^$.*+?()[]{}|/";
+    if (special.find(c) != std::string_view::npos)
+    {
+        out += '\\';
+    }
+    out += c;
+}
+
+// Helper: the length of the interval `{m}`, `{m,}`, `{,n}` or `{m,n}` at
+// the start of `pattern`, or 0 if it does not start with one
+static size_t intervalLength(std::string_view pattern)
+{
+    size_t end = pattern.find('}');
+    if (end == std::string_view::npos || end < 2)
+    {
+        return 0;
+    }
+    std::string_view bounds = pattern.substr(1, end - 1);
+    size_t comma = bounds.find(',');
+    bool digits = std::all_of(bounds.begin(), bounds.end(), [](char c)
+    {
+        return c == ',' || (c >= '0' && c <= '9');
+    });
+    if (!digits || (comma != std::string_view::npos && bounds.find(',', comma + 1) != std::string_view::npos))
+    {
+        return 0;
+    }
+    return end + 1;
+}
+
+std::string extendedToECMAScript(std::string_view pattern)
+{
+    constexpr size_t npos = std::string_view::npos;
+
+    std::string out;
+    out.reserve(pattern.size() + 16);
+    // Where the atom a following quantifier applies to starts in `out`
+    // (npos if there is none, so that the quantifier is literal), whether
+    // it is already quantified, and where the open groups start
+    size_t atom = npos;
+    bool quantified = false;
+    char quantifier = '\0'; // the last one if it is * + or ?
+    std::vector<size_t> groups;
+
+    size_t i = 0;
+    while (i < pattern.size())
+    {
+        const size_t start = out.size();
+        char c = pattern[i++];
+        size_t interval = c == '{' ? intervalLength(pattern.substr(i - 1)) : 0;
+        if ((c == '*' || c == '+' || c == '?' || interval > 0) && atom != npos)
+        {
+            // ERE repeats a quantified atom again, where ECMAScript would
+            // read a lazy quantifier or reject it. Two of * + ? repeat like
+            // one, which keeps the nested quantifier check quiet.
+            if (quantified && quantifier != '\0' && interval == 0)
+            {
+                out.back() = c == quantifier ? c : '*';
+                quantifier = out.back();
+                continue;
+            }
+            if (quantified)
+            {
+                out.insert(atom, "(?:");
+                out += ')';
+            }
+            if (interval > 0)
+            {
+                out += pattern[i] == ',' ? "{0" : "{";
+                out += pattern.substr(i, interval - 1);
+                i += interval - 1;
+            }
+            else
+            {
+                out += c;
+            }
+            quantified = true;
+            quantifier = interval > 0 ? '\0' : c;
+            continue;
+        }
+
+        if (c == '\\' && i < pattern.size())
+        {
+            char e = pattern[i++];
+            if (e == '<' || e == '>' || e == 'b' || e == 'B')
+            {
+                out += e == '<' ? "\\b(?=\\w)" : e == '>' ? "\\b(?!\\w)" : e == 'b' ? "\\b" : "\\B";
+                // ECMAScript cannot repeat an assertion, so a quantifier
+                // after one wraps it in a group
+                atom = start;
+                quantified = true;
+                quantifier = '\0';
+                continue;
+            }
+            if ((e >= '1' && e <= '9') || std::string_view("wWsS").find(e) != npos)
+            {
+                out += '\\';
+                out += e;
+            }
+            else
+            {
+                appendLiteral(out, e, false);
+            }
+        }
+        else if (c == '[')
+        {
+            // Copy the bracket expression, escaping what ECMAScript reads
+            // differently; a ']' right after '[' or '[^' is literal
+            out += '[';
+            if (i < pattern.size() && pattern[i] == '^')
+            {
+                out += '^';
+                ++i;
+            }
+            if (i < pattern.size() && pattern[i] == ']')
+            {
+                out += "\\]";
+                ++i;
+            }
+            while (i < pattern.size() && pattern[i] != ']')
+            {
+                char kind = i + 1 < pattern.size() ? pattern[i + 1] : '\0';
+                size_t end = pattern[i] == '[' && (kind == ':' || kind == '=' || kind == '.')
+                                 ? pattern.find(std::string{kind, ']'}, i + 2)
+                                 : npos;
+                if (end == npos)
+                {
+                    appendLiteral(out, pattern[i++], true);
+                }
+                else if (kind != ':' && end == i + 3)
+                {
+                    appendLiteral(out, pattern[i + 2], true); // [.-.] and [=a=]
+                    i = end + 2;
+                }
+                else
+                {
+                    out += pattern.substr(i, end + 2 - i);
+                    i = end + 2;
+                }
+            }
+            if (i < pattern.size())
+            {
+                out += ']';
+                ++i;
+            }
+        }
+        else if (c == '.')
+        {
+            out += "[^\\n]";
+        }
+        else if (c == '(')
+        {
+            groups.push_back(start);
+            out += c;
+            atom = npos;
+            continue;
+        }
+        else if (c == ')' && !groups.empty())
+        {
+            out += c;
+            atom = groups.back();
+            groups.pop_back();
+            quantified = false;
+            continue;
+        }
+        else if (c == '|' || c == '^' || c == '$' || c == '\\')
+        {
+            out += c; // a trailing backslash stays invalid
+            atom = npos;
+            continue;
+        }
+        else
+        {
+            appendLiteral(out, c, false);
+        }
+        atom = start;
+        quantified = false;
+    }
+    return out;
+}
+
+// Helper: if `node` matches one byte, or one ASCII letter in either case,
+// store that byte (lowercased for a letter) and whether it is caseless
+static bool literalByte(const RegexNode& node, char& byte, bool& caseless)
+{
+    if (node.kind != RegexNode::Kind::Bytes || node.bytes.count() > 2)
+    {
+        return false;
+    }
+    size_t first = 0;
+    while (first < 256 && !node.bytes.test(first))
+    {
+        ++first;
+    }
+    if (node.bytes.count() == 1)
+    {
+        byte = static_cast<char>(first);
+        caseless = false;
+        return true;
+    }
+    if (first >= 'A' && first <= 'Z' && node.bytes.test(first - 'A' + 'a'))
+    {
+        byte = static_cast<char>(first - 'A' + 'a');
+        caseless = true;
+        return true;
+    }
+    return false;
+}
+
+// Helper: lowercase the ASCII letters of `bytes`, for caseless comparison
+static void lowercaseAscii(std::string& bytes)
+{
+    for (auto& c : bytes)
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+}
+
+// Helper: most bytes a hit of `node` can span, or RegexNode::kUnbounded
+static size_t maxHitLength(const RegexNode& node)
+{
+    constexpr size_t unbounded = RegexNode::kUnbounded;
+    switch (node.kind)
+    {
+        case RegexNode::Kind::Bytes:
+            return 1;
+        case RegexNode::Kind::Concat:
+        {
+            size_t total = 0;
+            for (const auto& child : node.children)
+            {
+                size_t length = maxHitLength(child);
+                if (length == unbounded)
+                {
+                    return unbounded;
+                }
+                total += length;
+            }
+            return total;
+        }
+        case RegexNode::Kind::Alternate:
+        {
+            size_t longest = 0;
+            for (const auto& child : node.children)
+            {
+                longest = std::max(longest, maxHitLength(child));
+            }
+            return longest;
+        }
+        case RegexNode::Kind::Repeat:
+        {
+            size_t length = maxHitLength(node.children.front());
+            if (length == 0 || node.max == 0)
+            {
+                return 0;
+            }
+            if (length == unbounded || node.max == unbounded || length > unbounded / node.max)
+            {
+                return unbounded;
+            }
+            return length * node.max;
+        }
+        case RegexNode::Kind::Group:
+            return maxHitLength(node.children.front());
+        default:
+            return 0; // empty string and assertions
+    }
+}
+
+// Helper: add every byte `node` can match to `bytes`
+static void collectBytes(const RegexNode& node, ByteSet& bytes)
+{
+    if (node.kind == RegexNode::Kind::Bytes)
+    {
+        bytes |= node.bytes;
+    }
+    for (const auto& child : node.children)
+    {
+        collectBytes(child, bytes);
+    }
+}
+
+// Helper: append the top-level sequence of `node` to `items`, looking
+// through groups, which do not change what matches
+static void flattenSequence(const RegexNode& node, std::vector<const RegexNode*>& items)
+{
+    if (node.kind == RegexNode::Kind::Concat)
+    {
+        for (const auto& child : node.children)
+        {
+            flattenSequence(child, items);
+        }
+    }
+    else if (node.kind == RegexNode::Kind::Group)
+    {
+        flattenSequence(node.children.front(), items);
+    }
+    else
+    {
+        items.push_back(&node);
+    }
+}
+
+LinePrefix findLinePrefix(const RegexNode& root)
+{
+    LinePrefix prefix;
+    if (root.kind == RegexNode::Kind::LineStart)
+    {
+        prefix.anchored = true;
+        return prefix;
+    }
+    if (root.kind != RegexNode::Kind::Concat || root.children.front().kind != RegexNode::Kind::LineStart)
+    {
+        return prefix;
+    }
+    prefix.anchored = true;
+
+    // Take the single bytes (or both cases of a letter) up to the first
+    // node that is anything else
+    for (size_t i = 1; i < root.children.size(); ++i)
+    {
+        char byte = 0;
+        bool caseless = false;
+        if (!literalByte(root.children[i], byte, caseless))
+        {
+            break;
+        }
+        prefix.bytes += byte;
+        prefix.asciiCaseInsensitive = prefix.asciiCaseInsensitive || caseless;
+    }
+    if (prefix.asciiCaseInsensitive)
+    {
+        lowercaseAscii(prefix.bytes);
+    }
+    return prefix;
+}
+
+RequiredLiteral findRequiredLiteral(const RegexNode& root)
+{
+    std::vector<const RegexNode*> items;
+    flattenSequence(root, items);
+
+    // Find the longest run of literal bytes
+    size_t bestStart = 0;
+    size_t bestLength = 0;
+    for (size_t start = 0; start < items.size();)
+    {
+        size_t end = start;
+        char byte = 0;
+        bool caseless = false;
+        while (end < items.size() && literalByte(*items[end], byte, caseless))
+        {
+            ++end;
+        }
+        if (end - start > bestLength)
+        {
+            bestStart = start;
+            bestLength = end - start;
+        }
+        start = end + 1;
+    }
+
+    RequiredLiteral literal;
+    for (size_t i = bestStart; i < bestStart + bestLength; ++i)
+    {
+        char byte = 0;
+        bool caseless = false;
+        (void)literalByte(*items[i], byte, caseless);
+        literal.bytes += byte;
+        literal.asciiCaseInsensitive = literal.asciiCaseInsensitive || caseless;
+    }
+    if (literal.asciiCaseInsensitive)
+    {
+        lowercaseAscii(literal.bytes);
+    }
+
+    // Whatever comes before the literal in the sequence
+    for (size_t i = 0; i < bestStart; ++i)
+    {
+        size_t length = maxHitLength(*items[i]);
+        literal.maxLead = length == RegexNode::kUnbounded || literal.maxLead == RegexNode::kUnbounded
+                              ? RegexNode::kUnbounded
+                              : literal.maxLead + length;
+        collectBytes(*items[i], literal.leadBytes);
+    }
+    literal.leadBytes.reset('\n');
+    return literal;
+}
+
+} // namespace cgrep
@@ -0,0 +1,680 @@
+#include "RegexParser.h"
+
+#include <string>
+
+namespace cgrep
+{
+
+namespace
+{
+
+// Thrown inside the parser for patterns it does not handle
+struct Unsupported
+{
+};
+
+RegexNode bytesNode(const ByteSet& bytes)
+{
+    RegexNode node;
+    node.kind = RegexNode::Kind::Bytes;
+    node.bytes = bytes;
+    return node;
+}
+
+ByteSet rangeSet(unsigned char first, unsigned char last)
+{
+    ByteSet set;
+    for (unsigned c = first; c <= last; ++c)
+    {
+        set.set(c);
+    }
+    return set;
+}
+
+ByteSet digitSet()
+{
+    return rangeSet('0', '9');
+}
+
+ByteSet wordSet()
+{
+    return rangeSet('a', 'z') | rangeSet('A', 'Z') | rangeSet('0', '9') | rangeSet('_', '_');
+}
+
+ByteSet spaceSet()
+{
+    return rangeSet('\t', '\r') | rangeSet(' ', ' ');
+}
+
+// Add the other ASCII case of every letter in `set`
+ByteSet foldCases(ByteSet set)
+{
+    for (unsigned c = 'a'; c <= 'z'; ++c)
+    {
+        if (set.test(c) || set.test(c - 'a' + 'A'))
+        {
+            set.set(c);
+            set.set(c - 'a' + 'A');
+        }
+    }
+    return set;
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Bytes of the POSIX character class `name` (as in [[:alpha:]])
+bool namedClass(std::string_view name, ByteSet& set)
+{
+    if (name == "alpha")
+    {
+        set = rangeSet('a', 'z') | rangeSet('A', 'Z');
+    }
+    else if (name == "digit")
+    {
+        set = digitSet();
+    }
+    else if (name == "alnum")
+    {
+        set = rangeSet('a', 'z') | rangeSet('A', 'Z') | digitSet();
+    }
+    else if (name == "upper")
+    {
+        set = rangeSet('A', 'Z');
+    }
+    else if (name == "lower")
+    {
+        set = rangeSet('a', 'z');
+    }
+    else if (name == "space")
+    {
+        set = spaceSet();
+    }
+    else if (name == "blank")
+    {
+        set = rangeSet(' ', ' ') | rangeSet('\t', '\t');
+    }
+    else if (name == "punct")
+    {
+        set = rangeSet('!', '/') | rangeSet(':', '@') | rangeSet('[', '`') | rangeSet('{', '~');
+    }
+    else if (name == "print")
+    {
+        set = rangeSet(' ', '~');
+    }
+    else if (name == "graph")
+    {
+        set = rangeSet('!', '~');
+    }
+    else if (name == "cntrl")
+    {
+        set = rangeSet(0, 0x1F) | rangeSet(0x7F, 0x7F);
+    }
+    else if (name == "xdigit")
+    {
+        set = digitSet() | rangeSet('a', 'f') | rangeSet('A', 'F');
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+// Recursive descent over the grammar shared by the syntaxes:
+//   alternation := concat ('|' concat)*
+//   concat      := repeat*
+//   repeat      := atom quantifier*
+// BRE spells the operators | ( ) { } + ? with a backslash and takes them
+// literally without one.
+class Parser
+{
+public:
+    Parser(std::string_view pattern, bool ignoreCase, RegexSyntax syntax)
+        : m_pattern(pattern)
+        , m_ignoreCase(ignoreCase)
+        , m_syntax(syntax)
+    {
+    }
+
+    RegexNode parse()
+    {
+        RegexNode root = parseAlternation();
+        if (m_pos != m_pattern.size())
+        {
+            throw Unsupported{}; // unbalanced ')'
+        }
+        return root;
+    }
+
+private:
+    bool atEnd() const { return m_pos == m_pattern.size(); }
+    char peek() const { return m_pattern[m_pos]; }
+    bool posix() const { return m_syntax != RegexSyntax::ECMAScript; }
+    bool basic() const { return m_syntax == RegexSyntax::Basic; }
+
+    char next()
+    {
+        if (atEnd())
+        {
+            throw Unsupported{};
+        }
+        return m_pattern[m_pos++];
+    }
+
+    // Whether the operator `op` (one of | ( ) { } + ?) comes next, and its
+    // length in the pattern
+    size_t operatorAt(size_t pos, char op) const
+    {
+        if (basic())
+        {
+            return pos + 1 < m_pattern.size() && m_pattern[pos] == '\\' && m_pattern[pos + 1] == op ? 2 : 0;
+        }
+        return pos < m_pattern.size() && m_pattern[pos] == op ? 1 : 0;
+    }
+    bool atOperator(char op) const { return operatorAt(m_pos, op) > 0; }
+    void skipOperator(char op) { m_pos += operatorAt(m_pos, op); }
+
+    RegexNode parseAlternation()
+    {
+        RegexNode first = parseConcat();
+        if (!atOperator('|'))
+        {
+            return first;
+        }
+        RegexNode node;
+        node.kind = RegexNode::Kind::Alternate;
+        node.children.push_back(std::move(first));
+        while (atOperator('|'))
+        {
+            skipOperator('|');
+            node.children.push_back(parseConcat());
+        }
+        return node;
+    }
+
+    RegexNode parseConcat()
+    {
+        RegexNode node;
+        node.kind = RegexNode::Kind::Concat;
+        // At the start of an expression, POSIX takes '*' literally and BRE
+        // takes '^' as an anchor
+        bool atStart = true;
+        while (!atEnd() && !atOperator('|') && !atOperator(')'))
+        {
+            node.children.push_back(parseRepeat(atStart));
+            atStart = node.children.back().kind == RegexNode::Kind::LineStart;
+        }
+        if (node.children.empty())
+        {
+            return RegexNode{};
+        }
+        if (node.children.size() == 1)
+        {
+            return std::move(node.children.front());
+        }
+        return node;
+    }
+
+    static bool isAssertion(const RegexNode& node)
+    {
+        return node.kind != RegexNode::Kind::Empty && node.kind != RegexNode::Kind::Bytes &&
+               node.kind != RegexNode::Kind::Concat && node.kind != RegexNode::Kind::Alternate &&
+               node.kind != RegexNode::Kind::Repeat && node.kind != RegexNode::Kind::Group;
+    }
+
+    RegexNode parseRepeat(bool atStart)
+    {
+        RegexNode atom = parseAtom(atStart);
+        if (posix() && atom.kind == RegexNode::Kind::LineStart)
+        {
+            return atom; // a '*' after it is literal
+        }
+        while (!atEnd())
+        {
+            size_t min = 0;
+            size_t max = RegexNode::kUnbounded;
+            if (peek() == '*')
+            {
+                ++m_pos;
+            }
+            else if (atOperator('+'))
+            {
+                min = 1;
+                skipOperator('+');
+            }
+            else if (atOperator('?'))
+            {
+                max = 1;
+                skipOperator('?');
+            }
+            else if (atOperator('{'))
+            {
+                size_t start = m_pos;
+                if (!parseInterval(min, max))
+                {
+                    if (m_syntax != RegexSyntax::Extended)
+                    {
+                        throw Unsupported{};
+                    }
+                    m_pos = start; // GNU ERE takes an invalid interval literally
+                    break;
+                }
+            }
+            else
+            {
+                break;
+            }
+            if (m_syntax == RegexSyntax::ECMAScript && !atEnd() && peek() == '?')
+            {
+                throw Unsupported{}; // lazy quantifier
+            }
+            if (isAssertion(atom))
+            {
+                throw Unsupported{}; // quantified assertion
+            }
+
+            RegexNode repeat;
+            repeat.kind = RegexNode::Kind::Repeat;
+            repeat.min = min;
+            repeat.max = max;
+            repeat.children.push_back(std::move(atom));
+            atom = std::move(repeat);
+        }
+        return atom;
+    }
+
+    // Parse {n}, {n,}, {n,m} (and {,m} in the POSIX syntaxes) after the
+    // opening brace; false if it is not a valid interval
+    bool parseInterval(size_t& min, size_t& max)
+    {
+        skipOperator('{');
+        bool hasMin = !atEnd() && peek() >= '0' && peek() <= '9';
+        if (!hasMin && !(posix() && !atEnd() && peek() == ','))
+        {
+            return false;
+        }
+        min = hasMin ? parseNumber() : 0;
+        max = min;
+        if (!atEnd() && peek() == ',')
+        {
+            ++m_pos;
+            max = !atEnd() && peek() >= '0' && peek() <= '9' ? parseNumber() : RegexNode::kUnbounded;
+        }
+        if (!atOperator('}'))
+        {
+            return false;
+        }
+        skipOperator('}');
+        if (max < min)
+        {
+            throw Unsupported{};
+        }
+        return true;
+    }
+
+    size_t parseNumber()
+    {
+        size_t value = 0;
+        size_t digits = 0;
+        while (!atEnd() && peek() >= '0' && peek() <= '9' && digits < 6)
+        {
+            value = value * 10 + static_cast<size_t>(next() - '0');
+            ++digits;
+        }
+        if (digits == 0)
+        {
+            throw Unsupported{};
+        }
+        return value;
+    }
+
+    static RegexNode assertion(RegexNode::Kind kind)
+    {
+        RegexNode node;
+        node.kind = kind;
+        return node;
+    }
+
+    RegexNode parseGroup()
+    {
+        RegexNode group;
+        group.kind = RegexNode::Kind::Group;
+        if (m_syntax == RegexSyntax::ECMAScript && !atEnd() && peek() == '?')
+        {
+            ++m_pos;
+            if (next() != ':')
+            {
+                throw Unsupported{}; // lookahead
+            }
+        }
+        else
+        {
+            group.capture = ++m_captures;
+        }
+        group.children.push_back(parseAlternation());
+        if (!atOperator(')'))
+        {
+            throw Unsupported{};
+        }
+        skipOperator(')');
+        return group;
+    }
+
+    RegexNode parseAtom(bool atStart)
+    {
+        if (atOperator('('))
+        {
+            skipOperator('(');
+            return parseGroup();
+        }
+        if (basic() && peek() == '\\' && m_pos + 1 < m_pattern.size() &&
+            std::string_view("{}+?").find(m_pattern[m_pos + 1]) != std::string_view::npos)
+        {
+            throw Unsupported{}; // an operator with nothing to apply to
+        }
+
+        char c = next();
+        switch (c)
+        {
+            case '[':
+                return bytesNode(parseClass());
+            case '.':
+                return bytesNode(posix() ? ~rangeSet('\n', '\n') : ~(rangeSet('\n', '\n') | rangeSet('\r', '\r')));
+            case '^':
+                if (!basic() || atStart)
+                {
+                    return assertion(RegexNode::Kind::LineStart);
+                }
+                break;
+            case '$':
+                if (!basic() || atEnd() || atOperator(')') || atOperator('|'))
+                {
+                    return assertion(RegexNode::Kind::LineEnd);
+                }
+                break;
+            case '\\':
+                return posix() ? parsePosixEscape() : parseEscape();
+            case '*':
+                if (!posix() || !atStart)
+                {
+                    throw Unsupported{};
+                }
+                break;
+            case '+':
+            case '?':
+            case '{':
+                if (!posix() || (!basic() && c != '{' && !atStart))
+                {
+                    throw Unsupported{};
+                }
+                break;
+            case '}':
+            case ')':
+            case ']':
+                if (!posix())
+                {
+                    throw Unsupported{};
+                }
+                break;
+            default:
+                break;
+        }
+        return bytesNode(literal(static_cast<unsigned char>(c)));
+    }
+
+    ByteSet literal(unsigned char c) const
+    {
+        ByteSet set;
+        set.set(c);
+        return m_ignoreCase ? foldCases(set) : set;
+    }
+
+    RegexNode parseEscape()
+    {
+        char c = next();
+        if (c == 'b' || c == 'B')
+        {
+            return assertion(c == 'b' ? RegexNode::Kind::WordBoundary : RegexNode::Kind::NotWordBoundary);
+        }
+        ByteSet set;
+        if (escapeClass(c, set))
+        {
+            return bytesNode(set);
+        }
+        return bytesNode(literal(escapedByte(c)));
+    }
+
+    // GNU escapes: \w \W \s \S, the word assertions \b \B \< \>, and the
+    // buffer anchors \` \' (the line, for grep); a backslash before any
+    // other punctuation makes it literal
+    RegexNode parsePosixEscape()
+    {
+        char c = next();
+        switch (c)
+        {
+            case 'b': return assertion(RegexNode::Kind::WordBoundary);
+            case 'B': return assertion(RegexNode::Kind::NotWordBoundary);
+            case '<': return assertion(RegexNode::Kind::WordStart);
+            case '>': return assertion(RegexNode::Kind::WordEnd);
+            case '`': return assertion(RegexNode::Kind::LineStart);
+            case '\'': return assertion(RegexNode::Kind::LineEnd);
+            case 'w': return bytesNode(wordSet());
+            case 'W': return bytesNode(~wordSet());
+            case 's': return bytesNode(spaceSet());
+            case 'S': return bytesNode(~spaceSet());
+            default: break;
+        }
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+        {
+            throw Unsupported{}; // backreference, or a letter GNU grep warns about
+        }
+        return bytesNode(literal(static_cast<unsigned char>(c)));
+    }
+
+    // \d \w \s and their complements
+    static bool escapeClass(char c, ByteSet& set)
+    {
+        switch (c)
+        {
+            case 'd': set = digitSet(); return true;
+            case 'D': set = ~digitSet(); return true;
+            case 'w': set = wordSet(); return true;
+            case 'W': set = ~wordSet(); return true;
+            case 's': set = spaceSet(); return true;
+            case 'S': set = ~spaceSet(); return true;
+            default: return false;
+        }
+    }
+
+    // The byte of a character escape such as \n, \x41 or \.
+    unsigned char escapedByte(char c)
+    {
+        switch (c)
+        {
+            case 't': return '\t';
+            case 'n': return '\n';
+            case 'r': return '\r';
+            case 'f': return '\f';
+            case 'v': return '\v';
+            case '0': return '\0';
+            case 'x':
+            case 'u':
+            {
+                size_t digits = c == 'x' ? 2 : 4;
+                int value = 0;
+                for (size_t i = 0; i < digits; ++i)
+                {
+                    int digit = hexValue(next());
+                    if (digit < 0)
+                    {
+                        throw Unsupported{};
+                    }
+                    value = value * 16 + digit;
+                }
+                if (value > (c == 'x' ? 0xFF : 0x7F))
+                {
+                    throw Unsupported{};
+                }
+                return static_cast<unsigned char>(value);
+            }
+            default:
+                break;
+        }
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+        {
+            throw Unsupported{}; // backreference, \c, or an unknown escape
+        }
+        return static_cast<unsigned char>(c);
+    }
+
+    // One member of a class: a byte, or a set such as \d or [:alpha:]
+    // stored in `set`, returning false
+    bool classMember(unsigned char& byte, ByteSet& set)
+    {
+        char c = next();
+        if (c == '[' && !atEnd() && (peek() == ':' || peek() == '=' || peek() == '.'))
+        {
+            if (peek() != ':')
+            {
+                // A collating symbol or equivalence class of one byte, such
+                // as [.-.], is that byte; named ones are left to std::regex
+                char kind = peek();
+                if (m_pos + 3 >= m_pattern.size() || m_pattern[m_pos + 2] != kind || m_pattern[m_pos + 3] != ']')
+                {
+                    throw Unsupported{};
+                }
+                byte = static_cast<unsigned char>(m_pattern[m_pos + 1]);
+                m_pos += 4;
+                return true;
+            }
+            size_t end = m_pattern.find(":]", m_pos + 1);
+            if (end == std::string_view::npos || !namedClass(m_pattern.substr(m_pos + 1, end - m_pos - 1), set))
+            {
+                throw Unsupported{};
+            }
+            m_pos = end + 2;
+            return false;
+        }
+        if (c == '\\' && !posix())
+        {
+            char e = next();
+            if (escapeClass(e, set))
+            {
+                return false;
+            }
+            byte = e == 'b' ? '\b' : escapedByte(e);
+            return true;
+        }
+        byte = static_cast<unsigned char>(c);
+        return true;
+    }
+
+    ByteSet parseClass()
+    {
+        ByteSet set;
+        bool negated = !atEnd() && peek() == '^';
+        if (negated)
+        {
+            ++m_pos;
+        }
+        if (!atEnd() && peek() == ']')
+        {
+            if (!posix())
+            {
+                throw Unsupported{}; // [] and [^]
+            }
+            set.set(']'); // a leading ']' is literal in POSIX
+            ++m_pos;
+        }
+        while (true)
+        {
+            if (!atEnd() && peek() == ']')
+            {
+                ++m_pos;
+                break;
+            }
+            ByteSet member;
+            unsigned char first = 0;
+            if (!classMember(first, member))
+            {
+                set |= member;
+                continue;
+            }
+
+            unsigned char last = first;
+            if (m_pos + 1 < m_pattern.size() && peek() == '-' && m_pattern[m_pos + 1] != ']')
+            {
+                ++m_pos;
+                if (!classMember(last, member))
+                {
+                    throw Unsupported{}; // range to a class
+                }
+                if (last < first || last >= 0x80)
+                {
+                    throw Unsupported{};
+                }
+            }
+            set |= rangeSet(first, last);
+        }
+        if (m_ignoreCase)
+        {
+            set = foldCases(set);
+        }
+        if (negated)
+        {
+            set = ~set;
+        }
+        if (posix())
+        {
+            set.reset('\n');
+        }
+        return set;
+    }
+
+    std::string_view m_pattern;
+    size_t           m_pos = 0;
+    size_t           m_captures = 0;
+    bool             m_ignoreCase = false;
+    RegexSyntax      m_syntax = RegexSyntax::ECMAScript;
+};
+
+} // namespace
+
+std::optional<RegexNode> parseRegex(std::string_view pattern, bool ignoreCase, RegexSyntax syntax)
+{
+    try
+    {
+        return Parser(pattern, ignoreCase, syntax).parse();
+    }
+    catch (const Unsupported&)
+    {
+        return std::nullopt;
+    }
+}
+
+size_t countCaptures(const RegexNode& node)
+{
+    size_t count = node.kind == RegexNode::Kind::Group && node.capture > 0 ? 1 : 0;
+    for (const auto& child : node.children)
+    {
+        count += countCaptures(child);
+    }
+    return count;
+}
+
+} // namespace cgrep
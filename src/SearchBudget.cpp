@@ -0,0 +1,42 @@
+#include "SearchBudget.h"
+
+#include <algorithm>
+#include <string>
+
+namespace cgrep
+{
+
+StepBudget::StepBudget(size_t maxSteps, Clock::duration maxTime)
+    : m_maxSteps(maxSteps)
+    , m_timed(maxTime > Clock::duration::zero())
+{
+    if (m_timed)
+    {
+        m_deadline = Clock::now() + maxTime;
+    }
+    m_nextCheck = m_maxSteps > 0 ? std::min(m_maxSteps + 1, kClockInterval) : kClockInterval;
+}
+
+void StepBudget::checkTime() const
+{
+    if (m_timed && Clock::now() > m_deadline)
+    {
+        throw SearchBudgetExceeded("time budget exceeded");
+    }
+}
+
+void StepBudget::check()
+{
+    if (m_maxSteps > 0 && m_steps > m_maxSteps)
+    {
+        throw SearchBudgetExceeded("step budget of " + std::to_string(m_maxSteps) + " exceeded");
+    }
+    checkTime();
+    m_nextCheck = m_steps + kClockInterval;
+    if (m_maxSteps > 0)
+    {
+        m_nextCheck = std::min(m_nextCheck, m_maxSteps + 1);
+    }
+}
+
+} // namespace cgrep
@@ -0,0 +1,93 @@
+#include "SearchKernel.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cgrep
+{
+
+size_t countLines(std::string_view text)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+    size_t count = 0;
+
+#if defined(__SSE2__)
+    // Compare 16 bytes at a time and subtract the 0xFF lanes from per-byte
+    // counters, summing those with psadbw before any of them can overflow
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16)
+    {
+        __m128i counters = _mm_setzero_si128();
+        size_t blocks = std::min<size_t>(static_cast<size_t>(end - p) / 16, 255);
+        for (size_t i = 0; i < blocks; ++i, p += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(bytes, newline));
+        }
+        __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+#endif
+    count += static_cast<size_t>(std::count(p, end, '\n'));
+    return count + (!text.empty() && text.back() != '\n' ? 1 : 0);
+}
+
+FileInput::FileInput(const std::filesystem::path& path)
+    : m_fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+{
+    if (m_fd < 0)
+    {
+        m_error = std::error_code(errno, std::generic_category());
+        return;
+    }
+    struct stat status{};
+    if (::fstat(m_fd, &status) == 0 && S_ISREG(status.st_mode))
+    {
+        m_sizeHint = static_cast<size_t>(status.st_size);
+    }
+}
+
+FileInput::~FileInput()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+size_t FileInput::read(char* data, size_t size, bool& atEnd)
+{
+    size_t total = 0;
+    atEnd = false;
+    while (total < size)
+    {
+        ssize_t count = ::read(m_fd, data + total, size - total);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "read failed");
+        }
+        if (count == 0)
+        {
+            atEnd = true;
+            break;
+        }
+        total += static_cast<size_t>(count);
+    }
+    return total;
+}
+
+} // namespace cgrep
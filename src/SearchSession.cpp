@@ -0,0 +1,72 @@
+#include "SearchSession.h"
+
+#include <utility>
+
+namespace cgrep
+{
+
+SearchSession::SearchSession(const std::string& query, const SearchOptions& options)
+    : m_grep(options)
+    , m_query(m_grep.compile(query))
+{
+}
+
+SearchSession::SearchSession(CompiledQuery query, const SearchOptions& options)
+    : m_grep(options)
+    , m_query(std::move(query))
+{
+    m_grep.checkCompiledFor(m_query);
+}
+
+MatchList SearchSession::parallelSearch(const std::vector<std::filesystem::path>& all_files)
+{
+    return m_grep.searchFilesWith(all_files, m_query.matcher(), &m_buffers);
+}
+
+MatchList SearchSession::parallelSearch(const FileTable& all_files)
+{
+    return m_grep.searchFilesWith(all_files, m_query.matcher(), &m_buffers);
+}
+
+size_t SearchSession::parallelSearch(const std::vector<std::filesystem::path>& all_files,
+                                     const std::function<void(const Match&)>& sink)
+{
+    return m_grep.streamFilesWith(all_files, m_query.matcher(), &m_buffers, sink);
+}
+
+size_t SearchSession::parallelSearch(const FileTable& all_files, const std::function<void(const Match&)>& sink)
+{
+    return m_grep.streamFilesWith(all_files, m_query.matcher(), &m_buffers, sink);
+}
+
+MatchList SearchSession::searchInFile(const std::filesystem::path& filePath)
+{
+    return m_grep.searchFileWith(filePath, m_query.matcher(), singleFileBuffer());
+}
+
+size_t SearchSession::countInFile(const std::filesystem::path& filePath)
+{
+    return m_grep.countFileWith(filePath, m_query.matcher(), singleFileBuffer());
+}
+
+size_t SearchSession::scanFile(const std::filesystem::path& filePath, const std::function<bool(const Match&)>& sink)
+{
+    return m_grep.scanFileTo(filePath, m_query.matcher(), singleFileBuffer(), sink);
+}
+
+size_t SearchSession::scanBuffer(std::string_view data, const std::filesystem::path& name,
+                                 const std::function<bool(const Match&)>& sink)
+{
+    return m_grep.scanBufferTo(data, name, m_query.matcher(), singleFileBuffer(), sink);
+}
+
+ScanBuffer& SearchSession::singleFileBuffer()
+{
+    if (m_buffers.empty())
+    {
+        m_buffers.resize(1);
+    }
+    return m_buffers.front();
+}
+
+} // namespace cgrep
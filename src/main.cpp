@@ -6,27 +6,105 @@
 
 int main(int argc, char* argv[])
 {
-    if (argc < 3 || argc > 5)
+    if (argc < 3)
     {
-        std::cerr << "Usage: grep_exec <query> <directory> [--ignore-case] [--regex]\n";
+        std::cerr << "Usage: grep_exec <query> <directory> [--ignore-case] [--regex] [--count]"
+                     " [-E|--extended-regexp] [-G|--basic-regexp] [-P|--perl-regexp] [-F|--fixed-strings]"
+                     " [--only-matching] [--invert-match] [--word-regexp] [--line-regexp]"
+                     " [--max-line-length <bytes>] [--file-timeout <ms>] [--max-regex-steps <steps>]"
+                     " [--capture-group <n>] [--max-result-memory <MiB>]\n";
         return 1;
     }
 
     std::string           query       = argv[1];
     std::filesystem::path dirPath     = argv[2];
-    bool                  ignoreCase  = false;
-    bool                  useRegex    = false;
+    cgrep::SearchOptions  options;
+    bool                  countOnly   = false;
+    bool                  onlyMatching = false;
 
     for (int i = 3; i < argc; ++i)
     {
         std::string arg = argv[i];
         if (arg == "--ignore-case")
         {
-            ignoreCase = true;
+            options.ignoreCase = true;
         }
         else if (arg == "--regex")
         {
-            useRegex = true;
+            options.regexSearch = true;
+        }
+        else if (arg == "--count")
+        {
+            countOnly = true;
+        }
+        else if (arg == "-E" || arg == "--extended-regexp")
+        {
+            options.regexSearch = true;
+            options.syntax = cgrep::RegexSyntax::Extended;
+        }
+        else if (arg == "-G" || arg == "--basic-regexp")
+        {
+            options.regexSearch = true;
+            options.syntax = cgrep::RegexSyntax::Basic;
+        }
+        else if (arg == "-P" || arg == "--perl-regexp")
+        {
+            options.regexSearch = true;
+            options.syntax = cgrep::RegexSyntax::ECMAScript;
+        }
+        else if (arg == "-F" || arg == "--fixed-strings")
+        {
+            options.regexSearch = false;
+        }
+        else if ((arg == "--max-line-length" || arg == "--file-timeout" || arg == "--max-regex-steps" ||
+                  arg == "--capture-group" || arg == "--max-result-memory") && i + 1 < argc)
+        {
+            size_t value = 0;
+            try
+            {
+                value = std::stoul(argv[++i]);
+            }
+            catch (const std::exception&)
+            {
+                std::cerr << "Invalid value for " << arg << ": " << argv[i] << "\n";
+                return 1;
+            }
+            if (arg == "--max-line-length")
+            {
+                options.maxLineLength = value;
+            }
+            else if (arg == "--capture-group")
+            {
+                options.captureGroup = value;
+            }
+            else if (arg == "--max-result-memory")
+            {
+                options.resultMemoryBudget = value << 20;
+            }
+            else if (arg == "--file-timeout")
+            {
+                options.fileTimeBudget = std::chrono::milliseconds(value);
+            }
+            else
+            {
+                options.fileStepBudget = value;
+            }
+        }
+        else if (arg == "--word-regexp")
+        {
+            options.wordRegexp = true;
+        }
+        else if (arg == "--line-regexp")
+        {
+            options.lineRegexp = true;
+        }
+        else if (arg == "--invert-match")
+        {
+            options.invertMatch = true;
+        }
+        else if (arg == "--only-matching")
+        {
+            onlyMatching = true;
         }
         else
         {
@@ -37,16 +115,39 @@ int main(int argc, char* argv[])
 
     try
     {
-        auto all_files = cgrep::FileCollector::collectFiles(dirPath);
-        cgrep::CustomGrep custom_grep(ignoreCase, useRegex);
-        auto results = custom_grep.parallelSearch(all_files, query);
+        auto all_files = cgrep::FileCollector::collectFileTable(dirPath);
+        if (!all_files.empty())
+        {
+            std::cout << all_files.size() << " files found" << std::endl;
+        }
+        cgrep::CustomGrep custom_grep(options);
+        if (countOnly)
+        {
+            auto counts = custom_grep.parallelCount(all_files, query);
+            for (size_t i = 0; i < all_files.size(); ++i)
+            {
+                std::cout << all_files.path(i).string() << ":" << counts[i] << "\n";
+            }
+            return 0;
+        }
 
-        for (auto const& m : results)
+        if (onlyMatching)
         {
-            std::cout << m.path.string()
-                      << ":" << m.line_number
-                      << ":" << m.line << "\n";
+            custom_grep.parallelOnlyMatching(all_files, query, std::cout);
+            return 0;
         }
+
+        custom_grep.parallelSearch(all_files, query, [](const cgrep::Match& m)
+        {
+            std::cout << m.path
+                      << ":" << m.line_number
+                      << ":" << m.line;
+            if (m.truncated)
+            {
+                std::cout << " [truncated; first hit at byte " << m.hit_offset << "]";
+            }
+            std::cout << "\n";
+        });
     }
     catch (const std::filesystem::filesystem_error& e)
     {
@@ -0,0 +1,66 @@
+#include "BatchPrefilter.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+// Helper: the indices of the queries picked for `text`
+static std::vector<size_t> picked(const cgrep::BatchPrefilter& prefilter, std::string_view text)
+{
+    std::vector<bool> selected;
+    prefilter.select(text, selected);
+    std::vector<size_t> indices;
+    for (size_t query = 0; query < selected.size(); ++query)
+    {
+        if (selected[query])
+        {
+            indices.push_back(query);
+        }
+    }
+    return indices;
+}
+
+TEST(BatchPrefilter, PicksQueriesWhoseLiteralOccurs)
+{
+    cgrep::BatchPrefilter prefilter;
+    prefilter.addLiteral(0, "password");
+    prefilter.addLiteral(1, "secret");
+    prefilter.addAlways(2);
+    prefilter.addLiteral(3, "password"); // shares the literal of query 0
+    prefilter.addLiteral(4, "");         // matches everywhere
+    prefilter.build();
+    EXPECT_EQ(prefilter.queryCount(), 5u);
+
+    EXPECT_EQ(picked(prefilter, "nothing here"), (std::vector<size_t>{ 2, 4 }));
+    EXPECT_EQ(picked(prefilter, "the password is\nsecret"), (std::vector<size_t>{ 0, 1, 2, 3, 4 }));
+    EXPECT_EQ(picked(prefilter, "a secret"), (std::vector<size_t>{ 1, 2, 4 }));
+}
+
+TEST(BatchPrefilter, FindsLiteralsInsideLongerOnes)
+{
+    // At a position the matcher reports only the longest literal starting
+    // there; the shorter ones must be picked as well
+    cgrep::BatchPrefilter prefilter;
+    prefilter.addLiteral(0, "foobar");
+    prefilter.addLiteral(1, "foo");
+    prefilter.addLiteral(2, "oba");
+    prefilter.addLiteral(3, "bar");
+    prefilter.addLiteral(4, "foobaz");
+    prefilter.build();
+
+    EXPECT_EQ(picked(prefilter, "xfoobarx"), (std::vector<size_t>{ 0, 1, 2, 3 }));
+    EXPECT_EQ(picked(prefilter, "fooba"), (std::vector<size_t>{ 1, 2 }));
+}
+
+TEST(BatchPrefilter, CaselessLiterals)
+{
+    cgrep::BatchPrefilter prefilter;
+    prefilter.addLiteral(0, "Error", true);
+    prefilter.addLiteral(1, "Error");
+    prefilter.addLiteral(2, "ERR", true);
+    prefilter.build();
+
+    EXPECT_EQ(picked(prefilter, "an ERROR"), (std::vector<size_t>{ 0, 2 }));
+    EXPECT_EQ(picked(prefilter, "an Error"), (std::vector<size_t>{ 0, 1, 2 }));
+    EXPECT_TRUE(picked(prefilter, "fine").empty());
+}
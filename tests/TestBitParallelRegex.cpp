@@ -0,0 +1,173 @@
+#include "BitParallelRegex.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <regex>
+#include <string>
+
+// Helper: compile `pattern` through the parser
+static std::optional<cgrep::BitParallelRegex> compile(const std::string& pattern, bool ignoreCase = false)
+{
+    auto tree = cgrep::parseRegex(pattern, ignoreCase);
+    if (!tree)
+    {
+        return std::nullopt;
+    }
+    return cgrep::BitParallelRegex::compile(*tree);
+}
+
+// Helper: the leftmost-longest hit of an unanchored `regex` in `text`, by
+// trying every substring
+static size_t referenceFind(const std::regex& regex, const std::string& text, size_t& length)
+{
+    for (size_t start = 0; start <= text.size(); ++start)
+    {
+        for (size_t end = text.size() + 1; end-- > start;)
+        {
+            if (std::regex_match(text.begin() + static_cast<std::ptrdiff_t>(start),
+                                 text.begin() + static_cast<std::ptrdiff_t>(end), regex))
+            {
+                length = end - start;
+                return start;
+            }
+        }
+    }
+    return std::string::npos;
+}
+
+// Helper: a random pattern over the letters a to c
+static std::string randomPattern(std::mt19937& rng, int depth)
+{
+    static const char* atoms[] = { "a", "b", "c", ".", "[ab]", "[^a]", "ab" };
+    static const char* quantifiers[] = { "", "", "*", "+", "?", "{2}", "{1,3}", "{2,}" };
+    std::uniform_int_distribution<int> pick(0, 9);
+    std::string pattern;
+    int parts = 1 + pick(rng) % 3;
+    for (int i = 0; i < parts; ++i)
+    {
+        if (depth > 0 && pick(rng) < 3)
+        {
+            pattern += "(" + randomPattern(rng, depth - 1) + "|" + randomPattern(rng, depth - 1) + ")";
+        }
+        else
+        {
+            pattern += atoms[pick(rng) % 7];
+        }
+        pattern += quantifiers[pick(rng) % 8];
+    }
+    return pattern;
+}
+
+TEST(BitParallelRegex, SelectsShiftAndForSequences)
+{
+    auto sequence = compile("[A-Z]{3}-[0-9]{4}");
+    ASSERT_TRUE(sequence.has_value());
+    EXPECT_TRUE(sequence->isShiftAnd());
+    EXPECT_EQ(sequence->positions(), 8u);
+    EXPECT_EQ(sequence->maxLength(), 8u);
+
+    size_t length = 0;
+    EXPECT_EQ(sequence->find("ticket ABC-1234 opened", 0, length), 7u);
+    EXPECT_EQ(length, 8u);
+    EXPECT_EQ(sequence->find("ticket ABC-123 opened", 0, length), std::string::npos);
+
+    auto loop = compile("ab+c");
+    ASSERT_TRUE(loop.has_value());
+    EXPECT_FALSE(loop->isShiftAnd());
+    EXPECT_EQ(loop->maxLength(), cgrep::RegexNode::kUnbounded);
+}
+
+TEST(BitParallelRegex, RejectsLargeOrAssertingPatterns)
+{
+    EXPECT_TRUE(compile(std::string(64, 'x')).has_value());
+    EXPECT_FALSE(compile(std::string(65, 'x')).has_value());
+    EXPECT_FALSE(compile("(ab){40}").has_value());
+    EXPECT_FALSE(compile("\\bword").has_value());
+    EXPECT_FALSE(compile("a^b").has_value());
+    EXPECT_FALSE(compile("(^a|b)").has_value());
+}
+
+TEST(BitParallelRegex, LeftmostLongestHits)
+{
+    size_t length = 0;
+    auto alternation = compile("a|ab|abc");
+    EXPECT_EQ(alternation->find("xxabcd", 0, length), 2u);
+    EXPECT_EQ(length, 3u);
+
+    auto star = compile("b*");
+    EXPECT_EQ(star->find("abbb", 0, length), 0u);
+    EXPECT_EQ(length, 0u);
+    EXPECT_EQ(star->find("abbb", 1, length), 1u);
+    EXPECT_EQ(length, 3u);
+
+    // The earliest-ending hit is not the leftmost one
+    auto overlap = compile("aaaab|ab");
+    EXPECT_EQ(overlap->find("xaaaab", 0, length), 1u);
+    EXPECT_EQ(length, 5u);
+}
+
+TEST(BitParallelRegex, Anchors)
+{
+    size_t length = 0;
+    auto start = compile("^ab");
+    EXPECT_FALSE(start->hitsStayInLine());
+    EXPECT_EQ(start->find("abab", 0, length), 0u);
+    EXPECT_EQ(start->find("abab", 1, length), std::string::npos);
+    EXPECT_EQ(start->find("xab", 0, length), std::string::npos);
+
+    auto end = compile("b+$");
+    EXPECT_EQ(end->find("abbabb", 0, length), 4u);
+    EXPECT_EQ(length, 2u);
+    EXPECT_EQ(end->find("abbabb", 0, length, true), std::string::npos);
+
+    auto whole = compile("^a*$");
+    EXPECT_EQ(whole->find("", 0, length), 0u);
+    EXPECT_EQ(whole->find("aaa", 0, length), 0u);
+    EXPECT_EQ(length, 3u);
+    EXPECT_EQ(whole->find("aab", 0, length), std::string::npos);
+
+    EXPECT_TRUE(compile("[^a]+")->hitsStayInLine());
+}
+
+TEST(BitParallelRegex, IgnoreCase)
+{
+    size_t length = 0;
+    auto regex = compile("error [a-z]+", true);
+    EXPECT_EQ(regex->find("fatal ERROR Disk full", 0, length), 6u);
+    EXPECT_EQ(length, 10u);
+}
+
+TEST(BitParallelRegex, AgreesWithStdRegexOnRandomPatterns)
+{
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> letter(0, 3);
+    std::uniform_int_distribution<size_t> lineLength(0, 10);
+    for (int round = 0; round < 500; ++round)
+    {
+        std::string pattern = randomPattern(rng, 1);
+        auto regex = compile(pattern);
+        if (!regex)
+        {
+            continue; // over 64 positions
+        }
+        std::regex reference(pattern);
+        for (int line = 0; line < 20; ++line)
+        {
+            std::string text(lineLength(rng), 'a');
+            for (auto& c : text)
+            {
+                c = "abcd"[letter(rng)];
+            }
+            size_t length = 0;
+            size_t expectedLength = 0;
+            size_t hit = regex->find(text, 0, length);
+            size_t expected = referenceFind(reference, text, expectedLength);
+            ASSERT_EQ(hit, expected) << "pattern=" << pattern << " text=" << text;
+            ASSERT_EQ(hit != std::string::npos, std::regex_search(text, reference));
+            if (hit != std::string::npos)
+            {
+                ASSERT_EQ(length, expectedLength) << "pattern=" << pattern << " text=" << text;
+            }
+        }
+    }
+}
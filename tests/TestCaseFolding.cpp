@@ -0,0 +1,101 @@
+#include "CaseFolding.h"
+#include "FoldedLiteralMatcher.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+
+TEST(CaseFolding, FoldsCodePoints)
+{
+    EXPECT_EQ(cgrep::foldCodePoint(U'A'), U'a');
+    EXPECT_EQ(cgrep::foldCodePoint(U'z'), U'z');
+    EXPECT_EQ(cgrep::foldCodePoint(U'Ä'), U'ä');
+    EXPECT_EQ(cgrep::foldCodePoint(U'Σ'), U'σ');
+    EXPECT_EQ(cgrep::foldCodePoint(U'ς'), U'σ');   // final sigma
+    EXPECT_EQ(cgrep::foldCodePoint(U'Д'), U'д');
+    EXPECT_EQ(cgrep::foldCodePoint(U'Ā'), U'ā');   // every second code point in the block
+    EXPECT_EQ(cgrep::foldCodePoint(U'ā'), U'ā');
+    EXPECT_EQ(cgrep::foldCodePoint(U'K'), U'k'); // KELVIN SIGN
+    EXPECT_EQ(cgrep::foldCodePoint(U'ẞ'), U'ß'); // CAPITAL SHARP S (simple folding)
+    EXPECT_EQ(cgrep::foldCodePoint(U'ß'), U'ß');      // full folding to "ss" is not simple
+    EXPECT_EQ(cgrep::foldCodePoint(U'中'), U'中');
+}
+
+TEST(CaseFolding, DecodesUtf8AndInvalidBytes)
+{
+    std::string text = "a\xC3\xA4\xE2\x84\xAA\xF0\x9F\x98\x80\xFF\xC3";
+    std::u32string expected =
+    {
+        U'a', U'ä', U'K', U'\U0001F600',
+        cgrep::kInvalidByteBase + 0xFF, cgrep::kInvalidByteBase + 0xC3
+    };
+
+    std::u32string decoded;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t length = 0;
+        decoded += cgrep::decodeUtf8(text, pos, length);
+        pos += length;
+    }
+    EXPECT_EQ(decoded, expected);
+
+    // Re-encoding reproduces the original bytes, including malformed ones
+    std::string reencoded;
+    for (char32_t cp : decoded)
+    {
+        cgrep::appendUtf8(reencoded, cp);
+    }
+    EXPECT_EQ(reencoded, text);
+}
+
+TEST(CaseFolding, CaseVariants)
+{
+    auto variants = cgrep::caseVariants(U'k');
+    std::sort(variants.begin(), variants.end());
+    EXPECT_EQ(variants, (std::vector<char32_t>{ U'K', U'k', U'K' }));
+
+    auto sigma = cgrep::caseVariants(U'σ');
+    std::sort(sigma.begin(), sigma.end());
+    EXPECT_EQ(sigma, (std::vector<char32_t>{ U'Σ', U'ς', U'σ' }));
+}
+
+TEST(FoldedLiteralMatcher, AsciiFastPath)
+{
+    cgrep::FoldedLiteralMatcher matcher("NeEdLe");
+    EXPECT_TRUE(matcher.usesAsciiFastPath());
+
+    size_t length = 0;
+    EXPECT_EQ(matcher.find("a haystack with NEEDLE inside", 0, length), 16u);
+    EXPECT_EQ(length, 6u);
+    EXPECT_EQ(matcher.find("a haystack with NEEDL", 0, length), std::string::npos);
+}
+
+TEST(FoldedLiteralMatcher, UnicodeNeedles)
+{
+    cgrep::FoldedLiteralMatcher matcher("ÄPFEL");
+    EXPECT_FALSE(matcher.usesAsciiFastPath());
+
+    size_t length = 0;
+    std::string haystack = "grüne äpfel und Äpfel";
+    EXPECT_EQ(matcher.find(haystack, 0, length), haystack.find("äpfel"));
+    EXPECT_EQ(length, std::string("äpfel").size());
+    EXPECT_EQ(matcher.find(haystack, haystack.find("äpfel") + 1, length), haystack.find("Äpfel"));
+
+    cgrep::FoldedLiteralMatcher greek("ΟΔΟΣ");
+    EXPECT_NE(greek.find("η οδος και η οδός", 0, length), std::string::npos);
+    EXPECT_EQ(greek.find("οδός", 0, length), std::string::npos); // accents are not folded
+    EXPECT_NE(greek.find("ΟΔΟς", 0, length), std::string::npos);
+}
+
+TEST(FoldedLiteralMatcher, AsciiNeedleMatchesNonAsciiVariants)
+{
+    // 'k' also matches KELVIN SIGN, so this needle takes the Unicode path
+    cgrep::FoldedLiteralMatcher matcher("kelvin");
+    EXPECT_FALSE(matcher.usesAsciiFastPath());
+
+    size_t length = 0;
+    std::string haystack = "273 \xE2\x84\xAA" "ELVIN";
+    EXPECT_EQ(matcher.find(haystack, 0, length), 4u);
+    EXPECT_EQ(length, 8u);
+}
@@ -4,7 +4,11 @@
 #include <gtest/gtest.h>
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <set>
+#include <sstream>
+#include <stdexcept>
+#include <stop_token>
 #include <vector>
 #include <algorithm>
 
@@ -45,6 +49,12 @@ static void removeDirIfExists(const fs::path& dir)
     }
 }
 
+// Helper: the spans of a match, as a vector to compare
+static std::vector<cgrep::Span> spansOf(const cgrep::Match& match)
+{
+    return { match.spans.begin(), match.spans.end() };
+}
+
 
 TEST(SearchInFile, LinesContainingQuery_CaseSensitive)
 {
@@ -286,6 +296,39 @@ TEST(ParallelSearch, MultipleFiles_CaseSensitive)
     removeDirIfExists(base);
 }
 
+TEST(ParallelSearch, FileTable)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_parallel_table";
+    removeDirIfExists(base);
+    fs::create_directories(base / "dirA");
+    fs::create_directories(base / "dirB");
+
+    writeFile(base / "dirA" / "A1.txt", { "apple", "pear" });
+    writeFile(base / "dirB" / "B1.txt", { "pear", "apple pie" });
+
+    auto paths = cgrep::FileCollector::collectFiles(base);
+    auto table = cgrep::FileCollector::collectFileTable(base);
+    cgrep::CustomGrep grep(false, false);
+
+    auto fromPaths = grep.parallelSearch(paths, "apple");
+    auto fromTable = grep.parallelSearch(table, "apple");
+    ASSERT_EQ(fromTable.size(), fromPaths.size());
+    for (size_t i = 0; i < fromPaths.size(); ++i)
+    {
+        EXPECT_EQ(fromTable[i].path, fromPaths[i].path);
+        EXPECT_EQ(fromTable[i].line, fromPaths[i].line);
+    }
+    EXPECT_EQ(grep.parallelCount(table, "pear"), grep.parallelCount(paths, "pear"));
+
+    std::ostringstream tableHits;
+    std::ostringstream pathHits;
+    EXPECT_EQ(grep.parallelOnlyMatching(table, "pear", tableHits), 2u);
+    EXPECT_EQ(grep.parallelOnlyMatching(paths, "pear", pathHits), 2u);
+    EXPECT_EQ(tableHits.str(), pathHits.str());
+
+    removeDirIfExists(base);
+}
+
 TEST(ParallelSearch, MultipleFiles_CaseInsensitive)
 {
     auto base = fs::temp_directory_path() / "custom_grep_test_parallel_ci";
@@ -528,3 +571,758 @@ TEST(HandlesCarriageReturn, StripsCR)
     removeDirIfExists(base);
 }
 
+
+TEST(SearchInFile, Regex_LiteralAlternation)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_alternation";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<std::string> lines =
+    {
+        "ERROR disk full",
+        "info: all good",
+        "Warn: retrying",
+        "fatal.error in module",
+        "debug"
+    };
+    auto filePath = base / "alternation.txt";
+    writeFile(filePath, lines);
+
+    // Alternation of plain literals, one with an escaped metacharacter
+    cgrep::CustomGrep grep_cs(false, true);
+    auto matches = grep_cs.searchInFile(filePath, "ERROR|Warn|fatal\\.error");
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].line_number, 1u);
+    EXPECT_EQ(matches[1].line_number, 3u);
+    EXPECT_EQ(matches[2].line_number, 4u);
+
+    cgrep::CustomGrep grep_ci(true, true);
+    auto ciMatches = grep_ci.searchInFile(filePath, "error|INFO");
+    ASSERT_EQ(ciMatches.size(), 3u);
+    EXPECT_EQ(ciMatches[0].line_number, 1u);
+    EXPECT_EQ(ciMatches[1].line_number, 2u);
+    EXPECT_EQ(ciMatches[2].line_number, 4u);
+
+    // Alternatives that are not plain literals still go through the regex engine
+    auto regexMatches = grep_cs.searchInFile(filePath, "^debug|^info");
+    ASSERT_EQ(regexMatches.size(), 2u);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, CaseInsensitive_Unicode)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_unicode";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<std::string> lines =
+    {
+        "Fehler: DATEI NICHT GEFUNDEN",
+        "ошибка: ФАЙЛ НЕ НАЙДЕН",
+        "error: file not found",
+        "Datei gefunden"
+    };
+    auto filePath = base / "unicode.txt";
+    writeFile(filePath, lines);
+
+    cgrep::CustomGrep grep_ci(true, false);
+    auto german = grep_ci.searchInFile(filePath, "datei nicht");
+    ASSERT_EQ(german.size(), 1u);
+    EXPECT_EQ(german[0].line_number, 1u);
+
+    auto russian = grep_ci.searchInFile(filePath, "Файл не найден");
+    ASSERT_EQ(russian.size(), 1u);
+    EXPECT_EQ(russian[0].line_number, 2u);
+    EXPECT_EQ(russian[0].line, "ошибка: ФАЙЛ НЕ НАЙДЕН");
+
+    removeDirIfExists(base);
+}
+
+TEST(CountMatches, PerFileCounts)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_count";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    writeFile(base / "a.txt", { "apple", "Apple pie", "banana", "apple apple" });
+    writeFile(base / "b.txt", { "cherry" });
+
+    cgrep::CustomGrep grep_cs(false, false);
+    EXPECT_EQ(grep_cs.countInFile(base / "a.txt", "apple"), 2u);
+
+    cgrep::CustomGrep grep_ci(true, false);
+    std::vector<fs::path> files = { base / "a.txt", base / "b.txt" };
+    auto counts = grep_ci.parallelCount(files, "apple");
+    ASSERT_EQ(counts.size(), 2u);
+    EXPECT_EQ(counts[0], 3u);
+    EXPECT_EQ(counts[1], 0u);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, LongLinesWithBoundedBuffer)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_long_line";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    // A minified-JSON-like line far longer than the read buffer
+    std::string json = "{\"items\":[";
+    for (int i = 0; i < 5000; ++i)
+    {
+        json += "{\"id\":" + std::to_string(i) + ",\"ok\":true},";
+    }
+    size_t hit = json.size();
+    json += "{\"id\":-1,\"error\":\"timeout\"}]}";
+    auto filePath = base / "minified.json";
+    writeFile(filePath, { json, "error: short line" });
+
+    cgrep::SearchOptions options;
+    options.bufferSize = 4096;
+    options.maxLineLength = 80;
+    cgrep::CustomGrep grep(options);
+
+    auto matches = grep.searchInFile(filePath, "\"error\"");
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].line_number, 1u);
+    EXPECT_TRUE(matches[0].truncated);
+    EXPECT_EQ(matches[0].line, json.substr(0, 80));
+    EXPECT_EQ(matches[0].hit_offset, hit + 9);
+
+    options.regexSearch = true;
+    cgrep::CustomGrep regexGrep(options);
+    auto regexMatches = regexGrep.searchInFile(filePath, "\"id\":-[0-9]+");
+    ASSERT_EQ(regexMatches.size(), 1u);
+    EXPECT_EQ(regexMatches[0].hit_offset, hit + 1);
+    auto anchored = regexGrep.searchInFile(filePath, "^error");
+    ASSERT_EQ(anchored.size(), 1u);
+    EXPECT_EQ(anchored[0].line_number, 2u);
+    EXPECT_FALSE(anchored[0].truncated);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, ByteOffsetsAndSpans)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_spans";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    auto filePath = base / "spans.txt";
+    writeFile(filePath, { "no hit", "id=7 id=42", "x id=1" });
+
+    cgrep::CustomGrep grep(false, true);
+    auto matches = grep.searchInFile(filePath, "id=[0-9]+");
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].byte_offset, 7u);
+    EXPECT_EQ(spansOf(matches[0]), (std::vector<cgrep::Span>{ { 0, 4 }, { 5, 5 } }));
+    EXPECT_EQ(matches[1].byte_offset, 18u);
+    EXPECT_EQ(matches[1].hit_offset, 2u);
+    EXPECT_EQ(spansOf(matches[1]), (std::vector<cgrep::Span>{ { 2, 4 } }));
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, OnlyMatching)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_only_matching";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    writeFile(base / "a.txt", { "user=alice id=1", "nothing", "id=2 and id=3" });
+    writeFile(base / "b.txt", { "ID=4" });
+
+    std::vector<fs::path> files = { base / "a.txt", base / "b.txt" };
+    cgrep::CustomGrep grep(true, true);
+    std::ostringstream out;
+    EXPECT_EQ(grep.parallelOnlyMatching(files, "id=[0-9]", out), 4u);
+
+    std::string a = (base / "a.txt").string();
+    std::string b = (base / "b.txt").string();
+    EXPECT_EQ(out.str(), a + ":1:id=1\n" + a + ":3:id=2\n" + a + ":3:id=3\n" + b + ":1:ID=4\n");
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, OnlyMatchingCaptureGroup)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_capture_group";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    writeFile(base / "a.txt", { "user=alice id=1", "user= id=2", "user=bob user=carol" });
+
+    cgrep::SearchOptions options;
+    options.regexSearch = true;
+    options.captureGroup = 1;
+    std::vector<fs::path> files = { base / "a.txt" };
+    std::ostringstream out;
+    EXPECT_EQ(cgrep::CustomGrep(options).parallelOnlyMatching(files, "user=(\\w+)?", out), 3u);
+
+    std::string a = (base / "a.txt").string();
+    EXPECT_EQ(out.str(), a + ":1:alice\n" + a + ":3:bob\n" + a + ":3:carol\n");
+
+    // Spans of searchInFile are the group's too
+    auto matches = cgrep::CustomGrep(options).searchInFile(base / "a.txt", "id=([0-9])");
+    ASSERT_EQ(matches.size(), 2u);
+    ASSERT_EQ(matches[1].spans.size(), 1u);
+    EXPECT_EQ(matches[1].spans[0], (cgrep::Span{9, 1}));
+
+    options.captureGroup = 2;
+    EXPECT_THROW(cgrep::CustomGrep(options).searchInFile(base / "a.txt", "id=([0-9])"), std::invalid_argument);
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, StreamsWithinMemoryBudget)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_result_budget";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<fs::path> files;
+    for (int file = 0; file < 6; ++file)
+    {
+        std::vector<std::string> lines;
+        for (int line = 0; line < 2000; ++line)
+        {
+            lines.push_back("match " + std::to_string(file) + " " + std::to_string(line) + std::string(40, '.'));
+        }
+        files.push_back(base / ("f" + std::to_string(file) + ".txt"));
+        writeFile(files.back(), lines);
+    }
+
+    // A budget far below the size of the matches makes every worker spill
+    cgrep::SearchOptions options;
+    options.resultMemoryBudget = 4096;
+    cgrep::CustomGrep grep(options);
+    auto expected = grep.parallelSearch(files, "match");
+
+    size_t index = 0;
+    size_t count = grep.parallelSearch(files, "match", [&](const cgrep::Match& match)
+    {
+        ASSERT_LT(index, expected.size());
+        EXPECT_EQ(match.path, expected[index].path);
+        EXPECT_EQ(match.line_number, expected[index].line_number);
+        EXPECT_EQ(match.line, expected[index].line);
+        EXPECT_EQ(spansOf(match), spansOf(expected[index]));
+        ++index;
+    });
+    EXPECT_EQ(count, 12000u);
+    EXPECT_EQ(index, 12000u);
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, AsyncAgreesWithParallelSearch)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_async";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<fs::path> files;
+    for (int file = 0; file < 8; ++file)
+    {
+        files.push_back(base / ("f" + std::to_string(file) + ".txt"));
+        writeFile(files.back(), { "apple " + std::to_string(file), "pear", "apple pie" });
+    }
+
+    cgrep::CustomGrep grep(false, false);
+    auto expected = grep.parallelSearch(files, "apple");
+    auto search = grep.parallelSearchAsync(files, "apple");
+    auto result = search.get();
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(result[i].path, expected[i].path);
+        EXPECT_EQ(result[i].line_number, expected[i].line_number);
+    }
+
+    auto progress = search.progress();
+    EXPECT_EQ(progress.filesSearched, 8u);
+    EXPECT_EQ(progress.totalFiles, 8u);
+    EXPECT_EQ(progress.matches, 16u);
+    EXPECT_FALSE(search.valid());
+    EXPECT_FALSE(search.cancelRequested());
+
+    // The table form, and a query the search rejects, which get() rethrows
+    auto table = cgrep::FileCollector::collectFileTable(base);
+    EXPECT_EQ(grep.parallelSearchAsync(table, "pear").get().size(), 8u);
+    cgrep::CustomGrep regexGrep(false, true);
+    auto rejected = regexGrep.parallelSearchAsync(files, "(a+)+(?!x)$");
+    EXPECT_THROW(static_cast<void>(rejected.get()), std::invalid_argument);
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, AsyncCancellation)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_async_cancel";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<fs::path> files;
+    std::vector<std::string> lines(5000, "match this line");
+    for (int file = 0; file < 16; ++file)
+    {
+        files.push_back(base / ("f" + std::to_string(file) + ".txt"));
+        writeFile(files.back(), lines);
+    }
+
+    // A token stopped before the start keeps every file from being searched
+    cgrep::CustomGrep grep(false, false);
+    std::stop_source stopped;
+    stopped.request_stop();
+    auto never = grep.parallelSearchAsync(files, "match", stopped.get_token());
+    EXPECT_TRUE(never.cancelRequested());
+    EXPECT_TRUE(never.get().empty());
+    EXPECT_EQ(never.progress().filesSearched, 0u);
+
+    // Stopping through the caller's token, or cancel(), ends a running search
+    // with the matches found so far
+    cgrep::SearchOptions options;
+    options.bufferSize = 4096;
+    cgrep::CustomGrep slow(options);
+    std::stop_source source;
+    auto search = slow.parallelSearchAsync(files, "match", source.get_token());
+    source.request_stop();
+    EXPECT_TRUE(search.cancelRequested());
+    auto partial = search.get();
+    EXPECT_LE(partial.size(), 16u * 5000u);
+    EXPECT_LE(search.progress().filesSearched, 16u);
+
+    auto cancelled = slow.parallelSearchAsync(files, "match");
+    cancelled.cancel();
+    EXPECT_TRUE(cancelled.waitFor(std::chrono::seconds(10)));
+
+    // Dropping a running search cancels it and waits for its workers
+    {
+        auto dropped = slow.parallelSearchAsync(files, "match");
+    }
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, LazyYieldsEveryMatch)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_lazy";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<fs::path> files;
+    for (int file = 0; file < 8; ++file)
+    {
+        std::vector<std::string> lines;
+        for (int line = 0; line < 500; ++line)
+        {
+            lines.push_back((line % 3 == 0 ? "match " : "other ") + std::to_string(line));
+        }
+        files.push_back(base / ("f" + std::to_string(file) + ".txt"));
+        writeFile(files.back(), lines);
+    }
+
+    cgrep::CustomGrep grep(false, false);
+    std::multiset<std::string> expected;
+    for (const auto& match : grep.parallelSearch(files, "match"))
+    {
+        expected.insert(std::string(match.path) + ":" + std::to_string(match.line_number));
+    }
+
+    // A buffer much smaller than the result; the lines of a file stay in order
+    std::multiset<std::string> yielded;
+    std::map<std::string, size_t> lastLine;
+    for (const cgrep::Match& match : grep.parallelSearchLazy(files, "match", 16))
+    {
+        yielded.insert(std::string(match.path) + ":" + std::to_string(match.line_number));
+        size_t& last = lastLine[std::string(match.path)];
+        EXPECT_GT(match.line_number, last);
+        last = match.line_number;
+    }
+    EXPECT_EQ(yielded, expected);
+
+    size_t fromTable = 0;
+    for (const cgrep::Match& match : grep.parallelSearchLazy(cgrep::FileCollector::collectFileTable(base), "match"))
+    {
+        EXPECT_EQ(match.line.substr(0, 5), "match");
+        ++fromTable;
+    }
+    EXPECT_EQ(fromTable, expected.size());
+
+    // No files: nothing yielded, and nothing printed
+    testing::internal::CaptureStdout();
+    auto none = grep.parallelSearchLazy(std::vector<fs::path>{}, "match");
+    EXPECT_TRUE(none.begin() == none.end());
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+
+    // Queries are checked on begin()
+    cgrep::CustomGrep regexGrep(false, true);
+    auto rejected = regexGrep.parallelSearchLazy(files, "(a+)+(?!x)$");
+    EXPECT_THROW(rejected.begin(), std::invalid_argument);
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, LazyStopsWithTheConsumer)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_lazy_stop";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<fs::path> files;
+    std::vector<std::string> lines(20000, "match this line");
+    for (int file = 0; file < 16; ++file)
+    {
+        files.push_back(base / ("f" + std::to_string(file) + ".txt"));
+        writeFile(files.back(), lines);
+    }
+
+    // Leaving the loop destroys the generator, which stops the workers
+    // waiting on the full buffer and those still searching
+    cgrep::CustomGrep grep(false, false);
+    size_t taken = 0;
+    for (const cgrep::Match& match : grep.parallelSearchLazy(files, "match", 64))
+    {
+        EXPECT_EQ(match.line, "match this line");
+        if (++taken == 10)
+        {
+            break;
+        }
+    }
+    EXPECT_EQ(taken, 10u);
+
+    removeDirIfExists(base);
+}
+
+TEST(ParallelSearch, BatchAgreesWithSeparateSearches)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_batch";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    std::vector<fs::path> files;
+    writeFile(base / "a.txt", { "password=hunter2", "nothing", "API_KEY=abc123 password" });
+    // U+017F LONG S folds to 's'
+    writeFile(base / "b.txt", { "Secret handshake", "token: 42", "\xC5\xBF" "ECRET" });
+    writeFile(base / "c.txt", { "plain text only" });
+    files = { base / "a.txt", base / "b.txt", base / "c.txt", base / "missing.txt" };
+
+    std::vector<cgrep::BatchQuery> queries = {
+        { "password", false, false },
+        { "secret", false, true },
+        { "[A-Z_]+=[a-z0-9]+", true, false },
+        { "token: [0-9]+|key", true, true },
+        { "absent", false, false },
+        { "pass", false, false }, // a prefix of another literal
+    };
+
+    cgrep::CustomGrep grep(false, false);
+    auto batch = grep.searchBatch(files, queries);
+
+    // Every query finds what a search of its own finds
+    for (size_t query = 0; query < queries.size(); ++query)
+    {
+        cgrep::SearchOptions options;
+        options.regexSearch = queries[query].regexSearch;
+        options.ignoreCase = queries[query].ignoreCase;
+        std::vector<std::string> expected;
+        for (const auto& match : cgrep::CustomGrep(options).parallelSearch(files, queries[query].pattern))
+        {
+            expected.push_back(std::string(match.path) + ":" + std::to_string(match.line_number));
+        }
+        std::vector<std::string> found;
+        for (const auto& match : batch)
+        {
+            if (match.query_id == query)
+            {
+                found.push_back(std::string(match.path) + ":" + std::to_string(match.line_number));
+                EXPECT_FALSE(match.spans.empty());
+            }
+        }
+        EXPECT_EQ(found, expected) << queries[query].pattern;
+    }
+
+    // File order, then line, then query
+    ASSERT_EQ(batch.size(), 9u);
+    EXPECT_EQ(batch[0].line_number, 1u);
+    EXPECT_EQ(batch[0].query_id, 0u);
+    EXPECT_EQ(batch[1].query_id, 5u);
+    EXPECT_EQ(batch[2].line_number, 3u);
+    std::vector<size_t> lineThree;
+    for (size_t i = 2; i < 6; ++i)
+    {
+        lineThree.push_back(batch[i].query_id);
+    }
+    EXPECT_EQ(lineThree, (std::vector<size_t>{ 0, 2, 3, 5 }));
+    EXPECT_EQ(batch[6].path, (base / "b.txt").string());
+    EXPECT_EQ(batch[8].query_id, 1u);
+
+    auto table = cgrep::FileCollector::collectFileTable(base);
+    EXPECT_EQ(grep.searchBatch(table, queries).size(), batch.size());
+
+    cgrep::SearchOptions inverted;
+    inverted.invertMatch = true;
+    auto withoutHits = cgrep::CustomGrep(inverted).searchBatch(files, { { "absent", false, false } });
+    EXPECT_EQ(withoutHits.size(), 7u);
+
+    // A file larger than the buffer a worker keeps, read before small ones
+    std::vector<std::string> bigLines(20000, "filler line without a hit");
+    bigLines[19999] = "last password";
+    writeFile(base / "big.txt", bigLines);
+    cgrep::SearchOptions smallBuffer;
+    smallBuffer.bufferSize = 4096;
+    std::vector<fs::path> bigFirst = { base / "big.txt", base / "a.txt", base / "big.txt", base / "c.txt" };
+    auto mixed = cgrep::CustomGrep(smallBuffer).searchBatch(bigFirst, { { "password", false, false } });
+    EXPECT_EQ(mixed.size(), cgrep::CustomGrep(smallBuffer).parallelSearch(bigFirst, "password").size());
+    EXPECT_EQ(mixed.size(), 4u);
+
+    EXPECT_THROW(static_cast<void>(grep.searchBatch(files, { { "ok", false, false }, { "(a+)+(?!x)$", true, false } })),
+                 std::invalid_argument);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, InvertMatch)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_invert";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    auto filePath = base / "log.txt";
+    writeFileCRLF(filePath, { "GET /health", "POST /login failed", "GET /health", "DELETE /user" });
+
+    cgrep::SearchOptions options;
+    options.invertMatch = true;
+    cgrep::CustomGrep grep(options);
+    auto matches = grep.searchInFile(filePath, "/health");
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].line_number, 2u);
+    EXPECT_EQ(matches[0].line, "POST /login failed");
+    EXPECT_EQ(matches[0].byte_offset, 13u);
+    EXPECT_EQ(matches[1].line_number, 4u);
+    EXPECT_EQ(matches[1].line, "DELETE /user");
+    EXPECT_EQ(grep.countInFile(filePath, "/health"), 2u);
+
+    options.regexSearch = true;
+    cgrep::CustomGrep regexGrep(options);
+    auto regexMatches = regexGrep.searchInFile(filePath, "^(GET|POST) ");
+    ASSERT_EQ(regexMatches.size(), 1u);
+    EXPECT_EQ(regexMatches[0].line_number, 4u);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, InvertMatchWithCRLFHits)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_invert_crlf";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    // In the block scan the hits "a\r" and "x\r" take in the '\r' of the
+    // line ending; the lines themselves have no hit
+    auto filePath = base / "crlf.txt";
+    writeFileCRLF(filePath, { "ca", "xx", "", "bb" });
+
+    cgrep::SearchOptions options;
+    options.regexSearch = true;
+    options.invertMatch = true;
+    auto matches = cgrep::CustomGrep(options).searchInFile(filePath, "(a|b)[^a]");
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].line, "ca");
+    EXPECT_EQ(matches[1].line, "xx");
+    EXPECT_EQ(matches[2].line_number, 3u);
+
+    options.syntax = cgrep::RegexSyntax::Extended;
+    auto posix = cgrep::CustomGrep(options).searchInFile(filePath, "a.|b.");
+    ASSERT_EQ(posix.size(), 3u);
+    EXPECT_EQ(posix[0].line, "ca");
+    EXPECT_EQ(posix[2].line_number, 3u);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, InvertMatchWithEmptyHitEndingTheFile)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_invert_unterminated";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    // The only hit of -w x* is the empty one after the tab, at the very end
+    // of a last line without a newline
+    auto filePath = base / "unterminated.txt";
+    {
+        std::ofstream out(filePath, std::ios::binary);
+        out << "ab\na\t";
+    }
+
+    cgrep::SearchOptions options;
+    options.regexSearch = true;
+    options.syntax = cgrep::RegexSyntax::Extended;
+    options.wordRegexp = true;
+    auto matches = cgrep::CustomGrep(options).searchInFile(filePath, "x*");
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].line_number, 2u);
+
+    options.invertMatch = true;
+    auto inverted = cgrep::CustomGrep(options).searchInFile(filePath, "x*");
+    ASSERT_EQ(inverted.size(), 1u);
+    EXPECT_EQ(inverted[0].line, "ab");
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, WordAndLineRegexp)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_boundaries";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    auto filePath = base / "words.txt";
+    writeFile(filePath, { "error", "errors found", "an Error here", "error_code", "ERROR" });
+
+    cgrep::SearchOptions options;
+    options.wordRegexp = true;
+    auto words = cgrep::CustomGrep(options).searchInFile(filePath, "error");
+    ASSERT_EQ(words.size(), 1u);
+    EXPECT_EQ(words[0].line_number, 1u);
+
+    options.ignoreCase = true;
+    auto caseless = cgrep::CustomGrep(options).searchInFile(filePath, "error");
+    ASSERT_EQ(caseless.size(), 3u);
+    EXPECT_EQ(caseless[1].line_number, 3u);
+    EXPECT_EQ(spansOf(caseless[1]), (std::vector<cgrep::Span>{ { 3, 5 } }));
+
+    options.lineRegexp = true;
+    auto wholeLines = cgrep::CustomGrep(options).searchInFile(filePath, "error");
+    ASSERT_EQ(wholeLines.size(), 2u);
+    EXPECT_EQ(wholeLines[0].line_number, 1u);
+    EXPECT_EQ(wholeLines[1].line_number, 5u);
+
+    options.ignoreCase = false;
+    options.regexSearch = true;
+    auto regexLines = cgrep::CustomGrep(options).searchInFile(filePath, "error[s_].*");
+    ASSERT_EQ(regexLines.size(), 2u);
+    EXPECT_EQ(regexLines[0].line_number, 2u);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, WordAndLineRegexpWithAlternatives)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_boundary_alternatives";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    // The hit each engine prefers fails the boundary where another passes
+    auto filePath = base / "alternatives.txt";
+    writeFile(filePath, { "ab", "foobar baz", "foo b", "aa-ab" });
+
+    auto lineNumbers = [&](const cgrep::SearchOptions& options, const std::string& query)
+    {
+        std::vector<size_t> numbers;
+        for (const auto& match : cgrep::CustomGrep(options).searchInFile(filePath, query))
+        {
+            numbers.push_back(match.line_number);
+        }
+        return numbers;
+    };
+
+    cgrep::SearchOptions options;
+    options.regexSearch = true;
+    options.lineRegexp = true;
+    EXPECT_EQ(lineNumbers(options, "\\ba|ab"), (std::vector<size_t>{ 1 }));
+    EXPECT_EQ(lineNumbers(options, "a|ab"), (std::vector<size_t>{ 1 }));
+
+    options.lineRegexp = false;
+    options.wordRegexp = true;
+    EXPECT_EQ(lineNumbers(options, "\\bfoo|foobar"), (std::vector<size_t>{ 2, 3 }));
+    EXPECT_EQ(lineNumbers(options, "foobar b|foobar"), (std::vector<size_t>{ 2 }));
+    EXPECT_EQ(lineNumbers(options, "(.*)(a|b)"), (std::vector<size_t>{ 1, 3, 4 }));
+    // Lookahead is left to std::regex
+    EXPECT_EQ(lineNumbers(options, "foo(?=b)|foobar"), (std::vector<size_t>{ 2 }));
+
+    // Backreferences are left to std::regex, whose POSIX hits are the longest
+    options.syntax = cgrep::RegexSyntax::Basic;
+    EXPECT_EQ(lineNumbers(options, "\\(a\\)\\1*-*a*"), (std::vector<size_t>{ 4 }));
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, PosixRegexSyntaxes)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_posix_syntax";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    auto filePath = base / "calls.txt";
+    writeFile(filePath, { "f(x) + 1", "ff", "reformat", "format(x)", "a|b" });
+
+    cgrep::SearchOptions options;
+    options.regexSearch = true;
+    options.syntax = cgrep::RegexSyntax::Basic;
+    auto basic = cgrep::CustomGrep(options).searchInFile(filePath, "f(x) +");
+    ASSERT_EQ(basic.size(), 1u);
+    EXPECT_EQ(basic[0].line_number, 1u);
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "a|b").size(), 1u);
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "\\(f\\)\\{2\\}").size(), 1u);
+
+    // The GNU word anchors, and the same query in ERE spelling
+    auto words = cgrep::CustomGrep(options).searchInFile(filePath, "\\<form");
+    ASSERT_EQ(words.size(), 1u);
+    EXPECT_EQ(words[0].line_number, 4u);
+    options.syntax = cgrep::RegexSyntax::Extended;
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "^f{2}$|\\<form").size(), 2u);
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "^(f{2}|a\\|b)$").size(), 2u);
+
+    // Backreferences are left to std::regex, which only has them in the
+    // BRE and ECMAScript grammars
+    options.syntax = cgrep::RegexSyntax::Basic;
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "\\(f\\)\\1").size(), 1u);
+    options.syntax = cgrep::RegexSyntax::Extended;
+    auto repeated = cgrep::CustomGrep(options).searchInFile(filePath, "(f)\\1|(.)\\2\\(");
+    ASSERT_EQ(repeated.size(), 1u);
+    EXPECT_EQ(repeated[0].line_number, 2u);
+    options.ignoreCase = true;
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "(F)\\1").size(), 1u);
+    options.ignoreCase = false;
+    options.wordRegexp = true;
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "(f)\\1|r(e)").size(), 1u);
+    options.wordRegexp = false;
+
+    // Collating symbols
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "[[.|.]]").size(), 1u);
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "([[.(.]])x\\)").size(), 2u);
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(filePath, "(f)\\1|[[.|.]]").size(), 2u);
+
+    removeDirIfExists(base);
+}
+
+TEST(SearchInFile, RegexGuardAndBudget)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_budget";
+    removeDirIfExists(base);
+    fs::create_directories(base);
+
+    writeFile(base / "slow.txt", { "ac", std::string(40, 'a'), "ac" });
+    writeFile(base / "fast.txt", { "ac" });
+
+    // The lookaheads keep these patterns off the bit-parallel engine, which
+    // runs them in linear time, and on std::regex
+    cgrep::SearchOptions options;
+    options.regexSearch = true;
+    EXPECT_THROW(cgrep::CustomGrep(options).searchInFile(base / "fast.txt", "(a+)+(?!x)$"),
+                 std::invalid_argument);
+    EXPECT_EQ(cgrep::CustomGrep(options).searchInFile(base / "slow.txt", "(a+)+$").size(), 1u);
+
+    // The budget stops the slow file; the other file is still searched
+    options.fileStepBudget = 100000;
+    std::vector<fs::path> files = { base / "slow.txt", base / "fast.txt" };
+    auto matches = cgrep::CustomGrep(options).parallelSearch(files, "(a|aa)*c(?!x)");
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].path, base / "slow.txt");
+    EXPECT_EQ(matches[0].line_number, 1u);
+    EXPECT_EQ(matches[1].path, base / "fast.txt");
+
+    removeDirIfExists(base);
+}
@@ -0,0 +1,118 @@
+#include "CustomGrepC.h"
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Helper: records the matches handed to the callback, stopping after `limit`
+struct Collected
+{
+    std::vector<std::string> lines;
+    std::vector<size_t>      spanCounts;
+    size_t                   limit = SIZE_MAX;
+};
+
+static int collect(const cgrep_match* match, void* userData)
+{
+    auto& collected = *static_cast<Collected*>(userData);
+    collected.lines.push_back(std::string(match->path, match->path_length) + ":" +
+                              std::to_string(match->line_number) + ":" +
+                              std::string(match->line, match->line_length));
+    collected.spanCounts.push_back(match->span_count);
+    return collected.lines.size() >= collected.limit ? 1 : 0;
+}
+
+TEST(CApi, SearchesFilesBuffersAndDirectories)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_c_api";
+    fs::remove_all(base);
+    fs::create_directories(base);
+    {
+        std::ofstream(base / "a.txt") << "foo bar foo\nnothing\nfood\n";
+        std::ofstream(base / "b.txt") << "no match\nFOO\n";
+    }
+
+    cgrep_options options;
+    cgrep_options_init(&options);
+    cgrep_search* search = cgrep_search_new("foo", 3, &options);
+    ASSERT_NE(search, nullptr);
+
+    Collected file;
+    const std::string a = (base / "a.txt").string();
+    EXPECT_EQ(cgrep_search_file(search, a.c_str(), collect, &file), 2);
+    EXPECT_EQ(file.lines, (std::vector<std::string>{ a + ":1:foo bar foo", a + ":3:food" }));
+    EXPECT_EQ(file.spanCounts, (std::vector<size_t>{ 2, 1 }));
+
+    const std::string text = "x\nfoo\r\ny foo";
+    Collected buffer;
+    EXPECT_EQ(cgrep_search_buffer(search, text.data(), text.size(), "memory", collect, &buffer), 2);
+    EXPECT_EQ(buffer.lines, (std::vector<std::string>{ "memory:2:foo", "memory:3:y foo" }));
+
+    // The callback stops the search early
+    Collected first;
+    first.limit = 1;
+    EXPECT_EQ(cgrep_search_file(search, a.c_str(), collect, &first), 1);
+
+    const std::string b = (base / "b.txt").string();
+    const char* paths[] = { a.c_str(), b.c_str() };
+    Collected listed;
+    EXPECT_EQ(cgrep_search_paths(search, paths, 2, collect, &listed), 2);
+    Collected listedFirst;
+    listedFirst.limit = 1;
+    EXPECT_EQ(cgrep_search_paths(search, paths, 2, collect, &listedFirst), 1);
+    cgrep_search_free(search);
+
+    // Over the result memory the matches are spilled and come back in order
+    options.result_memory = 1;
+    search = cgrep_search_new("foo", 3, &options);
+    ASSERT_NE(search, nullptr);
+    Collected spilled;
+    EXPECT_EQ(cgrep_search_paths(search, paths, 2, collect, &spilled), 2);
+    EXPECT_EQ(spilled.lines, listed.lines);
+    EXPECT_EQ(spilled.spanCounts, (std::vector<size_t>{ 2, 1 }));
+    cgrep_search_free(search);
+    options.result_memory = 0;
+
+    options.ignore_case = 1;
+    search = cgrep_search_new("foo", 3, &options);
+    ASSERT_NE(search, nullptr);
+    // The library leaves the host's stdout alone
+    Collected tree;
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(cgrep_search_directory(search, base.c_str(), collect, &tree), 3);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    cgrep_search_free(search);
+
+    fs::remove_all(base);
+}
+
+TEST(CApi, ReportsErrors)
+{
+    cgrep_options options;
+    cgrep_options_init(&options);
+    options.regex = 1;
+    const std::string exponential = "(a+)+(?!x)$";
+    EXPECT_EQ(cgrep_search_new(exponential.data(), exponential.size(), &options), nullptr);
+    EXPECT_NE(std::string(cgrep_last_error()).find("backtrack"), std::string::npos);
+
+    options.syntax = 7;
+    EXPECT_EQ(cgrep_search_new("a", 1, &options), nullptr);
+
+    // Options not set up by cgrep_options_init(), or from a newer header
+    cgrep_options_init(&options);
+    options.struct_size = 0;
+    EXPECT_EQ(cgrep_search_new("a", 1, &options), nullptr);
+    EXPECT_NE(std::string(cgrep_last_error()).find("struct_size"), std::string::npos);
+    options.struct_size = sizeof(cgrep_options) + 8;
+    EXPECT_EQ(cgrep_search_new("a", 1, &options), nullptr);
+
+    cgrep_search* search = cgrep_search_new("a", 1, nullptr);
+    ASSERT_NE(search, nullptr);
+    EXPECT_EQ(cgrep_search_file(search, nullptr, collect, nullptr), -1);
+    EXPECT_EQ(cgrep_search_file(search, "x", nullptr, nullptr), -1);
+    cgrep_search_free(search);
+}
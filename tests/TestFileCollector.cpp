@@ -64,6 +64,38 @@ TEST(CollectFiles, NestedDirectories)
     removeDirIfExists(base);
 }
 
+TEST(CollectFiles, FileTableMatchesPathList)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_file_table";
+    removeDirIfExists(base);
+    fs::create_directories(base / "a" / "b" / "c");
+    fs::create_directories(base / "empty");
+
+    writeFile(base / "top.txt", { "x" });
+    writeFile(base / "a" / "one.txt", { "x" });
+    writeFile(base / "a" / "b" / "c" / "deep.txt", { "x" });
+
+    auto files = cgrep::FileCollector::collectFiles(base);
+    auto table = cgrep::FileCollector::collectFileTable(base);
+    ASSERT_EQ(table.size(), files.size());
+    EXPECT_EQ(table.directoryCount(), 5u);
+    fs::path scratch;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        EXPECT_EQ(table.path(i), files[i]);
+        table.pathInto(i, scratch);
+        EXPECT_EQ(scratch.native(), files[i].native());
+    }
+
+    // A single file is its own entry
+    auto single = cgrep::FileCollector::collectFileTable(base / "top.txt");
+    ASSERT_EQ(single.size(), 1u);
+    EXPECT_EQ(single.path(0), base / "top.txt");
+    EXPECT_TRUE(cgrep::FileCollector::collectFileTable(base / "missing").empty());
+
+    removeDirIfExists(base);
+}
+
 TEST(CollectFiles, SkipsPermissionDenied)
 {
     auto base = fs::temp_directory_path() / "custom_grep_perm_denied";
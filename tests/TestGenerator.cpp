@@ -0,0 +1,73 @@
+#include "Generator.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Helper: yield `count` numbers, counting the ones produced in `produced`
+static cgrep::Generator<int> numbers(int count, int& produced)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        ++produced;
+        co_yield i;
+    }
+}
+
+TEST(Generator, YieldsLazily)
+{
+    int produced = 0;
+    auto generator = numbers(5, produced);
+    EXPECT_EQ(produced, 0); // nothing runs before begin()
+
+    std::vector<int> seen;
+    for (int value : generator)
+    {
+        seen.push_back(value);
+        EXPECT_EQ(produced, value + 1);
+    }
+    EXPECT_EQ(seen, (std::vector<int>{ 0, 1, 2, 3, 4 }));
+}
+
+TEST(Generator, StopsWhenDestroyedEarly)
+{
+    struct Flag
+    {
+        bool& destroyed;
+        ~Flag() { destroyed = true; }
+    };
+
+    bool destroyed = false;
+    auto make = [](bool& flag) -> cgrep::Generator<std::string>
+    {
+        Flag guard{flag};
+        for (int i = 0;; ++i)
+        {
+            co_yield "item " + std::to_string(i);
+        }
+    };
+    {
+        auto generator = make(destroyed);
+        auto it = generator.begin();
+        EXPECT_EQ(*it, "item 0");
+        ++it;
+        EXPECT_EQ(it->size(), 6u);
+        EXPECT_FALSE(destroyed);
+    }
+    EXPECT_TRUE(destroyed);
+}
+
+TEST(Generator, RethrowsFromTheBody)
+{
+    auto failing = []() -> cgrep::Generator<int>
+    {
+        co_yield 1;
+        throw std::runtime_error("broken");
+    };
+    auto generator = failing();
+    auto it = generator.begin();
+    EXPECT_EQ(*it, 1);
+    EXPECT_THROW(++it, std::runtime_error);
+    EXPECT_TRUE(it == generator.end());
+}
@@ -0,0 +1,117 @@
+#include "LiteralMatcher.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+// Helper: reference result computed with std::string_view::find
+static size_t referenceFind(std::string_view haystack, std::string_view needle, size_t from = 0)
+{
+    return haystack.find(needle, from);
+}
+
+TEST(LiteralMatcher, SelectsAlgorithmByNeedleShape)
+{
+    EXPECT_EQ(cgrep::LiteralMatcher("x").algorithm(),
+              cgrep::LiteralMatcher::Algorithm::Direct);
+    EXPECT_EQ(cgrep::LiteralMatcher("abc").algorithm(),
+              cgrep::LiteralMatcher::Algorithm::RareBytes);
+    EXPECT_EQ(cgrep::LiteralMatcher("java.lang.NullPointerException").algorithm(),
+              cgrep::LiteralMatcher::Algorithm::RareBytes);
+    // Long needle made only of the most common bytes in text
+    EXPECT_EQ(cgrep::LiteralMatcher("a retention strainer").algorithm(),
+              cgrep::LiteralMatcher::Algorithm::Horspool);
+    EXPECT_EQ(cgrep::LiteralMatcher(std::string(40, 'a') + "b").algorithm(),
+              cgrep::LiteralMatcher::Algorithm::TwoWay);
+}
+
+TEST(LiteralMatcher, FindsLongNeedles)
+{
+    std::string uuid = "123e4567-e89b-12d3-a456-426614174000";
+    std::string haystack = "request id=" + uuid + " failed; retry " + uuid;
+
+    cgrep::LiteralMatcher matcher(uuid);
+    EXPECT_EQ(matcher.find(haystack), haystack.find(uuid));
+    EXPECT_EQ(matcher.find(haystack, 12), haystack.rfind(uuid));
+    EXPECT_EQ(matcher.find(haystack, haystack.size()), std::string::npos);
+    EXPECT_EQ(matcher.find("too short"), std::string::npos);
+}
+
+TEST(LiteralMatcher, AnchorsOnRareBytes)
+{
+    // The first bytes are a space and an 'e', which are everywhere in the text
+    std::string needle = " e{x}";
+    std::string haystack;
+    for (int i = 0; i < 100; ++i)
+    {
+        haystack += "see the example e{y} here ";
+    }
+    size_t expected = haystack.size() + 3;
+    haystack += "and e{x} at the end";
+
+    cgrep::LiteralMatcher matcher(needle);
+    EXPECT_EQ(matcher.algorithm(), cgrep::LiteralMatcher::Algorithm::RareBytes);
+    EXPECT_EQ(matcher.find(haystack), expected);
+    EXPECT_EQ(matcher.find(haystack, expected + 1), std::string::npos);
+}
+
+TEST(LiteralMatcher, PeriodicNeedles)
+{
+    std::string needle = "abababababababababab";
+    std::string haystack = "abababababababababaXabababababababababab";
+    cgrep::LiteralMatcher matcher(needle);
+    EXPECT_EQ(matcher.algorithm(), cgrep::LiteralMatcher::Algorithm::TwoWay);
+    EXPECT_EQ(matcher.find(haystack), referenceFind(haystack, needle));
+}
+
+TEST(LiteralMatcher, AgreesWithStringFindOnRandomInput)
+{
+    // Small alphabets produce many partial matches and exercise every shift path
+    std::mt19937 rng(12345);
+    for (size_t alphabet : { 2u, 3u, 8u, 26u })
+    {
+        std::uniform_int_distribution<int> letter(0, static_cast<int>(alphabet) - 1);
+        for (size_t needleLength : { 1u, 2u, 7u, 16u, 17u, 33u, 64u, 100u })
+        {
+            for (int round = 0; round < 20; ++round)
+            {
+                std::string haystack(2000, 'a');
+                for (auto& c : haystack)
+                {
+                    c = static_cast<char>('a' + letter(rng));
+                }
+                std::uniform_int_distribution<size_t> start(0, haystack.size() - needleLength);
+                std::string needle = haystack.substr(start(rng), needleLength);
+                if (round % 2 == 1)
+                {
+                    needle.back() = 'z'; // usually absent
+                }
+
+                cgrep::LiteralMatcher matcher(needle);
+                for (size_t from : { 0u, 1u, 500u, 1999u })
+                {
+                    ASSERT_EQ(matcher.find(haystack, from), referenceFind(haystack, needle, from))
+                        << "needle=" << needle << " from=" << from;
+                }
+            }
+        }
+    }
+}
+
+TEST(LiteralMatcher, AsciiCaseInsensitive)
+{
+    cgrep::LiteralMatcher matcher("Stack Trace:", true);
+    EXPECT_EQ(matcher.algorithm(), cgrep::LiteralMatcher::Algorithm::RareBytes);
+    EXPECT_EQ(matcher.needle(), "stack trace:");
+
+    std::string haystack = std::string(100, ' ') + "STACK trace: at main()";
+    EXPECT_EQ(matcher.find(haystack), 100u);
+    EXPECT_EQ(matcher.find(haystack, 101), std::string::npos);
+
+    // Non-letters must still match exactly
+    EXPECT_EQ(matcher.find("stack trace;"), std::string::npos);
+
+    cgrep::LiteralMatcher single("Q", true);
+    EXPECT_EQ(single.find("abcq"), 3u);
+    EXPECT_EQ(single.find(std::string(40, 'x') + "Q"), 40u);
+}
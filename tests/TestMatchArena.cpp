@@ -0,0 +1,71 @@
+#include "Match.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+TEST(MatchArena, CopiesIntoStableChunks)
+{
+    cgrep::MatchArena arena;
+    std::vector<std::string_view> views;
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        views.push_back(arena.copy("line " + std::to_string(i)));
+    }
+    std::string longLine(cgrep::MatchArena::kChunkSize, 'x');
+    std::string_view longView = arena.copy(longLine);
+
+    std::vector<cgrep::Span> spans = { { 1, 2 }, { 5, 3 } };
+    auto spanView = arena.copy(std::span<const cgrep::Span>(spans));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(spanView.data()) % alignof(cgrep::Span), 0u);
+
+    // Splicing moves chunks, not bytes
+    cgrep::MatchArena merged;
+    (void)merged.copy("head");
+    size_t capacity = arena.capacity();
+    merged.splice(std::move(arena));
+    EXPECT_EQ(arena.capacity(), 0u);
+    EXPECT_EQ(merged.capacity(), capacity + cgrep::MatchArena::kChunkSize);
+
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        ASSERT_EQ(views[i], "line " + std::to_string(i));
+    }
+    EXPECT_EQ(longView, longLine);
+    EXPECT_EQ(std::vector<cgrep::Span>(spanView.begin(), spanView.end()), spans);
+}
+
+TEST(MatchList, AppendKeepsViewsValid)
+{
+    std::vector<cgrep::MatchList> workers(3);
+    for (size_t worker = 0; worker < workers.size(); ++worker)
+    {
+        std::string_view path = workers[worker].storePath("dir/file" + std::to_string(worker) + ".txt");
+        for (size_t line = 1; line <= 100; ++line)
+        {
+            std::string text = "hit " + std::to_string(worker) + ":" + std::to_string(line);
+            cgrep::Span span{0, 3};
+            workers[worker].add(path, line, text, 0, false, line * 10, std::span<const cgrep::Span>(&span, 1));
+        }
+    }
+
+    cgrep::MatchList all;
+    all.reserve(300);
+    for (auto& list : workers)
+    {
+        all.append(std::move(list));
+    }
+    workers.clear();
+
+    ASSERT_EQ(all.size(), 300u);
+    EXPECT_EQ(all[0].path, "dir/file0.txt");
+    EXPECT_EQ(all[299].path, "dir/file2.txt");
+    EXPECT_EQ(all[150].line, "hit 1:51");
+    EXPECT_EQ(all[150].byte_offset, 510u);
+    ASSERT_EQ(all[150].spans.size(), 1u);
+    EXPECT_EQ(all[150].spans[0], (cgrep::Span{0, 3}));
+
+    // Views survive moving the list itself
+    cgrep::MatchList moved = std::move(all);
+    EXPECT_EQ(moved[299].line, "hit 2:100");
+}
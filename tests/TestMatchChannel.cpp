@@ -0,0 +1,74 @@
+#include "MatchChannel.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+// Helper: a list of `count` matches of file `path`
+static cgrep::MatchList batchOf(const std::string& path, size_t count)
+{
+    cgrep::MatchList list;
+    std::string_view stored = list.storePath(path);
+    for (size_t line = 1; line <= count; ++line)
+    {
+        list.add(stored, line, "line " + std::to_string(line), 0, false, 0, {});
+    }
+    return list;
+}
+
+TEST(MatchChannel, HandsOverBatchesInOrder)
+{
+    cgrep::MatchChannel channel(100);
+    std::stop_source source;
+    EXPECT_TRUE(channel.push(batchOf("a.txt", 3), source.get_token()));
+    EXPECT_TRUE(channel.push(batchOf("b.txt", 5), source.get_token()));
+
+    auto first = channel.pop();
+    ASSERT_TRUE(first.has_value());
+    ASSERT_EQ(first->size(), 3u);
+    EXPECT_EQ((*first)[2].path, "a.txt");
+    EXPECT_EQ((*first)[2].line, "line 3");
+    auto second = channel.pop();
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ((*second)[4].path, "b.txt");
+
+    // A batch over the capacity still goes into an empty channel
+    EXPECT_TRUE(channel.push(batchOf("c.txt", 150), source.get_token()));
+    channel.close();
+    auto third = channel.pop();
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(third->size(), 150u);
+    EXPECT_FALSE(channel.pop().has_value());
+}
+
+TEST(MatchChannel, FullChannelWaitsForTheConsumer)
+{
+    cgrep::MatchChannel channel(10);
+    std::stop_source source;
+    ASSERT_TRUE(channel.push(batchOf("a.txt", 8), source.get_token()));
+
+    std::thread producer([&]
+    {
+        // Waits until the first batch is taken
+        EXPECT_TRUE(channel.push(batchOf("b.txt", 8), source.get_token()));
+        channel.close();
+    });
+    auto first = channel.pop();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ((*first)[0].path, "a.txt");
+    auto second = channel.pop();
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ((*second)[0].path, "b.txt");
+    producer.join();
+    EXPECT_FALSE(channel.pop().has_value());
+
+    // A stop request releases a producer waiting on a full channel
+    cgrep::MatchChannel full(10);
+    ASSERT_TRUE(full.push(batchOf("a.txt", 8), source.get_token()));
+    std::thread blocked([&]
+    {
+        EXPECT_FALSE(full.push(batchOf("b.txt", 8), source.get_token()));
+    });
+    source.request_stop();
+    blocked.join();
+}
@@ -0,0 +1,40 @@
+#include "MatchSpill.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+TEST(MatchSpill, ReplaysInWriteOrder)
+{
+    cgrep::MatchSpill spill;
+    EXPECT_EQ(spill.replay([](const cgrep::Match&) { FAIL(); }), 0u);
+
+    cgrep::MatchList list;
+    std::string_view a = list.storePath("dir/a.txt");
+    std::vector<cgrep::Span> spans = { { 0, 3 }, { 8, 2 } };
+    list.add(a, 1, "foo bar fo", 0, false, 0, spans);
+    list.add(a, 7, "", 0, false, 40, {});
+    spill.write(list);
+    list.clear();
+
+    std::string_view b = list.storePath("dir/b.txt");
+    list.add(b, 2, "cut", 1, true, 12, {}, 5);
+    spill.write(list);
+    EXPECT_EQ(spill.size(), 3u);
+
+    std::vector<std::string> replayed;
+    size_t count = spill.replay([&](const cgrep::Match& match)
+    {
+        replayed.push_back(std::string(match.path) + ":" + std::to_string(match.line_number) + ":" +
+                           std::string(match.line) + ":" + std::to_string(match.byte_offset) + ":" +
+                           std::to_string(match.spans.size()) + (match.truncated ? ":cut" : "") +
+                           (match.query_id != 0 ? ":q" + std::to_string(match.query_id) : ""));
+        if (match.line_number == 1)
+        {
+            EXPECT_EQ(std::vector<cgrep::Span>(match.spans.begin(), match.spans.end()), spans);
+        }
+    });
+    EXPECT_EQ(count, 3u);
+    EXPECT_EQ(replayed, (std::vector<std::string>{ "dir/a.txt:1:foo bar fo:0:2", "dir/a.txt:7::40:0",
+                                                   "dir/b.txt:2:cut:12:0:cut:q5" }));
+}
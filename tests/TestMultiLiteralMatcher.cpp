@@ -0,0 +1,130 @@
+#include "MultiLiteralMatcher.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Helper: brute-force leftmost-longest search used as the reference result
+static bool referenceFind(std::string_view haystack, const std::vector<std::string>& patterns,
+                          size_t from, cgrep::MultiLiteralMatcher::Hit& hit)
+{
+    for (size_t pos = from; pos <= haystack.size(); ++pos)
+    {
+        bool found = false;
+        for (size_t i = 0; i < patterns.size(); ++i)
+        {
+            if (haystack.substr(pos).starts_with(patterns[i]) && (!found || patterns[i].size() > hit.length))
+            {
+                hit = cgrep::MultiLiteralMatcher::Hit{pos, patterns[i].size(), i};
+                found = true;
+            }
+        }
+        if (found)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST(MultiLiteralMatcher, SelectsAlgorithmBySetSize)
+{
+    std::vector<std::string> many;
+    for (int i = 0; i < 100; ++i)
+    {
+        many.push_back("pattern" + std::to_string(i));
+    }
+    EXPECT_EQ(cgrep::MultiLiteralMatcher(many).algorithm(),
+              cgrep::MultiLiteralMatcher::Algorithm::AhoCorasick);
+    EXPECT_EQ(cgrep::MultiLiteralMatcher({ "a", "" }).algorithm(),
+              cgrep::MultiLiteralMatcher::Algorithm::AhoCorasick);
+}
+
+TEST(MultiLiteralMatcher, LeftmostLongestHit)
+{
+    cgrep::MultiLiteralMatcher matcher({ "bar", "foo", "foobar", "baz" });
+    std::string text = "xx foobar baz";
+
+    cgrep::MultiLiteralMatcher::Hit hit;
+    ASSERT_TRUE(matcher.find(text, 0, hit));
+    EXPECT_EQ(hit.position, 3u);
+    EXPECT_EQ(hit.length, 6u);
+    EXPECT_EQ(hit.pattern, 2u);
+
+    ASSERT_TRUE(matcher.find(text, 4, hit));
+    EXPECT_EQ(hit.position, 6u);
+    EXPECT_EQ(hit.pattern, 0u);
+
+    EXPECT_FALSE(matcher.find("nothing to see", 0, hit));
+}
+
+TEST(MultiLiteralMatcher, EmptyPatternMatchesEverywhere)
+{
+    cgrep::MultiLiteralMatcher matcher({ "abc", "" });
+    cgrep::MultiLiteralMatcher::Hit hit;
+    ASSERT_TRUE(matcher.find("zzz", 1, hit));
+    EXPECT_EQ(hit.position, 1u);
+    EXPECT_EQ(hit.length, 0u);
+}
+
+TEST(MultiLiteralMatcher, AgreesWithBruteForceOnRandomInput)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter(0, 3);
+    for (size_t patternCount : { 2u, 5u, 16u, 64u, 65u, 200u })
+    {
+        for (int round = 0; round < 10; ++round)
+        {
+            std::string haystack(600, 'a');
+            for (auto& c : haystack)
+            {
+                c = static_cast<char>('a' + letter(rng));
+            }
+
+            std::uniform_int_distribution<size_t> length(1, 8);
+            std::vector<std::string> patterns;
+            for (size_t i = 0; i < patternCount; ++i)
+            {
+                std::string p(length(rng), 'a');
+                for (auto& c : p)
+                {
+                    c = static_cast<char>('a' + letter(rng));
+                }
+                patterns.push_back(p);
+            }
+
+            cgrep::MultiLiteralMatcher matcher(patterns);
+            for (size_t from : { 0u, 1u, 17u, 300u, 599u, 600u })
+            {
+                cgrep::MultiLiteralMatcher::Hit expected;
+                cgrep::MultiLiteralMatcher::Hit actual;
+                bool expectedFound = referenceFind(haystack, patterns, from, expected);
+                ASSERT_EQ(matcher.find(haystack, from, actual), expectedFound);
+                if (expectedFound)
+                {
+                    ASSERT_EQ(actual.position, expected.position) << "patterns=" << patternCount;
+                    ASSERT_EQ(actual.length, expected.length) << "patterns=" << patternCount;
+                    EXPECT_EQ(patterns[actual.pattern], patterns[expected.pattern]);
+                }
+            }
+        }
+    }
+}
+
+TEST(MultiLiteralMatcher, AsciiCaseInsensitive)
+{
+    std::vector<std::string> many;
+    for (int i = 0; i < 100; ++i)
+    {
+        many.push_back("Pattern" + std::to_string(i));
+    }
+    for (const auto& patterns : { std::vector<std::string>{ "Error", "WARN" }, many })
+    {
+        cgrep::MultiLiteralMatcher matcher(patterns, true);
+        cgrep::MultiLiteralMatcher::Hit hit;
+        ASSERT_TRUE(matcher.find("a warn and an ERROR, PATTERN42", 0, hit));
+        EXPECT_EQ(hit.position, patterns.size() == 2 ? 2u : 21u);
+        EXPECT_FALSE(matcher.find("w-a-r-n", 0, hit));
+    }
+}
@@ -0,0 +1,137 @@
+#include "PikeVM.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <regex>
+#include <string>
+
+// Helper: compile `pattern` through the parser
+static std::optional<cgrep::PikeVM> compile(const std::string& pattern, bool ignoreCase = false)
+{
+    auto tree = cgrep::parseRegex(pattern, ignoreCase);
+    if (!tree)
+    {
+        return std::nullopt;
+    }
+    return cgrep::PikeVM::compile(*tree);
+}
+
+// Helper: the span of group `k` of the last hit as (start, end)
+static std::pair<size_t, size_t> group(const cgrep::PikeVM::Scratch& scratch, size_t k)
+{
+    return { scratch.captures()[2 * k], scratch.captures()[2 * k + 1] };
+}
+
+// Helper: a random pattern over the letters a to c, with groups and assertions
+static std::string randomPattern(std::mt19937& rng, int depth)
+{
+    static const char* atoms[] = { "a", "b", "c", ".", "[ab]", "[^a]", "ab", "\\b", "\\B" };
+    static const char* quantifiers[] = { "", "", "*", "+", "?", "{2}", "{1,3}", "{2,}" };
+    std::uniform_int_distribution<int> pick(0, 17);
+    std::string pattern;
+    int parts = 1 + pick(rng) % 3;
+    for (int i = 0; i < parts; ++i)
+    {
+        if (depth > 0 && pick(rng) < 6)
+        {
+            pattern += "(" + randomPattern(rng, depth - 1) + "|" + randomPattern(rng, depth - 1) + ")";
+            pattern += quantifiers[pick(rng) % 8];
+            continue;
+        }
+        int atom = pick(rng) % 9;
+        pattern += atoms[atom];
+        if (atom < 7)
+        {
+            pattern += quantifiers[pick(rng) % 8];
+        }
+    }
+    return pattern;
+}
+
+TEST(PikeVM, ReportsCaptureGroups)
+{
+    auto vm = compile("(\\w+)=(\\d+)?;");
+    ASSERT_TRUE(vm.has_value());
+    EXPECT_EQ(vm->groups(), 2u);
+
+    cgrep::PikeVM::Scratch scratch;
+    ASSERT_TRUE(vm->search("set key=42; x=;", 0, scratch));
+    EXPECT_EQ(group(scratch, 0), std::make_pair(size_t{4}, size_t{11}));
+    EXPECT_EQ(group(scratch, 1), std::make_pair(size_t{4}, size_t{7}));
+    EXPECT_EQ(group(scratch, 2), std::make_pair(size_t{8}, size_t{10}));
+
+    // The same scratch serves the next search; group 2 does not take part
+    ASSERT_TRUE(vm->search("set key=42; x=;", 11, scratch));
+    EXPECT_EQ(group(scratch, 1), std::make_pair(size_t{12}, size_t{13}));
+    EXPECT_EQ(scratch.captures()[4], std::string::npos);
+}
+
+TEST(PikeVM, LeftmostFirstLikeStdRegex)
+{
+    cgrep::PikeVM::Scratch scratch;
+    auto alternation = compile("a|ab");
+    ASSERT_TRUE(alternation->search("xab", 0, scratch));
+    EXPECT_EQ(group(scratch, 0), std::make_pair(size_t{1}, size_t{2}));
+
+    auto greedy = compile("(a+)(a*)");
+    ASSERT_TRUE(greedy->search("aaa", 0, scratch));
+    EXPECT_EQ(group(scratch, 1), std::make_pair(size_t{0}, size_t{3}));
+    EXPECT_EQ(group(scratch, 2), std::make_pair(size_t{3}, size_t{3}));
+}
+
+TEST(PikeVM, AssertionsAndLineContinuation)
+{
+    cgrep::PikeVM::Scratch scratch;
+    auto word = compile("\\bid\\b");
+    EXPECT_TRUE(word->search("an id here", 0, scratch));
+    EXPECT_FALSE(word->search("valid idx", 0, scratch));
+    EXPECT_FALSE(word->search("the id", 0, scratch, true)); // the line may go on with "x"
+    EXPECT_TRUE(word->hitsStayInLine());
+
+    auto end = compile("(a|^b)c$");
+    EXPECT_FALSE(end->hitsStayInLine());
+    EXPECT_TRUE(end->search("bc", 0, scratch));
+    EXPECT_FALSE(end->search("xbc", 0, scratch));
+    EXPECT_FALSE(end->search("xac", 0, scratch, true));
+}
+
+TEST(PikeVM, LinearOnNestedQuantifiers)
+{
+    auto vm = compile("(a|aa)*c");
+    cgrep::PikeVM::Scratch scratch;
+    EXPECT_FALSE(vm->search(std::string(100000, 'a'), 0, scratch));
+    EXPECT_FALSE(compile("((a{100}){100}){100}").has_value());
+}
+
+TEST(PikeVM, AgreesWithStdRegexOnRandomPatterns)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter(0, 4);
+    std::uniform_int_distribution<size_t> lineLength(0, 10);
+    for (int round = 0; round < 500; ++round)
+    {
+        std::string pattern = randomPattern(rng, 1);
+        auto vm = compile(pattern);
+        ASSERT_TRUE(vm.has_value()) << pattern;
+        std::regex reference(pattern);
+        cgrep::PikeVM::Scratch scratch;
+        for (int line = 0; line < 20; ++line)
+        {
+            std::string text(lineLength(rng), 'a');
+            for (auto& c : text)
+            {
+                c = "abc d"[letter(rng)];
+            }
+            std::smatch expected;
+            bool found = std::regex_search(text, expected, reference);
+            ASSERT_EQ(vm->search(text, 0, scratch), found) << "pattern=" << pattern << " text=" << text;
+            if (found)
+            {
+                ASSERT_EQ(group(scratch, 0).first, static_cast<size_t>(expected.position(0)))
+                    << "pattern=" << pattern << " text=" << text;
+                ASSERT_EQ(group(scratch, 0).second - group(scratch, 0).first, static_cast<size_t>(expected.length(0)))
+                    << "pattern=" << pattern << " text=" << text;
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include "RegexAnalysis.h"
+#include "RegexParser.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+TEST(RegexAnalysis, FindsNestedQuantifiers)
+{
+    EXPECT_EQ(cgrep::findNestedQuantifier("(a+)+$"), 0u);
+    EXPECT_EQ(cgrep::findNestedQuantifier("x(a*)*"), 1u);
+    EXPECT_EQ(cgrep::findNestedQuantifier("^((\\w+\\s?)*)$"), 2u);
+    EXPECT_EQ(cgrep::findNestedQuantifier("(?:[a-z]{2,})+"), 0u);
+    EXPECT_EQ(cgrep::findNestedQuantifier("id=((x|y+)z){3,}"), 3u);
+}
+
+TEST(RegexAnalysis, AcceptsSingleLevelQuantifiers)
+{
+    constexpr size_t npos = std::string::npos;
+    EXPECT_EQ(cgrep::findNestedQuantifier("[A-Z]{3}-[0-9]{4}"), npos);
+    EXPECT_EQ(cgrep::findNestedQuantifier("(GET|POST)+ /api/.*"), npos);
+    EXPECT_EQ(cgrep::findNestedQuantifier("(a+){2}"), npos);   // bounded outer repeat
+    EXPECT_EQ(cgrep::findNestedQuantifier("(a+)?b*"), npos);
+    EXPECT_EQ(cgrep::findNestedQuantifier("\\(a+\\)+"), npos); // escaped parentheses
+    EXPECT_EQ(cgrep::findNestedQuantifier("[(]a+[)]+"), npos); // parentheses in classes
+    EXPECT_EQ(cgrep::findNestedQuantifier("[]a+]+"), npos);
+}
+
+TEST(RegexAnalysis, SpellsExtendedRegexInECMAScript)
+{
+    EXPECT_EQ(cgrep::extendedToECMAScript("(ab)\\1"), "(ab)\\1");
+    EXPECT_EQ(cgrep::extendedToECMAScript("a.b"), "a[^\\n]b");
+    EXPECT_EQ(cgrep::extendedToECMAScript("[]a\\[.-.]]"), "[\\]a\\\\\\-]");
+    EXPECT_EQ(cgrep::extendedToECMAScript("[[:digit:]]{,2}"), "[[:digit:]]{0,2}");
+    EXPECT_EQ(cgrep::extendedToECMAScript("*a{x}"), "\\*a\\{x\\}");
+    EXPECT_EQ(cgrep::extendedToECMAScript("(a)+?b+{2}"), "(a)*(?:b+){2}"); // not lazy
+    EXPECT_EQ(cgrep::extendedToECMAScript("\\<?"), "(?:\\b(?=\\w))?");
+    EXPECT_EQ(cgrep::extendedToECMAScript("\\<w\\>/"), "\\b(?=\\w)w\\b(?!\\w)\\/");
+}
+
+TEST(RegexAnalysis, FindsLinePrefixes)
+{
+    auto prefixOf = [](const std::string& pattern, bool ignoreCase = false)
+    {
+        return cgrep::findLinePrefix(*cgrep::parseRegex(pattern, ignoreCase));
+    };
+
+    auto prefix = prefixOf("^2026-10-16 ERROR \\w+");
+    EXPECT_TRUE(prefix.anchored);
+    EXPECT_EQ(prefix.bytes, "2026-10-16 ERROR ");
+    EXPECT_FALSE(prefix.asciiCaseInsensitive);
+    EXPECT_TRUE(prefix.admits("2026-10-16 ERROR disk", 0));
+    EXPECT_FALSE(prefix.admits("2026-10-16 ERROR disk", 1));
+    EXPECT_FALSE(prefix.admits("2026-10-16 WARN disk", 0));
+    EXPECT_FALSE(prefix.admits("2026-10-16", 0));
+
+    EXPECT_EQ(prefixOf("^ab*c").bytes, "a");
+    EXPECT_EQ(prefixOf("^(ab)c").bytes, "");
+    EXPECT_TRUE(prefixOf("^").anchored);
+    EXPECT_FALSE(prefixOf("ab").anchored);
+    EXPECT_FALSE(prefixOf("^a|b").anchored);
+
+    auto caseless = prefixOf("^Error: [0-9]", true);
+    EXPECT_EQ(caseless.bytes, "error: ");
+    EXPECT_TRUE(caseless.asciiCaseInsensitive);
+    EXPECT_TRUE(caseless.admits("ERROR: 5", 0));
+    EXPECT_FALSE(caseless.admits("ERROR; 5", 0));
+}
+
+TEST(RegexAnalysis, FindsRequiredLiterals)
+{
+    auto literalOf = [](const std::string& pattern, bool ignoreCase = false)
+    {
+        return cgrep::findRequiredLiteral(*cgrep::parseRegex(pattern, ignoreCase));
+    };
+
+    auto email = literalOf("\\w+@example\\.com");
+    EXPECT_EQ(email.bytes, "@example.com");
+    EXPECT_EQ(email.maxLead, cgrep::RegexNode::kUnbounded);
+    EXPECT_TRUE(email.leadBytes.test('_'));
+    EXPECT_FALSE(email.leadBytes.test('@'));
+
+    auto bounded = literalOf("[0-9]{2}(:ERROR) (x|yz)+");
+    EXPECT_EQ(bounded.bytes, ":ERROR ");
+    EXPECT_EQ(bounded.maxLead, 2u);
+
+    auto caseless = literalOf("id=[0-9]+ User", true);
+    EXPECT_EQ(caseless.bytes, " user");
+    EXPECT_TRUE(caseless.asciiCaseInsensitive);
+    EXPECT_EQ(caseless.maxLead, cgrep::RegexNode::kUnbounded);
+
+    EXPECT_TRUE(literalOf("foo|bar").bytes.empty());
+    EXPECT_TRUE(literalOf("[ab]+").bytes.empty());
+}
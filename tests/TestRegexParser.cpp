@@ -0,0 +1,120 @@
+#include "RegexParser.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+using Kind = cgrep::RegexNode::Kind;
+
+TEST(RegexParser, BuildsTree)
+{
+    auto tree = cgrep::parseRegex("^(ab|c)+x{2,3}$");
+    ASSERT_TRUE(tree.has_value());
+    ASSERT_EQ(tree->kind, Kind::Concat);
+    ASSERT_EQ(tree->children.size(), 4u);
+    EXPECT_EQ(tree->children[0].kind, Kind::LineStart);
+    EXPECT_EQ(tree->children[3].kind, Kind::LineEnd);
+
+    const auto& plus = tree->children[1];
+    EXPECT_EQ(plus.kind, Kind::Repeat);
+    EXPECT_EQ(plus.min, 1u);
+    EXPECT_EQ(plus.max, cgrep::RegexNode::kUnbounded);
+    ASSERT_EQ(plus.children[0].kind, Kind::Group);
+    EXPECT_EQ(plus.children[0].capture, 1u);
+    EXPECT_EQ(plus.children[0].children[0].kind, Kind::Alternate);
+
+    const auto& counted = tree->children[2];
+    EXPECT_EQ(counted.min, 2u);
+    EXPECT_EQ(counted.max, 3u);
+    EXPECT_TRUE(counted.children[0].bytes.test('x'));
+    EXPECT_EQ(counted.children[0].bytes.count(), 1u);
+
+    EXPECT_EQ(cgrep::countCaptures(*cgrep::parseRegex("(a)(?:b)((c)d)")), 3u);
+}
+
+TEST(RegexParser, ByteSets)
+{
+    auto bytesOf = [](const std::string& pattern, bool ignoreCase = false)
+    {
+        auto tree = cgrep::parseRegex(pattern, ignoreCase);
+        EXPECT_TRUE(tree.has_value()) << pattern;
+        EXPECT_EQ(tree->kind, Kind::Bytes) << pattern;
+        return tree->bytes;
+    };
+
+    EXPECT_EQ(bytesOf("[a-c_]").count(), 4u);
+    EXPECT_EQ(bytesOf("[^a]").count(), 255u);
+    EXPECT_FALSE(bytesOf(".").test('\n'));
+    EXPECT_FALSE(bytesOf(".").test('\r'));
+    EXPECT_EQ(bytesOf("\\d").count(), 10u);
+    EXPECT_EQ(bytesOf("\\w").count(), 63u);
+    EXPECT_TRUE(bytesOf("\\s").test('\v'));
+    EXPECT_EQ(bytesOf("[\\d-]").count(), 11u);
+    EXPECT_TRUE(bytesOf("[\\b]").test('\b'));
+    EXPECT_TRUE(bytesOf("\\x41").test('A'));
+    EXPECT_TRUE(bytesOf("\\.").test('.'));
+    EXPECT_TRUE(bytesOf("[a-c]", true).test('B'));
+    EXPECT_TRUE(bytesOf("q", true).test('Q'));
+    EXPECT_FALSE(bytesOf("1", true).test('!'));
+}
+
+TEST(RegexParser, RejectsUnsupportedAndInvalidPatterns)
+{
+    for (const char* pattern : { "(a)\\1", "a(?=b)", "a*?", "\\u00e9", "\\q", "(a", "a)", "[a", "*a", "a{2,1}",
+                                 "[z-a]", "^*", "[]a]" })
+    {
+        EXPECT_FALSE(cgrep::parseRegex(pattern).has_value()) << pattern;
+    }
+}
+
+TEST(RegexParser, PosixSyntaxes)
+{
+    using cgrep::RegexSyntax;
+    auto parses = [](const std::string& pattern, RegexSyntax syntax)
+    { return cgrep::parseRegex(pattern, false, syntax).has_value(); };
+
+    // BRE spells the operators with a backslash and takes them literally without one
+    auto basic = cgrep::parseRegex("\\(ab\\)\\{2\\}a+b?|c", false, RegexSyntax::Basic);
+    ASSERT_TRUE(basic.has_value());
+    ASSERT_EQ(basic->kind, Kind::Concat);
+    ASSERT_EQ(basic->children.size(), 7u);
+    EXPECT_EQ(basic->children[0].kind, Kind::Repeat);
+    EXPECT_TRUE(basic->children[2].bytes.test('+'));
+    EXPECT_TRUE(basic->children[5].bytes.test('|'));
+    EXPECT_EQ(cgrep::parseRegex("a\\|b\\+", false, RegexSyntax::Basic)->kind, Kind::Alternate);
+
+    // ^ and $ anchor only at the ends of a BRE (or of a group or alternative)
+    auto anchors = cgrep::parseRegex("^*a^$b$", false, RegexSyntax::Basic);
+    ASSERT_TRUE(anchors.has_value());
+    ASSERT_EQ(anchors->children.size(), 7u);
+    EXPECT_EQ(anchors->children[0].kind, Kind::LineStart);
+    EXPECT_TRUE(anchors->children[1].bytes.test('*'));
+    EXPECT_TRUE(anchors->children[3].bytes.test('^'));
+    EXPECT_TRUE(anchors->children[4].bytes.test('$'));
+    EXPECT_EQ(anchors->children[6].kind, Kind::LineEnd);
+
+    // ERE: an interval that is not one is literal, and so is a leading '*'
+    EXPECT_EQ(cgrep::parseRegex("a{,2}", false, RegexSyntax::Extended)->max, 2u);
+    EXPECT_EQ(cgrep::parseRegex("a{x", false, RegexSyntax::Extended)->children.size(), 3u);
+    EXPECT_TRUE(parses("*a", RegexSyntax::Extended));
+    EXPECT_TRUE(parses("a+?", RegexSyntax::Extended)); // (a+)? rather than lazy
+
+    // GNU escapes, brackets and '.'
+    EXPECT_EQ(cgrep::parseRegex("\\<", false, RegexSyntax::Extended)->kind, Kind::WordStart);
+    EXPECT_EQ(cgrep::parseRegex("\\>", false, RegexSyntax::Basic)->kind, Kind::WordEnd);
+    EXPECT_EQ(cgrep::parseRegex("[]a\\]", false, RegexSyntax::Extended)->bytes.count(), 3u);
+    EXPECT_EQ(cgrep::parseRegex("[[:digit:]x]", false, RegexSyntax::Extended)->bytes.count(), 11u);
+    EXPECT_EQ(cgrep::parseRegex("[^a]", false, RegexSyntax::Extended)->bytes.count(), 254u);
+    EXPECT_TRUE(cgrep::parseRegex(".", false, RegexSyntax::Basic)->bytes.test('\r'));
+
+    // One-byte collating symbols and equivalence classes are that byte
+    auto collating = cgrep::parseRegex("[[.-.][=a=]]", false, RegexSyntax::Extended);
+    ASSERT_TRUE(collating.has_value());
+    EXPECT_EQ(collating->bytes.count(), 2u);
+    EXPECT_TRUE(collating->bytes.test('-'));
+    EXPECT_TRUE(collating->bytes.test('a'));
+
+    for (const char* pattern : { "\\(a\\)\\1", "[[=ab=]]", "[[.hyphen.]]", "[[:nope:]]", "\\d", "a\\{1" })
+    {
+        EXPECT_FALSE(parses(pattern, RegexSyntax::Basic)) << pattern;
+    }
+}
@@ -0,0 +1,594 @@
+#include "RegexParser.h"
+#include "SearchKernel.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+// Helper: line policy that records line numbers, contents and spans. The
+// views in `details` are only valid during the scan.
+struct CollectLines
+{
+    static constexpr bool kCollectSpans = true;
+
+    std::vector<std::pair<size_t, std::string>> lines;
+    std::vector<cgrep::MatchedLine> details;
+    std::vector<std::vector<cgrep::Span>> spans;
+
+    void onMatch(const cgrep::MatchedLine& line)
+    {
+        lines.emplace_back(line.lineNumber, std::string(line.text));
+        details.push_back(line);
+        spans.emplace_back(line.spans.begin(), line.spans.end());
+    }
+};
+
+// Helper: scan `text` with a policy and the given limits
+template <typename Policy>
+static CollectLines scanText(const std::string& text, const Policy& policy, cgrep::ScanLimits limits = {})
+{
+    std::istringstream in(text);
+    cgrep::ScanBuffer buffer;
+    CollectLines lines;
+    cgrep::scanStream(in, policy, lines, buffer, limits);
+    return lines;
+}
+
+TEST(SearchKernel, LiteralPolicyEmitsMatchingLines)
+{
+    cgrep::LiteralPolicy policy{cgrep::LiteralMatcher("beta")};
+
+    CollectLines lines = scanText("alpha\r\nbeta\ngamma beta", policy);
+    ASSERT_EQ(lines.lines.size(), 2u);
+    EXPECT_EQ(lines.lines[0], (std::pair<size_t, std::string>{ 2, "beta" }));
+    EXPECT_EQ(lines.lines[1], (std::pair<size_t, std::string>{ 3, "gamma beta" }));
+}
+
+TEST(SearchKernel, DispatchesThroughQueryMatcher)
+{
+    const std::string text = "one\nTwo\nthree\nfour\n";
+
+    cgrep::QueryMatcher folded = cgrep::FoldedLiteralPolicy{cgrep::FoldedLiteralMatcher("TWO")};
+    cgrep::QueryMatcher multi = cgrep::MultiLiteralPolicy{cgrep::MultiLiteralMatcher({ "one", "four" })};
+    cgrep::QueryMatcher regex = cgrep::RegexPolicy{std::regex("^t")};
+
+    for (auto [matcher, expected] : { std::pair{ &folded, 1u }, std::pair{ &multi, 2u }, std::pair{ &regex, 1u } })
+    {
+        std::istringstream in(text);
+        cgrep::ScanBuffer buffer;
+        cgrep::CountLines lines;
+        cgrep::scanStream(in, *matcher, lines, buffer);
+        EXPECT_EQ(lines.count, expected);
+    }
+}
+
+TEST(SearchKernel, RegexPolicyFindsLaterHits)
+{
+    cgrep::RegexPolicy policy{std::regex("\\bid=[0-9]+")};
+    std::string line = "id=1 uid=2 id=3";
+
+    size_t length = 0;
+    EXPECT_EQ(policy.find(line, 0, length), 0u);
+    EXPECT_EQ(length, 4u);
+    // \b must see the byte before `from`: "uid=2" does not start a word at "id"
+    EXPECT_EQ(policy.find(line, 1, length), 11u);
+}
+
+TEST(SearchKernel, LongLinesAreSearchedInWindows)
+{
+    // A 10000-byte line through a 64-byte buffer, with the needle straddling
+    // window boundaries wherever it is placed
+    cgrep::LiteralPolicy policy{cgrep::LiteralMatcher("needle")};
+    for (size_t at : { 0u, 30u, 61u, 4000u, 9994u })
+    {
+        std::string line(10000, 'x');
+        line.replace(at, 6, "needle");
+        CollectLines lines = scanText("first\n" + line + "\nneedle after\n", policy,
+                                      cgrep::ScanLimits{64, 16});
+        ASSERT_EQ(lines.details.size(), 2u) << "at=" << at;
+        EXPECT_EQ(lines.details[0].lineNumber, 2u);
+        EXPECT_EQ(lines.details[0].hitOffset, at);
+        EXPECT_EQ(lines.details[0].lineLength, line.size());
+        EXPECT_TRUE(lines.details[0].truncated);
+        EXPECT_EQ(lines.lines[0].second, line.substr(0, 16));
+        EXPECT_EQ(lines.lines[1], (std::pair<size_t, std::string>{ 3, "needle after" }));
+    }
+}
+
+TEST(SearchKernel, TruncatesLinesLongerThanTheLimit)
+{
+    cgrep::LiteralPolicy policy{cgrep::LiteralMatcher("end")};
+    CollectLines lines = scanText("short end\n" + std::string(100, 'a') + " end\r\n", policy,
+                                  cgrep::ScanLimits{4096, 10});
+    ASSERT_EQ(lines.details.size(), 2u);
+    EXPECT_FALSE(lines.details[0].truncated);
+    EXPECT_EQ(lines.lines[0].second, "short end");
+    EXPECT_TRUE(lines.details[1].truncated);
+    EXPECT_EQ(lines.lines[1].second, std::string(10, 'a'));
+    EXPECT_EQ(lines.details[1].lineLength, 104u);
+    EXPECT_EQ(lines.details[1].hitOffset, 101u);
+}
+
+TEST(SearchKernel, RegexAnchorsHoldAcrossWindows)
+{
+    std::string line = "start" + std::string(500, '-') + "finish";
+    cgrep::ScanLimits small{64, 64};
+
+    EXPECT_EQ(scanText(line, cgrep::RegexPolicy{std::regex("^start")}, small).lines.size(), 1u);
+    EXPECT_EQ(scanText(line, cgrep::RegexPolicy{std::regex("finish$")}, small).lines.size(), 1u);
+    // Window edges must not look like line edges
+    EXPECT_EQ(scanText(line, cgrep::RegexPolicy{std::regex("^-")}, small).lines.size(), 0u);
+    EXPECT_EQ(scanText(line, cgrep::RegexPolicy{std::regex("-$")}, small).lines.size(), 0u);
+    EXPECT_EQ(scanText(line, cgrep::RegexPolicy{std::regex("\\b-")}, small).lines.size(), 1u);
+}
+
+TEST(SearchKernel, EndAnchoredHitAtAWindowEdge)
+{
+    // The hit of b$ ends a long line wherever the window edges fall,
+    // including exactly at the end of a window
+    for (const char* pattern : { "b$", "ab$" })
+    {
+        cgrep::BitParallelPolicy policy{*cgrep::BitParallelRegex::compile(*cgrep::parseRegex(pattern))};
+        for (size_t bufferSize : { 64u, 147u })
+        {
+            for (size_t length = 2; length < 4 * bufferSize; ++length)
+            {
+                std::string text = std::string(length - 1, 'a') + "b\n";
+                CollectLines lines = scanText(text, policy, cgrep::ScanLimits{bufferSize, 16});
+                ASSERT_EQ(lines.details.size(), 1u) << pattern << " buffer=" << bufferSize << " length=" << length;
+                EXPECT_EQ(lines.details[0].hitOffset, length - std::string_view(pattern).size() + 1);
+            }
+        }
+    }
+}
+
+TEST(SearchKernel, SmallBufferAgreesWithLargeBuffer)
+{
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> letter(0, 3);
+    std::uniform_int_distribution<int> lineLength(0, 300);
+
+    std::string text;
+    for (int i = 0; i < 200; ++i)
+    {
+        int n = lineLength(rng);
+        for (int j = 0; j < n; ++j)
+        {
+            text += static_cast<char>('a' + letter(rng));
+        }
+        text += '\n';
+    }
+
+    cgrep::QueryMatcher multi = cgrep::MultiLiteralPolicy{cgrep::MultiLiteralMatcher({ "abcd", "dddd", "cab" })};
+    cgrep::QueryMatcher regex = cgrep::RegexPolicy{std::regex("ab+c|d+")};
+    for (const auto* policy : { &multi, &regex })
+    {
+        CollectLines reference = scanText(text, *policy);
+        for (size_t bufferSize : { 64u, 100u, 257u })
+        {
+            CollectLines lines = scanText(text, *policy, cgrep::ScanLimits{bufferSize, 1000});
+            ASSERT_EQ(lines.details.size(), reference.details.size()) << "buffer=" << bufferSize;
+            for (size_t i = 0; i < lines.details.size(); ++i)
+            {
+                EXPECT_EQ(lines.details[i].lineNumber, reference.details[i].lineNumber);
+                EXPECT_EQ(lines.details[i].hitOffset, reference.details[i].hitOffset);
+                EXPECT_EQ(lines.details[i].lineLength, reference.details[i].lineLength);
+                EXPECT_EQ(lines.details[i].byteOffset, reference.details[i].byteOffset);
+                EXPECT_EQ(lines.spans[i], reference.spans[i]);
+            }
+        }
+    }
+}
+
+TEST(SearchKernel, CollectsEverySpanAndByteOffset)
+{
+    cgrep::LiteralPolicy policy{cgrep::LiteralMatcher("ab")};
+    CollectLines lines = scanText("xx\r\nab ab xab\nnone\naaab\n", policy);
+    ASSERT_EQ(lines.details.size(), 2u);
+    EXPECT_EQ(lines.details[0].byteOffset, 4u);
+    EXPECT_EQ(lines.spans[0], (std::vector<cgrep::Span>{ { 0, 2 }, { 3, 2 }, { 7, 2 } }));
+    EXPECT_EQ(lines.details[1].byteOffset, 19u);
+    EXPECT_EQ(lines.spans[1], (std::vector<cgrep::Span>{ { 2, 2 } }));
+
+    // Regex spans are non-overlapping and skip empty hits
+    cgrep::RegexPolicy regex{std::regex("[0-9]*")};
+    CollectLines numbers = scanText("a12b3\n", regex);
+    ASSERT_EQ(numbers.details.size(), 1u);
+    EXPECT_EQ(numbers.spans[0], (std::vector<cgrep::Span>{ { 1, 2 }, { 4, 1 } }));
+}
+
+TEST(SearchKernel, CountingSkipsSpans)
+{
+    // A policy without kCollectSpans gets no spans
+    struct FirstHitOnly
+    {
+        size_t spans = 0;
+        void onMatch(const cgrep::MatchedLine& line) { spans += line.spans.size(); }
+    };
+    std::istringstream in("ab ab ab\n");
+    cgrep::ScanBuffer buffer;
+    FirstHitOnly lines;
+    cgrep::scanStream(in, cgrep::LiteralPolicy{cgrep::LiteralMatcher("ab")}, lines, buffer);
+    EXPECT_EQ(lines.spans, 0u);
+}
+
+TEST(SearchKernel, WriteHitsEmitsOnlyTheMatchedText)
+{
+    std::string out;
+    cgrep::WriteHits lines{"log.txt", out};
+    std::istringstream in("id=7 id=42\nnone\nx id=1\n");
+    cgrep::ScanBuffer buffer;
+    cgrep::scanStream(in, cgrep::RegexPolicy{std::regex("id=[0-9]+")}, lines, buffer);
+    EXPECT_EQ(lines.hits, 3u);
+    EXPECT_EQ(out, "log.txt:1:id=7\nlog.txt:1:id=42\nlog.txt:3:id=1\n");
+}
+
+// Helper: line policy that records the lines of inverted scans
+struct CollectBlocks
+{
+    std::vector<std::pair<size_t, std::string>> lines;
+    std::string raw;
+    size_t blocks = 0;
+
+    void onMatch(const cgrep::MatchedLine& line)
+    {
+        lines.emplace_back(line.lineNumber, std::string(line.text));
+    }
+
+    void onLines(const cgrep::LineBlock& block)
+    {
+        ++blocks;
+        raw += block.text;
+        size_t lineNumber = block.firstLineNumber;
+        for (size_t start = 0; start < block.text.size(); ++lineNumber)
+        {
+            size_t end = std::min(block.text.find('\n', start), block.text.size());
+            std::string line(block.text.substr(start, end - start));
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            lines.emplace_back(lineNumber, line);
+            start = end + 1;
+        }
+    }
+};
+
+TEST(SearchKernel, InvertedScanHandsOverRunsOfLines)
+{
+    std::istringstream in("a\r\nb\nnoise 1\nc\nd\nnoise 2\ne");
+    cgrep::ScanBuffer buffer;
+    CollectBlocks lines;
+    cgrep::scanStreamInverted(in, cgrep::LiteralPolicy{cgrep::LiteralMatcher("noise")}, lines, buffer);
+    EXPECT_EQ(lines.blocks, 3u);
+    EXPECT_EQ(lines.raw, "a\r\nb\nc\nd\ne");
+    EXPECT_EQ(lines.lines, (std::vector<std::pair<size_t, std::string>>{
+                               { 1, "a" }, { 2, "b" }, { 4, "c" }, { 5, "d" }, { 7, "e" } }));
+}
+
+TEST(SearchKernel, InvertedScanIsTheComplementOfTheScan)
+{
+    std::mt19937 rng(77);
+    std::uniform_int_distribution<int> letter(0, 4);
+    std::uniform_int_distribution<int> lineLength(0, 120);
+    std::string text;
+    for (int i = 0; i < 300; ++i)
+    {
+        int n = lineLength(rng);
+        for (int j = 0; j < n; ++j)
+        {
+            text += static_cast<char>('a' + letter(rng));
+        }
+        text += '\n';
+    }
+
+    cgrep::QueryMatcher literal = cgrep::LiteralPolicy{cgrep::LiteralMatcher("abc")};
+    cgrep::QueryMatcher regex = cgrep::RegexPolicy{std::regex("e{3}")};
+    for (const auto* policy : { &literal, &regex })
+    {
+        for (size_t bufferSize : { 64u, 1000u, 1u << 20 })
+        {
+            cgrep::ScanLimits limits{bufferSize, 1u << 20};
+            cgrep::ScanBuffer buffer;
+
+            std::istringstream matchingIn(text);
+            CollectLines matching;
+            cgrep::scanStream(matchingIn, *policy, matching, buffer, limits);
+
+            std::istringstream invertedIn(text);
+            CollectBlocks inverted;
+            cgrep::scanStreamInverted(invertedIn, *policy, inverted, buffer, limits);
+
+            std::vector<size_t> all;
+            for (const auto& line : matching.lines)
+            {
+                all.push_back(line.first);
+            }
+            for (const auto& line : inverted.lines)
+            {
+                all.push_back(line.first);
+            }
+            std::sort(all.begin(), all.end());
+            ASSERT_EQ(all.size(), 300u) << "buffer=" << bufferSize;
+            for (size_t i = 0; i < all.size(); ++i)
+            {
+                ASSERT_EQ(all[i], i + 1) << "buffer=" << bufferSize;
+            }
+        }
+    }
+}
+
+TEST(SearchKernel, BoundedPolicyChecksWordAndLineBoundaries)
+{
+    using WordLiteral = cgrep::BoundedPolicy<cgrep::LiteralPolicy, cgrep::Boundary::Word>;
+    using LineLiteral = cgrep::BoundedPolicy<cgrep::LiteralPolicy, cgrep::Boundary::Line>;
+    WordLiteral word{cgrep::LiteralPolicy{cgrep::LiteralMatcher("id")}};
+    LineLiteral line{cgrep::LiteralPolicy{cgrep::LiteralMatcher("id")}};
+
+    size_t length = 0;
+    EXPECT_EQ(word.find("uid idx id_ (id)", 0, length), 13u);
+    EXPECT_EQ(word.find("id", 0, length), 0u);
+    EXPECT_EQ(word.find("idé id", 0, length), 5u); // UTF-8 letters are word bytes
+    // The line continues past the window, so the end of the text is no boundary
+    EXPECT_EQ(word.find("x id", 0, length, cgrep::FindContext{true}), std::string_view::npos);
+
+    EXPECT_EQ(line.find("id", 0, length), 0u);
+    EXPECT_EQ(line.find("id ", 0, length), std::string_view::npos);
+    EXPECT_EQ(line.find("xid\nid\r\nid", 0, length), 4u);
+    EXPECT_EQ(line.find("xid\nid x\nid", 0, length), 9u);
+}
+
+TEST(SearchKernel, BoundedPolicyAcrossBlocksAndWindows)
+{
+    using WordLiteral = cgrep::BoundedPolicy<cgrep::LiteralPolicy, cgrep::Boundary::Word>;
+    using LineMulti = cgrep::BoundedPolicy<cgrep::MultiLiteralPolicy, cgrep::Boundary::Line>;
+    WordLiteral word{cgrep::LiteralPolicy{cgrep::LiteralMatcher("key")}};
+    LineMulti line{cgrep::MultiLiteralPolicy{cgrep::MultiLiteralMatcher({ "ok", "done" })}};
+
+    // Word hits on a line longer than the buffer, next to window edges
+    std::string longLine(200, 'x');
+    longLine.replace(60, 5, " key ");
+    longLine.replace(120, 4, "keys");
+    CollectLines words = scanText(longLine + "\nkey\n", word, cgrep::ScanLimits{64, 64});
+    ASSERT_EQ(words.details.size(), 2u);
+    EXPECT_EQ(words.spans[0], (std::vector<cgrep::Span>{ { 61, 3 } }));
+    EXPECT_EQ(words.details[1].lineNumber, 2u);
+
+    // Whole-line hits through the inverted block scan, with CRLF lines
+    std::istringstream in("ok\r\nnot ok\r\ndone\r\ndone.\r\n");
+    cgrep::ScanBuffer buffer;
+    CollectBlocks inverted;
+    cgrep::scanStreamInverted(in, line, inverted, buffer);
+    EXPECT_EQ(inverted.lines, (std::vector<std::pair<size_t, std::string>>{ { 2, "not ok" }, { 4, "done." } }));
+}
+
+TEST(SearchKernel, StepBudgetAbortsTheScan)
+{
+    // Polynomial backtracking that the nested quantifier check does not catch
+    cgrep::RegexPolicy policy{std::regex("(a|aa)*c")};
+    std::string text = "ac\n" + std::string(40, 'a') + "\nac\n";
+
+    std::istringstream in(text);
+    cgrep::ScanBuffer buffer;
+    CollectLines lines;
+    cgrep::ScanLimits limits;
+    limits.stepBudget = 100000;
+    EXPECT_THROW(cgrep::scanStream(in, policy, lines, buffer, limits), cgrep::SearchBudgetExceeded);
+    // Lines before the expensive one were handed over
+    ASSERT_EQ(lines.lines.size(), 1u);
+    EXPECT_EQ(lines.lines[0].first, 1u);
+
+    // A generous budget does not change the result
+    std::istringstream again("ac\nbc\nac\n");
+    CollectLines all;
+    limits.stepBudget = 1000;
+    cgrep::scanStream(again, policy, all, buffer, limits);
+    EXPECT_EQ(all.lines.size(), 3u);
+}
+
+TEST(SearchKernel, StopRequestEndsTheScan)
+{
+    // Helper: line policy that asks for a stop on its first line
+    struct StopOnFirstLine : CollectLines
+    {
+        std::stop_source* source = nullptr;
+
+        void onMatch(const cgrep::MatchedLine& line)
+        {
+            CollectLines::onMatch(line);
+            source->request_stop();
+        }
+    };
+
+    std::string text;
+    for (int i = 0; i < 10000; ++i)
+    {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    cgrep::LiteralPolicy policy{cgrep::LiteralMatcher("line")};
+
+    // The lines of the buffer being searched are still handed over, but no
+    // further buffer is read
+    std::stop_source source;
+    cgrep::ScanLimits limits;
+    limits.bufferSize = 4096;
+    limits.stop = source.get_token();
+    std::istringstream in(text);
+    cgrep::ScanBuffer buffer;
+    StopOnFirstLine lines;
+    lines.source = &source;
+    cgrep::scanStream(in, policy, lines, buffer, limits);
+    EXPECT_FALSE(lines.lines.empty());
+    EXPECT_LT(lines.lines.size(), 1000u);
+
+    // A stop requested before the scan reads nothing
+    EXPECT_TRUE(scanText(text, policy, limits).lines.empty());
+}
+
+TEST(SearchKernel, LiteralPrefilterAgreesWithTheEngine)
+{
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<int> pick(0, 9);
+    for (std::string pattern : { "\\w+@example\\.com", "[a-c]*ab[a-c]?", "(a|b)+cab", "x.?yz", "\\bab\\w{0,2}c" })
+    {
+        auto tree = cgrep::parseRegex(pattern);
+        ASSERT_TRUE(tree.has_value()) << pattern;
+        auto required = cgrep::findRequiredLiteral(*tree);
+        ASSERT_FALSE(required.bytes.empty()) << pattern;
+        cgrep::PikeVMPolicy plain{*cgrep::PikeVM::compile(*tree)};
+        cgrep::PikeVMPolicy filtered{*cgrep::PikeVM::compile(*tree), 0, {}, cgrep::LiteralPrefilter(required)};
+        auto bitParallel = cgrep::BitParallelRegex::compile(*tree); // none for \b
+
+        for (int round = 0; round < 200; ++round)
+        {
+            // A block of several lines, as searched in invert mode
+            std::string text(40, ' ');
+            for (auto& c : text)
+            {
+                c = "abcxyz@.\n "[pick(rng)];
+            }
+            if (round % 4 == 0)
+            {
+                text.replace(static_cast<size_t>(pick(rng)), 12, "me@example.com");
+            }
+            auto allHits = [&](const auto& policy)
+            {
+                std::vector<std::pair<size_t, size_t>> hits;
+                size_t length = 0;
+                for (size_t from = 0; from <= text.size();)
+                {
+                    size_t hit = policy.find(text, from, length);
+                    if (hit == std::string::npos)
+                    {
+                        break;
+                    }
+                    hits.emplace_back(hit, length);
+                    from = hit + std::max<size_t>(length, 1);
+                }
+                return hits;
+            };
+            ASSERT_EQ(allHits(filtered), allHits(plain)) << "pattern=" << pattern << " text=" << text;
+            if (bitParallel)
+            {
+                cgrep::BitParallelPolicy bitPlain{*bitParallel};
+                cgrep::BitParallelPolicy bitFiltered{*bitParallel, {}, cgrep::LiteralPrefilter(required)};
+                ASSERT_EQ(allHits(bitFiltered), allHits(bitPlain)) << "pattern=" << pattern << " text=" << text;
+            }
+        }
+    }
+}
+
+// Helper: matcher policy that hides that its hits stay in a line, so the
+// scan searches line by line
+template <typename Policy>
+struct LineByLine
+{
+    Policy policy;
+
+    size_t find(std::string_view text, size_t from, size_t& length, const cgrep::FindContext& context = {}) const
+    {
+        return policy.find(text, from, length, context);
+    }
+    size_t maxMatchLength() const { return policy.maxMatchLength(); }
+    bool hitsStayInLine() const { return false; }
+};
+
+TEST(SearchKernel, BlockSearchAgreesWithLineByLine)
+{
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> pick(0, 7);
+    std::string text;
+    for (int i = 0; i < 400; ++i)
+    {
+        int n = pick(rng) * 3;
+        for (int j = 0; j < n; ++j)
+        {
+            text += "ab xy\r"[pick(rng) % 6];
+        }
+        text += i % 3 == 0 ? "\r\n" : "\n";
+    }
+    text += "ab y"; // no trailing newline
+
+    auto check = [&](const auto& policy)
+    {
+        using Policy = std::decay_t<decltype(policy)>;
+        for (size_t bufferSize : { 64u, 1000u, 1u << 20 })
+        {
+            cgrep::ScanLimits limits{bufferSize, 1u << 20};
+            CollectLines blocks = scanText(text, policy, limits);
+            CollectLines lines = scanText(text, LineByLine<Policy>{policy}, limits);
+            ASSERT_EQ(blocks.lines, lines.lines) << "buffer=" << bufferSize;
+            ASSERT_EQ(blocks.spans, lines.spans) << "buffer=" << bufferSize;
+        }
+    };
+    check(cgrep::LiteralPolicy{cgrep::LiteralMatcher("b x")});
+    // Hits of \s take in the '\r' of CRLF line ends, and y* matches empty
+    for (std::string pattern : { "y\\s", "a\\s*$", "y*" })
+    {
+        auto tree = cgrep::parseRegex(pattern);
+        ASSERT_TRUE(tree.has_value()) << pattern;
+        check(cgrep::PikeVMPolicy{*cgrep::PikeVM::compile(*tree)});
+    }
+    check(cgrep::BitParallelPolicy{*cgrep::BitParallelRegex::compile(*cgrep::parseRegex("x[ab]+"))});
+}
+
+TEST(SearchKernel, FileInputReadsLikeAStream)
+{
+    auto path = std::filesystem::temp_directory_path() / "custom_grep_test_file_input.txt";
+    std::string text;
+    for (int i = 0; i < 5000; ++i)
+    {
+        text += (i % 7 == 0 ? "needle " : "hay ") + std::to_string(i) + "\n";
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    }
+
+    cgrep::LiteralPolicy policy{cgrep::LiteralMatcher("needle")};
+    for (size_t bufferSize : { 64u, 1u << 20 })
+    {
+        cgrep::ScanLimits limits{bufferSize, 1u << 20};
+        cgrep::FileInput input(path);
+        ASSERT_TRUE(input.isOpen());
+        cgrep::ScanBuffer buffer;
+        CollectLines fromFile;
+        cgrep::scanStream(input, policy, fromFile, buffer, limits);
+        EXPECT_EQ(fromFile.lines, scanText(text, policy, limits).lines) << "buffer=" << bufferSize;
+    }
+
+    // Bytes appended after opening are read too
+    {
+        cgrep::FileInput input(path);
+        ASSERT_TRUE(input.isOpen());
+        EXPECT_EQ(input.sizeHint(), text.size());
+        std::ofstream(path, std::ios::binary | std::ios::app) << "needle appended\n";
+        cgrep::ScanBuffer buffer;
+        CollectLines grown;
+        cgrep::scanStream(input, policy, grown, buffer);
+        ASSERT_FALSE(grown.lines.empty());
+        EXPECT_EQ(grown.lines.back().second, "needle appended");
+    }
+    std::filesystem::remove(path);
+
+    // procfs files report size 0
+    if (std::filesystem::exists("/proc/self/status"))
+    {
+        cgrep::FileInput status("/proc/self/status");
+        ASSERT_TRUE(status.isOpen());
+        cgrep::ScanBuffer buffer;
+        CollectLines lines;
+        cgrep::scanStream(status, cgrep::LiteralPolicy{cgrep::LiteralMatcher("Name:")}, lines, buffer);
+        EXPECT_EQ(lines.lines.size(), 1u);
+    }
+
+    cgrep::FileInput missing(path);
+    EXPECT_FALSE(missing.isOpen());
+    EXPECT_EQ(missing.error(), std::errc::no_such_file_or_directory);
+}
@@ -0,0 +1,87 @@
+#include "FileCollector.h"
+#include "SearchSession.h"
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Helper: write a file with the given lines (one per line)
+static void writeFile(const fs::path& path, const std::vector<std::string>& lines)
+{
+    std::ofstream ofs(path);
+    for (auto const& l : lines)
+    {
+        ofs << l << "\n";
+    }
+}
+
+TEST(SearchSession, AgreesWithCustomGrep)
+{
+    auto base = fs::temp_directory_path() / "custom_grep_test_session";
+    fs::remove_all(base);
+    fs::create_directories(base);
+    writeFile(base / "a.txt", { "Error: disk full", "ok", "error again" });
+    writeFile(base / "b.txt", { "no problem", "ERROR 42" });
+    std::vector<fs::path> files = { base / "a.txt", base / "b.txt" };
+
+    cgrep::SearchOptions options;
+    options.regexSearch = true;
+    options.ignoreCase = true;
+    cgrep::CustomGrep grep(options);
+    auto expected = grep.parallelSearch(files, "error[: ]");
+
+    // Repeated searches reuse the compiled query and the scan buffers
+    cgrep::SearchSession session("error[: ]", options);
+    EXPECT_EQ(session.compiled().pattern(), "error[: ]");
+    for (int round = 0; round < 3; ++round)
+    {
+        auto found = session.parallelSearch(files);
+        ASSERT_EQ(found.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            EXPECT_EQ(found[i].path, expected[i].path);
+            EXPECT_EQ(found[i].line_number, expected[i].line_number);
+        }
+        EXPECT_EQ(session.searchInFile(base / "a.txt").size(), 2u);
+        EXPECT_EQ(session.countInFile(base / "b.txt"), 1u);
+    }
+    EXPECT_EQ(session.parallelSearch(cgrep::FileCollector::collectFileTable(base)).size(), expected.size());
+
+    // A compiled query is shared by sessions and CustomGreps alike
+    cgrep::CompiledQuery query = grep.compile("error");
+    cgrep::SearchSession other(query, options);
+    EXPECT_EQ(other.parallelSearch(files).size(), 3u);
+    EXPECT_EQ(grep.parallelSearch(files, query).size(), 3u);
+    EXPECT_EQ(grep.searchInFile(base / "a.txt", query).size(), 2u);
+    EXPECT_EQ(grep.countInFile(base / "b.txt", query), 1u);
+
+    fs::remove_all(base);
+}
+
+TEST(SearchSession, RejectsQueriesCompiledForOtherOptions)
+{
+    cgrep::SearchOptions caseless;
+    caseless.ignoreCase = true;
+    cgrep::CompiledQuery query = cgrep::CustomGrep(caseless).compile("needle");
+    EXPECT_TRUE(query.matchesLike(caseless));
+
+    // Options that only affect how files are read do not matter
+    cgrep::SearchOptions reading = caseless;
+    reading.bufferSize = 4096;
+    reading.invertMatch = true;
+    EXPECT_TRUE(query.matchesLike(reading));
+
+    cgrep::SearchOptions exact;
+    EXPECT_FALSE(query.matchesLike(exact));
+    EXPECT_THROW(static_cast<void>(cgrep::CustomGrep(exact).countInFile("missing.txt", query)), std::invalid_argument);
+    EXPECT_THROW(cgrep::SearchSession(query, exact), std::invalid_argument);
+
+    cgrep::SearchOptions regex;
+    regex.regexSearch = true;
+    EXPECT_THROW(cgrep::SearchSession("(a+)+(?!x)$", regex), std::invalid_argument);
+}